@@ -0,0 +1,239 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/file.h>
+#include "affinity.h"
+
+/* Where the kernel describes the machine's NUMA nodes and caches */
+#define NODE_CPU_LIST_PATH "/sys/devices/system/node/node%d/cpulist"
+#define L3_CPU_LIST_PATH \
+        "/sys/devices/system/cpu/cpu%d/cache/index3/shared_cpu_list"
+#define SYSFS_PATH_LENGTH 128
+#define CPU_LIST_LENGTH 4096
+
+/* The most NUMA nodes and core sets considered */
+#define MAX_NUMA_NODES 64
+#define MAX_CORE_SETS 256
+
+/* The number of bytes of the shared slot counter */
+#define PIN_COUNTER_LENGTH sizeof(unsigned long long)
+
+/**
+* A struct for a set of cores a hub and its players may be pinned to.
+*   - cores, the cores
+*   - node, the NUMA node the cores belong to
+*   - rank, the number of sets of the same node listed before this one
+*/
+typedef struct {
+    cpu_set_t cores;
+    int node;
+    int rank;
+} CoreSet;
+
+/**
+* Reads a list of cores in the kernel's format, such as "0-3,8,10-11".
+* Returns false if the file cannot be read.
+*   - path, the file holding the list
+*   - cores, where to store the cores
+*/
+bool read_cpu_list(const char* path, cpu_set_t* cores) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+    char text[CPU_LIST_LENGTH];
+    bool read = fgets(text, CPU_LIST_LENGTH, file) != NULL;
+    fclose(file);
+    CPU_ZERO(cores);
+    char* position = text;
+    while (read && *position != '\0' && *position != '\n') {
+        char* end;
+        long first = strtol(position, &end, 10);
+        long last = first;
+        if (end == position) {
+            return false;
+        }
+        if (*end == '-') {
+            position = end + 1;
+            last = strtol(position, &end, 10);
+        }
+        for (long core = first; core <= last && core < CPU_SETSIZE; core++) {
+            CPU_SET(core, cores);
+        }
+        position = *end == ',' ? end + 1 : end;
+    }
+    return read;
+}
+
+/**
+* Returns the number of non-empty NUMA nodes among the allowed cores, storing
+* their cores. Without NUMA information every allowed core is one node.
+*   - allowed, the cores this process may run on
+*   - nodes, where to store each node's cores, MAX_NUMA_NODES in size
+*/
+int read_numa_nodes(const cpu_set_t* allowed, cpu_set_t* nodes) {
+    int numberOfNodes = 0;
+    for (int node = 0; node < MAX_NUMA_NODES; node++) {
+        char path[SYSFS_PATH_LENGTH];
+        sprintf(path, NODE_CPU_LIST_PATH, node);
+        if (!read_cpu_list(path, &nodes[numberOfNodes])) {
+            continue;
+        }
+        CPU_AND(&nodes[numberOfNodes], &nodes[numberOfNodes], allowed);
+        if (CPU_COUNT(&nodes[numberOfNodes]) > 0) {
+            numberOfNodes++;
+        }
+    }
+    if (numberOfNodes == 0) {
+        nodes[numberOfNodes++] = *allowed;
+    }
+    return numberOfNodes;
+}
+
+/**
+* Adds a set of cores to the sets, split into sets of the specified size if
+* it is positive. Returns the new number of sets.
+*   - sets, the sets, MAX_CORE_SETS in size
+*   - numberOfSets, the number of sets so far
+*   - cores, the cores to add
+*   - node, the NUMA node of the cores
+*   - setSize, the number of cores in each set, or 0 for one set
+*/
+int add_core_sets(CoreSet* sets, int numberOfSets, const cpu_set_t* cores,
+        int node, int setSize) {
+    int rank = 0;
+    for (int i = 0; i < numberOfSets; i++) {
+        rank += sets[i].node == node;
+    }
+    int inSet = 0;
+    for (int core = 0; core < CPU_SETSIZE; core++) {
+        if (!CPU_ISSET(core, cores)) {
+            continue;
+        }
+        if (inSet == 0) {
+            if (numberOfSets == MAX_CORE_SETS) {
+                return numberOfSets;
+            }
+            CPU_ZERO(&sets[numberOfSets].cores);
+            sets[numberOfSets].node = node;
+            sets[numberOfSets].rank = rank++;
+            numberOfSets++;
+        }
+        CPU_SET(core, &sets[numberOfSets - 1].cores);
+        inSet++;
+        if (inSet == setSize) {
+            inSet = 0;
+        }
+    }
+    return numberOfSets;
+}
+
+/**
+* Divides the cores this process may run on into the sets to pin to, listed
+* so consecutive sets belong to different NUMA nodes in turn. Returns the
+* number of sets.
+*   - setting, PIN_L3, PIN_NODE or a number of cores
+*   - sets, where to store the sets, MAX_CORE_SETS in size
+*/
+int find_core_sets(const char* setting, CoreSet* sets) {
+    bool wholeNodes = strcmp(setting, PIN_NODE) == 0;
+    int setSize = 0;
+    if (!wholeNodes && strcmp(setting, PIN_L3) != 0) {
+        setSize = atoi(setting);
+        if (setSize <= 0) {
+            return 0;
+        }
+    }
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return 0;
+    }
+    static cpu_set_t nodes[MAX_NUMA_NODES];
+    int numberOfNodes = read_numa_nodes(&allowed, nodes);
+    static CoreSet found[MAX_CORE_SETS];
+    int numberFound = 0;
+    for (int node = 0; node < numberOfNodes; node++) {
+        cpu_set_t remaining = nodes[node];
+        for (int core = 0; core < CPU_SETSIZE; core++) {
+            if (!CPU_ISSET(core, &remaining)) {
+                continue;
+            }
+            cpu_set_t domain;
+            char path[SYSFS_PATH_LENGTH];
+            sprintf(path, L3_CPU_LIST_PATH, core);
+            if (wholeNodes || !read_cpu_list(path, &domain)) {
+                domain = remaining;
+            }
+            CPU_AND(&domain, &domain, &remaining);
+            CPU_SET(core, &domain);
+            CPU_XOR(&remaining, &remaining, &domain);
+            numberFound = add_core_sets(found, numberFound, &domain, node,
+                    setSize);
+        }
+    }
+    int numberOfSets = 0;
+    for (int rank = 0; numberOfSets < numberFound; rank++) {
+        for (int i = 0; i < numberFound; i++) {
+            if (found[i].rank == rank) {
+                sets[numberOfSets++] = found[i];
+            }
+        }
+    }
+    return numberOfSets;
+}
+
+/**
+* Returns the number of the set to pin to: PIN_SLOT_VARIABLE if it is set,
+* otherwise the next value of the counter every hub on the machine shares,
+* or 0 if it cannot be used.
+*/
+unsigned long long claim_pin_slot(void) {
+    char* slotSetting = getenv(PIN_SLOT_VARIABLE);
+    if (slotSetting != NULL && *slotSetting != '\0') {
+        return strtoull(slotSetting, NULL, 10);
+    }
+    int fd = open(PIN_COUNTER_PATH, O_RDWR | O_CREAT | O_CLOEXEC,
+            PIN_COUNTER_MODE);
+    if (fd < 0) {
+        return 0;
+    }
+    unsigned long long slot = 0;
+    if (flock(fd, LOCK_EX) == 0) {
+        if (pread(fd, &slot, PIN_COUNTER_LENGTH, 0) != PIN_COUNTER_LENGTH) {
+            slot = 0;
+        }
+        unsigned long long next = slot + 1;
+        if (pwrite(fd, &next, PIN_COUNTER_LENGTH, 0) != PIN_COUNTER_LENGTH) {
+            slot = 0;
+        }
+        flock(fd, LOCK_UN);
+    }
+    close(fd);
+    return slot;
+}
+
+/**
+* Pins the calling thread, and so the threads and processes it starts later,
+* to the next set of cores as PIN_VARIABLE asks, so a hub and its players
+* pass messages through a shared cache. Memory the process touches from then
+* on is placed on the set's NUMA node. Returns true if the thread was
+* pinned, or false if pinning is not enabled or not possible.
+*/
+bool pin_to_core_set(void) {
+    char* setting = getenv(PIN_VARIABLE);
+    if (setting == NULL || *setting == '\0') {
+        return false;
+    }
+    static CoreSet sets[MAX_CORE_SETS];
+    int numberOfSets = find_core_sets(setting, sets);
+    if (numberOfSets == 0) {
+        return false;
+    }
+    CoreSet* set = &sets[claim_pin_slot() % numberOfSets];
+    return sched_setaffinity(0, sizeof(set->cores), &set->cores) == 0;
+}
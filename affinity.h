@@ -0,0 +1,22 @@
+#include <stdbool.h>
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+/* A hub pins itself, and so every player it starts, to one set of cores
+when this variable is set: "l3" for the cores sharing a last level cache,
+"node" for a NUMA node, or a number of cores from within a last level cache */
+#define PIN_VARIABLE "STLUCIA_PIN"
+#define PIN_L3 "l3"
+#define PIN_NODE "node"
+
+/* The set to pin to, counted round robin across the NUMA nodes. Unless this
+variable chooses one, each hub takes the next from a counter shared by every
+process on the machine */
+#define PIN_SLOT_VARIABLE "STLUCIA_PIN_SLOT"
+#define PIN_COUNTER_PATH "/dev/shm/stlucia-pin"
+#define PIN_COUNTER_MODE 0666
+
+/* Function prototypes */
+bool pin_to_core_set(void);
+#endif
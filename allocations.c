@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "allocations.h"
+
+/* The allocator underneath, which these wrappers count calls to */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* pointer);
+
+#define MAX_ALLOCATION_REPORT_LENGTH 256
+
+/* The name of each phase in the report */
+const char* phaseNames[NUMBER_OF_PHASES] = {"setup", "turns", "growth",
+        "exit"};
+
+/* The number and total size of the allocations made in each phase */
+unsigned long allocationCounts[NUMBER_OF_PHASES];
+unsigned long allocationBytes[NUMBER_OF_PHASES];
+
+/* The phase of the calling thread. Threads of hosted players never leave
+setup, so they do not count against the hub's turns. */
+__thread AllocationPhase allocationPhase = PHASE_SETUP;
+
+/**
+* Sets the phase the calling thread's allocations are counted in. Returns
+* the previous phase, so a nested phase can be left again.
+*   - phase, the new phase
+*/
+AllocationPhase set_allocation_phase(AllocationPhase phase) {
+    AllocationPhase previous = allocationPhase;
+    allocationPhase = phase;
+    return previous;
+}
+
+/**
+* Counts an allocation in the calling thread's phase. An allocation while
+* turns are played breaks the guarantee that a turn allocates nothing, so
+* the program is aborted where the allocation was made. Only write() is used
+* here, as stdio may itself be allocating.
+*   - size, the size of the allocation
+*/
+void count_allocation(size_t size) {
+    __atomic_fetch_add(&allocationCounts[allocationPhase], 1,
+            __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocationBytes[allocationPhase], size,
+            __ATOMIC_RELAXED);
+    if (allocationPhase == PHASE_TURNS) {
+        static const char message[] = "Allocation during turns\n";
+        if (write(STDERR_FILENO, message, sizeof(message) - 1)) {
+        }
+        abort();
+    }
+}
+
+/**
+* Prints the number and total size of the allocations made in each phase
+* to stderr.
+*/
+void report_allocations(void) {
+    char report[MAX_ALLOCATION_REPORT_LENGTH];
+    int length = snprintf(report, sizeof(report), "Allocations");
+    for (int i = 0; i < NUMBER_OF_PHASES; i++) {
+        length += snprintf(report + length, sizeof(report) - length,
+                "%s %s %lu (%lu bytes)", i == 0 ? "" : ",", phaseNames[i],
+                __atomic_load_n(&allocationCounts[i], __ATOMIC_SEQ_CST),
+                __atomic_load_n(&allocationBytes[i], __ATOMIC_SEQ_CST));
+    }
+    fprintf(stderr, "%s\n", report);
+}
+
+void* malloc(size_t size) {
+    count_allocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    count_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    count_allocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size) {
+    void* allocation = memalign(alignment, size);
+    if (allocation == NULL) {
+        return ENOMEM;
+    }
+    *pointer = allocation;
+    return 0;
+}
+
+void free(void* pointer) {
+    __libc_free(pointer);
+}
@@ -0,0 +1,32 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+/**
+* An enum for the phases of a program that allocations are counted in.
+*   - PHASE_SETUP, starting up, before the first turn
+*   - PHASE_TURNS, playing turns, where nothing may be allocated
+*   - PHASE_GROWTH, growing a table whose size doubles, so it is allocated
+*       a logarithmic number of times however long the game
+*   - PHASE_EXIT, shutting down
+*/
+typedef enum {
+    PHASE_SETUP,
+    PHASE_TURNS,
+    PHASE_GROWTH,
+    PHASE_EXIT,
+    NUMBER_OF_PHASES
+} AllocationPhase;
+
+/* Allocations are only counted in builds with -DSTLUCIA_ALLOCATIONS, which
+link allocations.c. Other builds pay nothing. */
+#ifdef STLUCIA_ALLOCATIONS
+AllocationPhase set_allocation_phase(AllocationPhase phase);
+void report_allocations(void);
+#else
+static inline AllocationPhase set_allocation_phase(AllocationPhase phase) {
+    return phase;
+}
+static inline void report_allocations(void) {
+}
+#endif
+#endif
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "shared.h"
+#include "lockstep.h"
+
+/* Argument information for the batch simulator */
+#define BATCH_MIN_ARGS 6
+#define BATCH_MAX_ARGS 30
+#define BATCH_ARGUMENTS_NOT_PLAYERS 4
+#define BATCH_ROLL_FILE_ARGUMENT_INDEX 1
+#define BATCH_SCORE_LIMIT_ARGUMENT_INDEX 2
+#define BATCH_GAMES_ARGUMENT_INDEX 3
+
+/* The most games advanced in lockstep at once */
+#define BATCH_MAX_LANES 4096
+
+/* Games still running after this many turns are drawn */
+#define BATCH_MAX_TURNS 100000
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, normal exit after all games are played
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - INVALID_SCORE, winscore is not a positive integer
+*   - OPEN_ERROR, unable to open rolls file for reading
+*   - INVALID_FILE, contents of the rolls file are invalid
+*   - INVALID_GAMES, the number of games is not a positive integer
+*   - INVALID_FACULTY, a faculty is not one the engine can play
+*   - MEMORY_FAILURE, the game state could not be allocated
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    INVALID_SCORE = 2,
+    OPEN_ERROR = 3,
+    INVALID_FILE = 4,
+    INVALID_GAMES = 5,
+    INVALID_FACULTY = 6,
+    MEMORY_FAILURE = 7
+} ExitCodes;
+
+/**
+* Exits the program, with the specified exit status and a message.
+*   - exitStatus, the status to exit with
+*/
+void exit_program(ExitCodes exitStatus) {
+    char* errorString = "";
+    switch (exitStatus) {
+        case SUCCESS:
+            errorString = "";
+            break;
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-batch rollfile winscore games "
+                    "faculty1 faculty2 [faculty3 ...]\n";
+            break;
+        case INVALID_SCORE:
+            errorString = "Invalid score\n";
+            break;
+        case OPEN_ERROR:
+            errorString = "Unable to access rollfile\n";
+            break;
+        case INVALID_FILE:
+            errorString = "Error reading rolls\n";
+            break;
+        case INVALID_GAMES:
+            errorString = "Invalid number of games\n";
+            break;
+        case INVALID_FACULTY:
+            errorString = "Unknown faculty\n";
+            break;
+        case MEMORY_FAILURE:
+            errorString = "Unable to allocate games\n";
+            break;
+    }
+    fprintf(stderr, "%s", errorString);
+    exit((int)exitStatus);
+}
+
+/**
+* Returns the current monotonic time in seconds.
+*/
+double current_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+int main(int argc, char** argv) {
+    if (argc < BATCH_MIN_ARGS || argc > BATCH_MAX_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    int scoreLimit = atoi(argv[BATCH_SCORE_LIMIT_ARGUMENT_INDEX]);
+    if (scoreLimit <= 0) {
+        exit_program(INVALID_SCORE);
+    }
+    int games = atoi(argv[BATCH_GAMES_ARGUMENT_INDEX]);
+    if (games <= 0) {
+        exit_program(INVALID_GAMES);
+    }
+    int numberOfPlayers = argc - BATCH_ARGUMENTS_NOT_PLAYERS;
+
+    char* diceRolls;
+    int size = read_roll_file(argv[BATCH_ROLL_FILE_ARGUMENT_INDEX],
+            &diceRolls);
+    if (size < 0) {
+        exit_program(OPEN_ERROR);
+    } else if (size == 0) {
+        exit_program(INVALID_FILE);
+    }
+
+    int lanes = (games < BATCH_MAX_LANES) ? games : BATCH_MAX_LANES;
+    Lockstep lockstep;
+    if (!initialise_lockstep(&lockstep, lanes, numberOfPlayers, scoreLimit,
+            BATCH_MAX_TURNS) ||
+            !load_lockstep_rolls(&lockstep, diceRolls, size)) {
+        exit_program(MEMORY_FAILURE);
+    }
+    free(diceRolls);
+    for (int i = 0; i < numberOfPlayers; i++) {
+        Faculty faculty;
+        if (!lookup_faculty(argv[i + BATCH_ARGUMENTS_NOT_PLAYERS],
+                &faculty)) {
+            exit_program(INVALID_FACULTY);
+        }
+        default_strategy(faculty, &lockstep.strategies[i]);
+    }
+
+    int wins[MAX_PLAYERS] = {0};
+    int draws = 0;
+    long long turns = 0;
+    double start = current_time();
+    for (int first = 0; first < games; first += lanes) {
+        reset_lockstep(&lockstep, first);
+        run_lockstep(&lockstep);
+        int played = (games - first < lanes) ? games - first : lanes;
+        for (int lane = 0; lane < played; lane++) {
+            if (lockstep.winner[lane] == LOCKSTEP_DRAWN) {
+                draws++;
+            } else {
+                wins[lockstep.winner[lane]]++;
+            }
+            turns += lockstep.turns[lane];
+        }
+    }
+    double elapsed = current_time() - start;
+
+    for (int i = 0; i < numberOfPlayers; i++) {
+        printf("Player %c (%s) won %d\n", get_player_label(i),
+                argv[i + BATCH_ARGUMENTS_NOT_PLAYERS], wins[i]);
+    }
+    printf("Drawn %d\n", draws);
+    printf("Played %d games, %lld turns in %.3fs (%.0f games/s)\n", games,
+            turns, elapsed, elapsed > 0 ? games / elapsed : 0.0);
+    free_lockstep(&lockstep);
+    exit_program(SUCCESS);
+    return 0;
+}
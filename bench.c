@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "shared.h"
+
+/* Argument information for the hub benchmark */
+#define BENCH_MIN_ARGS 6
+#define BENCH_MAX_ARGS 8
+#define BENCH_HUB_ARGUMENT_INDEX 1
+#define BENCH_FACULTY_ARGUMENT_INDEX 2
+#define BENCH_ROLL_FILE_ARGUMENT_INDEX 3
+#define BENCH_SCORE_LIMIT_ARGUMENT_INDEX 4
+#define BENCH_GAMES_ARGUMENT_INDEX 5
+#define BENCH_MIN_PLAYERS_ARGUMENT_INDEX 6
+#define BENCH_MAX_PLAYERS_ARGUMENT_INDEX 7
+#define HUB_ARGUMENTS_NOT_PLAYERS 3
+
+/* The load generator appends what each player saw to the file named by this */
+#define REPORT_VARIABLE "STLUCIA_LOAD_REPORT"
+#define MAX_REPORT_PATH_LENGTH 64
+#define BASE_FOR_INTEGER_CONVERSION 10
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+#define MILLISECONDS_PER_SECOND 1000.0
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, normal exit after every game is played
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - INVALID_GAMES, the number of games is not a positive integer
+*   - INVALID_PLAYERS, the player counts are not from 2 to 26 in order
+*   - REPORT_ERROR, the players' report file could not be created
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    INVALID_GAMES = 2,
+    INVALID_PLAYERS = 3,
+    REPORT_ERROR = 4
+} ExitCodes;
+
+/**
+* A struct for the totals of the games played with one number of players.
+*   - games, the number of games played
+*   - failed, the number of games the hub exited from with an error
+*   - seconds, the wall clock time the hub ran for
+*   - turns, the number of turns the players were asked to roll
+*   - stays, the number of times a player was asked to stay
+*   - broadcasts, the number of other messages the players received
+*/
+typedef struct {
+    int games;
+    int failed;
+    double seconds;
+    unsigned long turns;
+    unsigned long stays;
+    unsigned long broadcasts;
+} Totals;
+
+/**
+* Exits the benchmark with the specified exit status. Prints the
+* corresponding error message to stderr.
+*   - exitStatus, the exit status
+*/
+void exit_program(ExitCodes exitStatus) {
+    const char* errorString;
+    switch (exitStatus) {
+        case SUCCESS:
+            exit(SUCCESS);
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-bench hub faculty rollfile "
+                    "winscore games [minplayers [maxplayers]]";
+            break;
+        case INVALID_GAMES:
+            errorString = "Invalid number of games";
+            break;
+        case INVALID_PLAYERS:
+            errorString = "Invalid number of players";
+            break;
+        case REPORT_ERROR:
+            errorString = "Unable to create report file";
+            break;
+    }
+    fprintf(stderr, "%s\n", errorString);
+    exit(exitStatus);
+}
+
+/**
+* Returns the argument as a number, or -1 if it is not a number.
+*   - argument, the argument
+*/
+int parse_count(const char* argument) {
+    char* end;
+    long count = strtol(argument, &end, BASE_FOR_INTEGER_CONVERSION);
+    if (end == argument || *end != '\0' || count < 0 || count > INT_MAX) {
+        return -1;
+    }
+    return (int)count;
+}
+
+/**
+* Returns the monotonic clock in seconds.
+*/
+double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+* Adds what each player of a game reported to the totals, and empties the
+* report file for the next game.
+*   - reportPath, the report file
+*   - totals, the totals to add to
+*/
+void read_reports(const char* reportPath, Totals* totals) {
+    FILE* reports = fopen(reportPath, "r");
+    if (reports == NULL) {
+        return;
+    }
+    char label;
+    unsigned long turns, stays, messages;
+    while (fscanf(reports, " %c %lu %lu %lu", &label, &turns, &stays,
+            &messages) == 4) {
+        totals->turns += turns;
+        totals->stays += stays;
+        totals->broadcasts += messages - turns - stays;
+    }
+    fclose(reports);
+    if (truncate(reportPath, 0) != 0) {
+        exit_program(REPORT_ERROR);
+    }
+}
+
+/**
+* Plays one game with the hub, its output discarded, and adds its time and
+* the players' reports to the totals.
+*   - arguments, the hub's arguments, ending in NULL
+*   - reportPath, the file the players report to
+*   - totals, the totals to add to
+*/
+void play_game(char** arguments, const char* reportPath, Totals* totals) {
+    double start = now_seconds();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        dup2(devNull, STDERR_FILENO);
+        close(devNull);
+        execv(arguments[0], arguments);
+        _exit(EXIT_FAILURE);
+    }
+    int status = EXIT_FAILURE;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+        totals->failed++;
+    }
+    totals->seconds += now_seconds() - start;
+    totals->games++;
+    read_reports(reportPath, totals);
+}
+
+int main(int argc, char** argv) {
+    if (argc < BENCH_MIN_ARGS || argc > BENCH_MAX_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    int games = parse_count(argv[BENCH_GAMES_ARGUMENT_INDEX]);
+    if (games <= 0) {
+        exit_program(INVALID_GAMES);
+    }
+    int minPlayers = argc > BENCH_MIN_PLAYERS_ARGUMENT_INDEX ?
+            parse_count(argv[BENCH_MIN_PLAYERS_ARGUMENT_INDEX]) : MIN_PLAYERS;
+    int maxPlayers = argc > BENCH_MAX_PLAYERS_ARGUMENT_INDEX ?
+            parse_count(argv[BENCH_MAX_PLAYERS_ARGUMENT_INDEX]) :
+            (argc > BENCH_MIN_PLAYERS_ARGUMENT_INDEX ? minPlayers :
+            MAX_PLAYERS);
+    if (minPlayers < MIN_PLAYERS || maxPlayers > MAX_PLAYERS ||
+            minPlayers > maxPlayers) {
+        exit_program(INVALID_PLAYERS);
+    }
+
+    char reportPath[MAX_REPORT_PATH_LENGTH];
+    snprintf(reportPath, MAX_REPORT_PATH_LENGTH, "/tmp/stlucia-bench-%d",
+            (int)getpid());
+    int report = open(reportPath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (report < 0) {
+        exit_program(REPORT_ERROR);
+    }
+    close(report);
+    setenv(REPORT_VARIABLE, reportPath, 1);
+
+    char* arguments[HUB_ARGUMENTS_NOT_PLAYERS + MAX_PLAYERS + 1];
+    arguments[0] = argv[BENCH_HUB_ARGUMENT_INDEX];
+    arguments[1] = argv[BENCH_ROLL_FILE_ARGUMENT_INDEX];
+    arguments[2] = argv[BENCH_SCORE_LIMIT_ARGUMENT_INDEX];
+    for (int players = minPlayers; players <= maxPlayers; players++) {
+        for (int i = 0; i < players; i++) {
+            arguments[HUB_ARGUMENTS_NOT_PLAYERS + i] =
+                    argv[BENCH_FACULTY_ARGUMENT_INDEX];
+        }
+        arguments[HUB_ARGUMENTS_NOT_PLAYERS + players] = NULL;
+        Totals totals;
+        memset(&totals, 0, sizeof(totals));
+        for (int game = 0; game < games; game++) {
+            play_game(arguments, reportPath, &totals);
+        }
+        printf("Players %d: %d games, %d failed, %.3f ms per game, "
+                "%.0f turns/s, %.0f broadcasts/s\n", players, totals.games,
+                totals.failed,
+                totals.seconds / totals.games * MILLISECONDS_PER_SECOND,
+                totals.turns / totals.seconds,
+                totals.broadcasts / totals.seconds);
+        fflush(stdout);
+    }
+    unlink(reportPath);
+    exit_program(SUCCESS);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include "shared.h"
+#include "remote.h"
+
+/* Argument information for the remote player connector */
+#define CONNECT_ARGS 3
+#define CONNECT_ADDRESS_ARGUMENT_INDEX 1
+#define CONNECT_FACULTY_ARGUMENT_INDEX 2
+#define MAX_PLAYER_COUNT_STRING_SIZE 3
+
+/* How often to try the hub until it is listening */
+#define CONNECT_RETRY_NANOSECONDS 100000000
+#define CONNECT_RETRIES_PER_SECOND 10
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, never returned, as the faculty replaces the connector
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - CONNECT_ERROR, unable to connect to the hub
+*   - INVALID_SEAT, the hub did not send a valid seat
+*   - EXEC_ERROR, unable to start the faculty
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    CONNECT_ERROR = 2,
+    INVALID_SEAT = 3,
+    EXEC_ERROR = 4
+} ExitCodes;
+
+/**
+* Exits the program with the specified exit status. Prints the corresponding
+* error message to stderr.
+*   - exitStatus, the exit status
+*/
+void exit_program(ExitCodes exitStatus) {
+    const char* errorString;
+    switch (exitStatus) {
+        case SUCCESS:
+            exit(SUCCESS);
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-connect tcp:host:port|unix:path "
+                    "faculty";
+            break;
+        case CONNECT_ERROR:
+            errorString = "Unable to connect to hub";
+            break;
+        case INVALID_SEAT:
+            errorString = "Invalid seat from hub";
+            break;
+        case EXEC_ERROR:
+            errorString = "Unable to start faculty";
+            break;
+    }
+    fprintf(stderr, "%s\n", errorString);
+    exit(exitStatus);
+}
+
+/**
+* Connects to the hub, trying again until it is listening or
+* STLUCIA_CONNECT_SECONDS have passed. Returns the socket, or -1.
+*   - address, the address of the hub
+*/
+int connect_with_retries(const char* address) {
+    int retries = integer_setting(CONNECT_SECONDS_VARIABLE,
+            DEFAULT_CONNECT_SECONDS, 0, MAX_CONNECT_SECONDS) *
+            CONNECT_RETRIES_PER_SECOND;
+    struct timespec pause = {0, CONNECT_RETRY_NANOSECONDS};
+    int connection;
+    while ((connection = connect_to_hub(address)) < 0 && retries-- > 0) {
+        nanosleep(&pause, NULL);
+    }
+    return connection;
+}
+
+/**
+* Reads the seat line the hub sends first, one byte at a time so nothing
+* meant for the faculty is consumed. Returns false if the line is invalid.
+*   - connection, the socket
+*   - numberPlayers, where to store the player count
+*   - label, where to store the player's label
+*/
+bool read_seat(int connection, char* numberPlayers, char* label) {
+    char line[MAX_MESSAGE_LENGTH];
+    int length = 0;
+    while (length < MAX_MESSAGE_LENGTH - 1) {
+        ssize_t bytesRead = read(connection, line + length, 1);
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        } else if (bytesRead <= 0) {
+            return false;
+        }
+        if (line[length++] == '\n') {
+            break;
+        }
+    }
+    line[length] = '\0';
+    int count;
+    if (sscanf(line, SEAT_MESSAGE " %d %c", &count, label) != 2 ||
+            count < 2 || count > MAX_PLAYERS || *label < FIRST_PLAYER_LETTER ||
+            *label >= FIRST_PLAYER_LETTER + count) {
+        return false;
+    }
+    sprintf(numberPlayers, "%d", count);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != CONNECT_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    int connection = connect_with_retries(
+            argv[CONNECT_ADDRESS_ARGUMENT_INDEX]);
+    if (connection < 0) {
+        exit_program(CONNECT_ERROR);
+    }
+    char numberPlayers[MAX_PLAYER_COUNT_STRING_SIZE];
+    char playerTokenString[LABEL_LENGTH + 1] = {'\0'};
+    if (!read_seat(connection, numberPlayers, playerTokenString)) {
+        exit_program(INVALID_SEAT);
+    }
+    dup2(connection, STDIN_FILENO);
+    dup2(connection, STDOUT_FILENO);
+    close(connection);
+    execlp(argv[CONNECT_FACULTY_ARGUMENT_INDEX],
+            argv[CONNECT_FACULTY_ARGUMENT_INDEX], numberPlayers,
+            playerTokenString, NULL);
+    exit_program(EXEC_ERROR);
+    return 0;
+}
@@ -0,0 +1,692 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "shared.h"
+#include "tournament.h"
+
+/* Argument information for the tournament coordinator */
+#define COORDINATOR_MIN_ARGS 8
+#define COORDINATOR_MAX_ARGS 32
+#define COORDINATOR_ARGUMENTS_NOT_PLAYERS 6
+#define COORDINATOR_PORT_ARGUMENT_INDEX 1
+#define COORDINATOR_ROLL_FILE_ARGUMENT_INDEX 2
+#define COORDINATOR_SCORE_LIMIT_ARGUMENT_INDEX 3
+#define COORDINATOR_GAMES_ARGUMENT_INDEX 4
+#define COORDINATOR_BATCH_ARGUMENT_INDEX 5
+
+/* The most workers connected at once */
+#define MAX_WORKERS 256
+
+/* The batches dealt to a worker ahead of the one it is playing, overridden
+by this variable. Batches still queued at one worker are stolen by workers
+with nothing left to play. */
+#define WORKER_QUEUE_VARIABLE "STLUCIA_WORKER_QUEUE"
+#define DEFAULT_WORKER_QUEUE 4
+#define MAX_WORKER_QUEUE 64
+
+#define NO_WORKER -1
+#define NO_RESULT '\0'
+#define DRAWN_RESULT 'd'
+#define ABANDONED_RESULT 'x'
+#define MAX_SERVICE_NAME_SIZE 32
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, normal exit after all games are played
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - INVALID_SCORE, winscore is not a positive integer
+*   - INVALID_GAMES, the number of games is not a positive integer
+*   - INVALID_BATCH, the batch size is not a positive integer
+*   - LISTEN_ERROR, the port could not be listened on
+*   - MEMORY_FAILURE, the batches could not be allocated
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    INVALID_SCORE = 2,
+    INVALID_GAMES = 3,
+    INVALID_BATCH = 4,
+    LISTEN_ERROR = 5,
+    MEMORY_FAILURE = 6
+} ExitCodes;
+
+/**
+* An enum for where a batch of games is.
+*   - BATCH_QUEUED, waiting at the coordinator for a worker
+*   - BATCH_DEALT, dealt to a worker, which may not have started it
+*   - BATCH_DONE, every game of the batch has a result
+*/
+typedef enum {
+    BATCH_QUEUED,
+    BATCH_DEALT,
+    BATCH_DONE
+} BatchState;
+
+/**
+* A struct for a batch of consecutive games.
+*   - first, the number of the first game
+*   - count, the number of games
+*   - state, where the batch is
+*   - worker, the worker the batch is dealt to
+*   - thief, the worker waiting to steal the batch, or NO_WORKER
+*/
+typedef struct {
+    int first;
+    int count;
+    BatchState state;
+    int worker;
+    int thief;
+} Batch;
+
+/**
+* A struct for a connected worker. A worker plays its batches in the order
+* they are dealt, so every batch but the first may still be stolen.
+*   - connection, the worker's socket
+*   - number, the worker's number in messages
+*   - dealt, the batches dealt to the worker and not yet done, in order
+*   - numberDealt, the number of those batches
+*   - stealing, whether the worker is waiting for a stolen batch
+*   - robbed, whether one of the worker's batches is being stolen
+*/
+typedef struct {
+    Connection connection;
+    int number;
+    int dealt[MAX_WORKER_QUEUE];
+    int numberDealt;
+    bool stealing;
+    bool robbed;
+} Worker;
+
+/**
+* A struct for the state of the tournament.
+*   - job, the job line sent to every worker
+*   - numberOfPlayers, the number of players in each game
+*   - faculties, the faculty played in each seat
+*   - games, the number of games
+*   - batches, every batch of games
+*   - numberOfBatches, the number of batches
+*   - queue, the batches waiting at the coordinator, a circular buffer
+*   - queueHead, queueLength, the first and number of queued batches
+*   - batchesDone, the number of batches done
+*   - workers, the worker slots
+*   - workerQueue, the batches dealt to a worker at once
+*   - workersSeen, the number of workers that have connected
+*   - results, the result of every game, NO_RESULT until it arrives
+*   - nextPrinted, the first game whose result has not been printed
+*   - wins, the games won by each seat
+*   - draws, abandoned, the games drawn and abandoned
+*   - turns, the number of turns played in batches done
+*   - requeued, stolen, the number of batches requeued and stolen
+*/
+typedef struct {
+    char job[TOURNAMENT_LINE_LENGTH];
+    int numberOfPlayers;
+    char** faculties;
+    int games;
+    Batch* batches;
+    int numberOfBatches;
+    int* queue;
+    int queueHead;
+    int queueLength;
+    int batchesDone;
+    Worker workers[MAX_WORKERS];
+    int workerQueue;
+    int workersSeen;
+    char* results;
+    int nextPrinted;
+    int wins[MAX_PLAYERS];
+    int draws;
+    int abandoned;
+    long long turns;
+    int requeued;
+    int stolen;
+} Tournament;
+
+/**
+* Exits the program with the specified exit status. Prints the corresponding
+* error message to stderr.
+*   - exitStatus, the exit status
+*/
+void exit_program(ExitCodes exitStatus) {
+    const char* errorString;
+    switch (exitStatus) {
+        case SUCCESS:
+            exit(SUCCESS);
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-coordinator port rollfile winscore"
+                    " games batchsize prog1 prog2 [prog3 [prog4]]";
+            break;
+        case INVALID_SCORE:
+            errorString = "Invalid score";
+            break;
+        case INVALID_GAMES:
+            errorString = "Invalid number of games";
+            break;
+        case INVALID_BATCH:
+            errorString = "Invalid batch size";
+            break;
+        case LISTEN_ERROR:
+            errorString = "Unable to listen on port";
+            break;
+        case MEMORY_FAILURE:
+            errorString = "Unable to allocate batches";
+            break;
+    }
+    fprintf(stderr, "%s\n", errorString);
+    exit(exitStatus);
+}
+
+/**
+* Returns the current time in seconds.
+*/
+double current_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+* Adds a batch to the back of the coordinator's queue.
+*   - tournament, the tournament
+*   - batchNumber, the batch to queue
+*/
+void queue_batch(Tournament* tournament, int batchNumber) {
+    Batch* batch = &tournament->batches[batchNumber];
+    batch->state = BATCH_QUEUED;
+    batch->worker = NO_WORKER;
+    batch->thief = NO_WORKER;
+    tournament->queue[(tournament->queueHead + tournament->queueLength) %
+            tournament->numberOfBatches] = batchNumber;
+    tournament->queueLength++;
+}
+
+/**
+* Deals a batch to a worker, which plays it after the batches it already
+* has. Returns false if the worker has gone.
+*   - tournament, the tournament
+*   - worker, the worker
+*   - batchNumber, the batch to deal
+*/
+bool deal_batch(Tournament* tournament, Worker* worker, int batchNumber) {
+    Batch* batch = &tournament->batches[batchNumber];
+    batch->state = BATCH_DEALT;
+    batch->worker = (int)(worker - tournament->workers);
+    batch->thief = NO_WORKER;
+    worker->dealt[worker->numberDealt++] = batchNumber;
+    return send_line(&worker->connection, "%s %d %d %d", BATCH_MESSAGE,
+            batchNumber, batch->first, batch->count);
+}
+
+/**
+* Removes a batch from the batches dealt to a worker.
+*   - worker, the worker
+*   - batchNumber, the batch
+*/
+void undeal_batch(Worker* worker, int batchNumber) {
+    for (int i = 0; i < worker->numberDealt; i++) {
+        if (worker->dealt[i] == batchNumber) {
+            memmove(worker->dealt + i, worker->dealt + i + 1,
+                    (worker->numberDealt - i - 1) * sizeof(int));
+            worker->numberDealt--;
+            return;
+        }
+    }
+}
+
+/**
+* Prints the results that have arrived for the games after the last one
+* printed, stopping at the first game still without a result, so results
+* are printed in game order however the batches finish.
+*   - tournament, the tournament
+*/
+void print_results(Tournament* tournament) {
+    bool printed = false;
+    while (tournament->nextPrinted < tournament->games &&
+            tournament->results[tournament->nextPrinted] != NO_RESULT) {
+        char result = tournament->results[tournament->nextPrinted];
+        if (result == DRAWN_RESULT) {
+            printf("Game %d: drawn\n", tournament->nextPrinted);
+            tournament->draws++;
+        } else if (result == ABANDONED_RESULT) {
+            printf("Game %d: abandoned\n", tournament->nextPrinted);
+            tournament->abandoned++;
+        } else {
+            printf("Game %d: Player %c wins\n", tournament->nextPrinted,
+                    result);
+            tournament->wins[result - FIRST_PLAYER_LETTER]++;
+        }
+        tournament->nextPrinted++;
+        printed = true;
+    }
+    if (printed) {
+        fflush(stdout);
+    }
+}
+
+/**
+* Disconnects a worker and queues again every batch dealt to it, including
+* any it had started. Results it already sent are kept, so the games of a
+* requeued batch that already have results are not counted twice.
+*   - tournament, the tournament
+*   - worker, the worker
+*/
+void lose_worker(Tournament* tournament, Worker* worker) {
+    close_connection(&worker->connection);
+    for (int i = 0; i < worker->numberDealt; i++) {
+        int thief = tournament->batches[worker->dealt[i]].thief;
+        if (thief != NO_WORKER) {
+            tournament->workers[thief].stealing = false;
+        }
+        queue_batch(tournament, worker->dealt[i]);
+        tournament->requeued++;
+    }
+    if (worker->numberDealt > 0) {
+        fprintf(stderr, "Worker %d lost, %d batches requeued\n",
+                worker->number, worker->numberDealt);
+    }
+    worker->numberDealt = 0;
+    worker->robbed = false;
+    worker->stealing = false;
+    int workerIndex = (int)(worker - tournament->workers);
+    for (int b = 0; b < tournament->numberOfBatches; b++) {
+        if (tournament->batches[b].thief == workerIndex) {
+            tournament->batches[b].thief = NO_WORKER;
+        }
+    }
+}
+
+/**
+* Asks the worker with the most batches queued to give up its last one for
+* the specified idle worker.
+*   - tournament, the tournament
+*   - thief, the idle worker
+*/
+void steal_batch(Tournament* tournament, Worker* thief) {
+    Worker* victim = NULL;
+    for (int w = 0; w < MAX_WORKERS; w++) {
+        Worker* worker = &tournament->workers[w];
+        if (worker->connection.fd >= 0 && !worker->robbed &&
+                worker->numberDealt > 1 && (victim == NULL ||
+                worker->numberDealt > victim->numberDealt)) {
+            victim = worker;
+        }
+    }
+    if (victim == NULL) {
+        return;
+    }
+    int batchNumber = victim->dealt[victim->numberDealt - 1];
+    if (!send_line(&victim->connection, "%s %d", STEAL_MESSAGE,
+            batchNumber)) {
+        lose_worker(tournament, victim);
+        return;
+    }
+    tournament->batches[batchNumber].thief =
+            (int)(thief - tournament->workers);
+    victim->robbed = true;
+    thief->stealing = true;
+}
+
+/**
+* Deals queued batches until every worker has its share, then lets idle
+* workers steal from the others once the queue is empty.
+*   - tournament, the tournament
+*/
+void balance_workers(Tournament* tournament) {
+    for (int w = 0; w < MAX_WORKERS; w++) {
+        Worker* worker = &tournament->workers[w];
+        while (worker->connection.fd >= 0 && tournament->queueLength > 0 &&
+                worker->numberDealt < tournament->workerQueue) {
+            int batchNumber = tournament->queue[tournament->queueHead];
+            tournament->queueHead = (tournament->queueHead + 1) %
+                    tournament->numberOfBatches;
+            tournament->queueLength--;
+            if (!deal_batch(tournament, worker, batchNumber)) {
+                lose_worker(tournament, worker);
+            }
+        }
+    }
+    for (int w = 0; w < MAX_WORKERS; w++) {
+        Worker* worker = &tournament->workers[w];
+        if (worker->connection.fd >= 0 && worker->numberDealt == 0 &&
+                !worker->stealing) {
+            steal_batch(tournament, worker);
+        }
+    }
+}
+
+/**
+* Records the result of a game sent by a worker, as printed by
+* stlucia-tables. Returns false if the line is not a valid result.
+*   - tournament, the tournament
+*   - line, the result line
+*/
+bool record_result(Tournament* tournament, char* line) {
+    int game;
+    char label;
+    char result;
+    if (sscanf(line, GAME_MESSAGE " %d: Player %c wins", &game,
+            &label) == 2) {
+        if (label < FIRST_PLAYER_LETTER || label >=
+                FIRST_PLAYER_LETTER + tournament->numberOfPlayers) {
+            return false;
+        }
+        result = label;
+    } else if (sscanf(line, GAME_MESSAGE " %d: drawn", &game) == 1 &&
+            strstr(line, "drawn") != NULL) {
+        result = DRAWN_RESULT;
+    } else if (sscanf(line, GAME_MESSAGE " %d: abandoned", &game) == 1 &&
+            strstr(line, "abandoned") != NULL) {
+        result = ABANDONED_RESULT;
+    } else {
+        return false;
+    }
+    if (game < 0 || game >= tournament->games) {
+        return false;
+    }
+    if (tournament->results[game] == NO_RESULT) {
+        tournament->results[game] = result;
+    }
+    return true;
+}
+
+/**
+* Marks a batch done by a worker. Games of the batch the worker sent no
+* result for are abandoned.
+*   - tournament, the tournament
+*   - worker, the worker
+*   - batchNumber, the batch
+*   - turns, the number of turns the batch took
+*/
+void finish_batch(Tournament* tournament, Worker* worker, int batchNumber,
+        long long turns) {
+    Batch* batch = &tournament->batches[batchNumber];
+    undeal_batch(worker, batchNumber);
+    batch->state = BATCH_DONE;
+    for (int g = batch->first; g < batch->first + batch->count; g++) {
+        if (tournament->results[g] == NO_RESULT) {
+            tournament->results[g] = ABANDONED_RESULT;
+        }
+    }
+    tournament->turns += turns;
+    tournament->batchesDone++;
+}
+
+/**
+* Hands a batch a worker gave up to the worker that stole it, or queues it
+* again if the thief has gone.
+*   - tournament, the tournament
+*   - victim, the worker that gave up the batch
+*   - batchNumber, the batch
+*/
+void hand_over_batch(Tournament* tournament, Worker* victim,
+        int batchNumber) {
+    Batch* batch = &tournament->batches[batchNumber];
+    undeal_batch(victim, batchNumber);
+    victim->robbed = false;
+    if (batch->thief == NO_WORKER) {
+        queue_batch(tournament, batchNumber);
+        return;
+    }
+    Worker* thief = &tournament->workers[batch->thief];
+    thief->stealing = false;
+    tournament->stolen++;
+    if (!deal_batch(tournament, thief, batchNumber)) {
+        lose_worker(tournament, thief);
+    }
+}
+
+/**
+* Handles a line from a worker. Returns false if the line is invalid.
+*   - tournament, the tournament
+*   - worker, the worker
+*   - line, the line
+*/
+bool handle_worker_line(Tournament* tournament, Worker* worker,
+        char* line) {
+    int batchNumber;
+    long long turns;
+    if (strncmp(line, GAME_MESSAGE " ", strlen(GAME_MESSAGE) + 1) == 0) {
+        return record_result(tournament, line);
+    }
+    bool done = sscanf(line, DONE_MESSAGE " %d %lld", &batchNumber,
+            &turns) == 2;
+    bool stolen = !done &&
+            sscanf(line, STOLEN_MESSAGE " %d", &batchNumber) == 1;
+    bool kept = !done && !stolen &&
+            sscanf(line, KEPT_MESSAGE " %d", &batchNumber) == 1;
+    if (!done && !stolen && !kept) {
+        return false;
+    }
+    if (batchNumber < 0 || batchNumber >= tournament->numberOfBatches ||
+            tournament->batches[batchNumber].state != BATCH_DEALT ||
+            tournament->batches[batchNumber].worker !=
+            (int)(worker - tournament->workers)) {
+        return false;
+    }
+    Batch* batch = &tournament->batches[batchNumber];
+    if (done) {
+        finish_batch(tournament, worker, batchNumber, turns);
+    } else if (stolen) {
+        hand_over_batch(tournament, worker, batchNumber);
+    } else {
+        worker->robbed = false;
+        if (batch->thief != NO_WORKER) {
+            tournament->workers[batch->thief].stealing = false;
+            batch->thief = NO_WORKER;
+        }
+    }
+    return true;
+}
+
+/**
+* Reads whatever a worker has sent and handles each complete line. A worker
+* that has gone, fails a batch or breaks the protocol is disconnected.
+*   - tournament, the tournament
+*   - worker, the worker
+*/
+void read_worker(Tournament* tournament, Worker* worker) {
+    if (!fill_connection(&worker->connection)) {
+        lose_worker(tournament, worker);
+        return;
+    }
+    char line[TOURNAMENT_LINE_LENGTH];
+    while (worker->connection.fd >= 0 &&
+            next_line(&worker->connection, line)) {
+        if (strncmp(line, FAILED_MESSAGE, strlen(FAILED_MESSAGE)) == 0) {
+            fprintf(stderr, "Worker %d failed a batch\n", worker->number);
+            lose_worker(tournament, worker);
+        } else if (!handle_worker_line(tournament, worker, line)) {
+            fprintf(stderr, "Worker %d sent an invalid message\n",
+                    worker->number);
+            lose_worker(tournament, worker);
+        }
+    }
+    print_results(tournament);
+}
+
+/**
+* Accepts a worker and sends it the job. Workers beyond MAX_WORKERS are
+* turned away.
+*   - tournament, the tournament
+*   - listener, the listening socket
+*/
+void accept_worker(Tournament* tournament, int listener) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    for (int w = 0; w < MAX_WORKERS; w++) {
+        Worker* worker = &tournament->workers[w];
+        if (worker->connection.fd < 0) {
+            open_connection(&worker->connection, fd);
+            worker->number = tournament->workersSeen++;
+            worker->numberDealt = 0;
+            worker->stealing = false;
+            worker->robbed = false;
+            if (!send_line(&worker->connection, "%s", tournament->job)) {
+                lose_worker(tournament, worker);
+            }
+            return;
+        }
+    }
+    close(fd);
+}
+
+/**
+* Plays every batch on whichever workers are connected, accepting workers
+* as they arrive, until every batch is done.
+*   - tournament, the tournament
+*   - listener, the listening socket
+*/
+void run_tournament(Tournament* tournament, int listener) {
+    struct pollfd polls[MAX_WORKERS + 1];
+    while (tournament->batchesDone < tournament->numberOfBatches) {
+        balance_workers(tournament);
+        polls[0].fd = listener;
+        polls[0].events = POLLIN;
+        polls[0].revents = 0;
+        for (int w = 0; w < MAX_WORKERS; w++) {
+            polls[w + 1].fd = tournament->workers[w].connection.fd;
+            polls[w + 1].events = POLLIN;
+            polls[w + 1].revents = 0;
+        }
+        if (poll(polls, MAX_WORKERS + 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        for (int w = 0; w < MAX_WORKERS; w++) {
+            if (polls[w + 1].revents != 0 &&
+                    tournament->workers[w].connection.fd >= 0) {
+                read_worker(tournament, &tournament->workers[w]);
+            }
+        }
+        if (polls[0].revents != 0) {
+            accept_worker(tournament, listener);
+        }
+    }
+}
+
+/**
+* Builds the job line sent to every worker. Returns false if it is too long.
+*   - tournament, the tournament
+*   - argv, the command line arguments
+*/
+bool build_job(Tournament* tournament, char** argv) {
+    int length = snprintf(tournament->job, TOURNAMENT_LINE_LENGTH, "%s %s %s",
+            JOB_MESSAGE, argv[COORDINATOR_SCORE_LIMIT_ARGUMENT_INDEX],
+            argv[COORDINATOR_ROLL_FILE_ARGUMENT_INDEX]);
+    for (int i = 0; i < tournament->numberOfPlayers; i++) {
+        if (length >= TOURNAMENT_LINE_LENGTH - 1) {
+            return false;
+        }
+        length += snprintf(tournament->job + length,
+                TOURNAMENT_LINE_LENGTH - length, " %s",
+                tournament->faculties[i]);
+    }
+    return length < TOURNAMENT_LINE_LENGTH - 1;
+}
+
+int main(int argc, char** argv) {
+    struct sigaction sigpipe;
+    memset(&sigpipe, 0, sizeof(sigpipe));
+    sigpipe.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sigpipe, 0);
+
+    if (argc < COORDINATOR_MIN_ARGS || argc > COORDINATOR_MAX_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    static Tournament tournament;
+    if (atoi(argv[COORDINATOR_SCORE_LIMIT_ARGUMENT_INDEX]) <= 0) {
+        exit_program(INVALID_SCORE);
+    }
+    tournament.games = atoi(argv[COORDINATOR_GAMES_ARGUMENT_INDEX]);
+    if (tournament.games <= 0) {
+        exit_program(INVALID_GAMES);
+    }
+    int batchSize = atoi(argv[COORDINATOR_BATCH_ARGUMENT_INDEX]);
+    if (batchSize <= 0) {
+        exit_program(INVALID_BATCH);
+    }
+    tournament.numberOfPlayers = argc - COORDINATOR_ARGUMENTS_NOT_PLAYERS;
+    tournament.faculties = argv + COORDINATOR_ARGUMENTS_NOT_PLAYERS;
+    if (tournament.numberOfPlayers > MAX_PLAYERS ||
+            !build_job(&tournament, argv)) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    tournament.workerQueue = integer_setting(WORKER_QUEUE_VARIABLE,
+            DEFAULT_WORKER_QUEUE, 1, MAX_WORKER_QUEUE);
+
+    tournament.numberOfBatches = (tournament.games + batchSize - 1) /
+            batchSize;
+    tournament.batches = calloc(tournament.numberOfBatches, sizeof(Batch));
+    tournament.queue = calloc(tournament.numberOfBatches, sizeof(int));
+    tournament.results = calloc(tournament.games, sizeof(char));
+    if (tournament.batches == NULL || tournament.queue == NULL ||
+            tournament.results == NULL) {
+        exit_program(MEMORY_FAILURE);
+    }
+    for (int b = 0; b < tournament.numberOfBatches; b++) {
+        tournament.batches[b].first = b * batchSize;
+        tournament.batches[b].count = b * batchSize + batchSize >
+                tournament.games ? tournament.games - b * batchSize :
+                batchSize;
+        queue_batch(&tournament, b);
+    }
+    for (int w = 0; w < MAX_WORKERS; w++) {
+        tournament.workers[w].connection.fd = -1;
+    }
+
+    int listener = listen_on(argv[COORDINATOR_PORT_ARGUMENT_INDEX]);
+    if (listener < 0) {
+        exit_program(LISTEN_ERROR);
+    }
+    struct sockaddr_storage address;
+    socklen_t addressLength = sizeof(address);
+    char service[MAX_SERVICE_NAME_SIZE];
+    if (getsockname(listener, (struct sockaddr*)&address,
+            &addressLength) == 0 && getnameinfo((struct sockaddr*)&address,
+            addressLength, NULL, 0, service, MAX_SERVICE_NAME_SIZE,
+            NI_NUMERICSERV) == 0) {
+        fprintf(stderr, "Listening on port %s\n", service);
+    }
+
+    double start = current_time();
+    run_tournament(&tournament, listener);
+    double elapsed = current_time() - start;
+    for (int w = 0; w < MAX_WORKERS; w++) {
+        send_line(&tournament.workers[w].connection, "%s", SHUTDOWN_MESSAGE);
+        close_connection(&tournament.workers[w].connection);
+    }
+    close(listener);
+
+    for (int i = 0; i < tournament.numberOfPlayers; i++) {
+        printf("Player %c (%s) won %d\n", get_player_label(i),
+                tournament.faculties[i], tournament.wins[i]);
+    }
+    printf("Drawn %d\n", tournament.draws);
+    printf("Abandoned %d\n", tournament.abandoned);
+    printf("Played %d games, %lld turns in %.3fs (%.0f games/s)\n",
+            tournament.games, tournament.turns, elapsed,
+            elapsed > 0 ? tournament.games / elapsed : 0.0);
+    printf("Workers %d, batches %d, stolen %d, requeued %d\n",
+            tournament.workersSeen, tournament.numberOfBatches,
+            tournament.stolen, tournament.requeued);
+    free(tournament.batches);
+    free(tournament.queue);
+    free(tournament.results);
+    exit_program(SUCCESS);
+    return 0;
+}
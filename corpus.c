@@ -0,0 +1,674 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "shared.h"
+
+/* Argument information for the corpus benchmark */
+#define CORPUS_MODE_ARGUMENT_INDEX 1
+#define CORPUS_DIRECTORY_ARGUMENT_INDEX 2
+#define CORPUS_BIN_ARGUMENT_INDEX 3
+#define CORPUS_ROUNDS_ARGUMENT_INDEX 4
+#define CORPUS_SAMPLES_ARGUMENT_INDEX 5
+#define RECORD_ARGS 4
+#define RUN_MIN_ARGS 5
+#define RUN_MAX_ARGS 6
+#define COMPARE_ARGS 4
+#define ALLOCATIONS_ARGS 4
+#define COMPARE_BEFORE_ARGUMENT_INDEX 2
+#define COMPARE_AFTER_ARGUMENT_INDEX 3
+
+/* The layout of a corpus directory: the list of games, one per line as
+"name [VARIABLE=value ...] rollfile winscore faculty1 faculty2 ...", and
+each game's transcript. The hub of a game is run with its settings. */
+#define GAMES_FILE "games"
+#define GOLDEN_DIRECTORY "golden"
+#define GOLDEN_SUFFIX ".txt"
+#define HUB_PROGRAM "stlucia"
+#define MAX_GAMES 1024
+#define MAX_LINE_LENGTH 512
+#define MAX_PATH_LENGTH 1024
+#define MAX_SAMPLES 10000
+#define MAX_NAME_LENGTH 64
+#define MAX_STATUS_LINE_LENGTH 32
+#define HUB_ARGUMENTS_NOT_PLAYERS 3
+#define MAX_SETTINGS 8
+#define GOLDEN_FILE_MODE 0644
+
+/* Hubs are run without the result cache, so every game is played and timed */
+#define CACHE_VARIABLE "STLUCIA_CACHE"
+
+/* The line an instrumented hub ends its transcript with, and the count of
+its allocations during turns when there were none */
+#define ALLOCATION_REPORT "Allocations setup "
+#define NO_TURN_ALLOCATIONS ", turns 0 ("
+
+/* Significance level of the comparison, and the confidence of intervals */
+#define SIGNIFICANCE_LEVEL 0.05
+#define CONFIDENCE_PERCENT 95
+#define PERCENT 100.0
+
+/* Limits of the numerical methods for the t distribution */
+#define BETA_ITERATIONS 200
+#define BETA_EPSILON 3.0e-14
+#define BETA_TINY 1.0e-300
+#define QUANTILE_ITERATIONS 100
+#define QUANTILE_UPPER_BOUND 1000.0
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+#define BASE_FOR_INTEGER_CONVERSION 10
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, normal exit, every transcript matched
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - INVALID_CORPUS, the list of games is missing or invalid
+*   - MISSING_GOLDEN, a game has no recorded transcript
+*   - TRANSCRIPT_MISMATCH, a game's transcript differed from the recording
+*   - INVALID_SAMPLES, a samples file is missing or has too few samples
+*   - IO_FAILURE, a transcript or samples file could not be written
+*   - TURN_ALLOCATIONS, a game allocated during turns or was not instrumented
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    INVALID_CORPUS = 2,
+    MISSING_GOLDEN = 3,
+    TRANSCRIPT_MISMATCH = 4,
+    INVALID_SAMPLES = 5,
+    IO_FAILURE = 6,
+    TURN_ALLOCATIONS = 7
+} ExitCodes;
+
+/**
+* A struct for one game of the corpus.
+*   - name, the name of its transcript
+*   - settings, the VARIABLE=value settings to run the hub with, ending in
+*       NULL
+*   - arguments, the arguments to run the hub with, ending in NULL
+*   - golden, the recorded transcript, or NULL when recording
+*   - goldenLength, the length of the recorded transcript
+*/
+typedef struct {
+    char name[MAX_NAME_LENGTH];
+    char* settings[MAX_SETTINGS + 1];
+    char* arguments[HUB_ARGUMENTS_NOT_PLAYERS + MAX_PLAYERS + 1];
+    char* golden;
+    size_t goldenLength;
+} CorpusGame;
+
+/**
+* A struct for the mean, standard deviation and number of samples.
+*/
+typedef struct {
+    double mean;
+    double deviation;
+    int count;
+} Summary;
+
+/**
+* Exits the program with the specified exit status. Prints the corresponding
+* error message to stderr.
+*   - exitStatus, the exit status
+*/
+void exit_program(ExitCodes exitStatus) {
+    const char* errorString;
+    switch (exitStatus) {
+        case SUCCESS:
+            exit(SUCCESS);
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-corpus record corpus bindir\n"
+                    "       stlucia-corpus run corpus bindir rounds "
+                    "[samples]\n"
+                    "       stlucia-corpus compare before after\n"
+                    "       stlucia-corpus allocations corpus bindir";
+            break;
+        case INVALID_CORPUS:
+            errorString = "Invalid corpus";
+            break;
+        case MISSING_GOLDEN:
+            errorString = "Missing recorded transcript";
+            break;
+        case TRANSCRIPT_MISMATCH:
+            errorString = "Transcripts differ from the recording";
+            break;
+        case INVALID_SAMPLES:
+            errorString = "Invalid samples";
+            break;
+        case IO_FAILURE:
+            errorString = "Unable to write results";
+            break;
+        case TURN_ALLOCATIONS:
+            errorString = "Allocations during turns";
+            break;
+    }
+    fprintf(stderr, "%s\n", errorString);
+    exit(exitStatus);
+}
+
+/**
+* Returns the monotonic clock in seconds.
+*/
+double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+* Reads a whole file into a new buffer. Returns NULL if it cannot be read.
+*   - path, the file
+*   - length, where to store its length
+*/
+char* read_whole_file(const char* path, size_t* length) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return NULL;
+    }
+    char* contents = malloc(status.st_size + 1);
+    ssize_t got = read(fd, contents, status.st_size);
+    close(fd);
+    if (got != status.st_size) {
+        free(contents);
+        return NULL;
+    }
+    contents[got] = '\0';
+    *length = got;
+    return contents;
+}
+
+/**
+* Reads the corpus's list of games, with the hub and faculties in bindir and
+* roll files relative to the corpus. Loads each recorded transcript unless
+* recording. Returns the number of games.
+*   - corpus, the corpus directory
+*   - bindir, the directory of the hub and faculties
+*   - games, where to store the games, MAX_GAMES in size
+*   - recording, whether the transcripts are about to be recorded
+*/
+int read_corpus(const char* corpus, const char* bindir, CorpusGame* games,
+        bool recording) {
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, MAX_PATH_LENGTH, "%s/%s", corpus, GAMES_FILE);
+    FILE* list = fopen(path, "r");
+    if (list == NULL) {
+        exit_program(INVALID_CORPUS);
+    }
+    int numberOfGames = 0;
+    char line[MAX_LINE_LENGTH];
+    while (fgets(line, MAX_LINE_LENGTH, list) != NULL) {
+        char* fields[HUB_ARGUMENTS_NOT_PLAYERS + MAX_PLAYERS + 1];
+        char* settings[MAX_SETTINGS];
+        int numberOfFields = 0;
+        int numberOfSettings = 0;
+        for (char* field = strtok(line, " \t\n"); field != NULL;
+                field = strtok(NULL, " \t\n")) {
+            if (numberOfFields == 1 && strchr(field, '=') != NULL) {
+                if (numberOfSettings == MAX_SETTINGS) {
+                    exit_program(INVALID_CORPUS);
+                }
+                settings[numberOfSettings++] = field;
+                continue;
+            }
+            if (numberOfFields == HUB_ARGUMENTS_NOT_PLAYERS + MAX_PLAYERS) {
+                exit_program(INVALID_CORPUS);
+            }
+            fields[numberOfFields++] = field;
+        }
+        if (numberOfFields == 0 || fields[0][0] == '#') {
+            continue;
+        }
+        if (numberOfFields < HUB_ARGUMENTS_NOT_PLAYERS + MIN_PLAYERS ||
+                numberOfGames == MAX_GAMES ||
+                strlen(fields[0]) >= MAX_NAME_LENGTH) {
+            exit_program(INVALID_CORPUS);
+        }
+        CorpusGame* game = &games[numberOfGames++];
+        strcpy(game->name, fields[0]);
+        for (int i = 0; i < numberOfSettings; i++) {
+            game->settings[i] = strdup(settings[i]);
+        }
+        game->settings[numberOfSettings] = NULL;
+        snprintf(path, MAX_PATH_LENGTH, "%s/%s", bindir, HUB_PROGRAM);
+        game->arguments[0] = strdup(path);
+        snprintf(path, MAX_PATH_LENGTH, "%s/%s", corpus, fields[1]);
+        game->arguments[1] = strdup(path);
+        game->arguments[2] = strdup(fields[2]);
+        for (int i = HUB_ARGUMENTS_NOT_PLAYERS; i < numberOfFields; i++) {
+            snprintf(path, MAX_PATH_LENGTH, "%s/%s", bindir, fields[i]);
+            game->arguments[i] = strdup(path);
+        }
+        game->arguments[numberOfFields] = NULL;
+        game->golden = NULL;
+        if (!recording) {
+            snprintf(path, MAX_PATH_LENGTH, "%s/%s/%s%s", corpus,
+                    GOLDEN_DIRECTORY, game->name, GOLDEN_SUFFIX);
+            game->golden = read_whole_file(path, &game->goldenLength);
+            if (game->golden == NULL) {
+                fprintf(stderr, "No transcript for %s\n", game->name);
+                exit_program(MISSING_GOLDEN);
+            }
+        }
+    }
+    fclose(list);
+    if (numberOfGames == 0) {
+        exit_program(INVALID_CORPUS);
+    }
+    return numberOfGames;
+}
+
+/**
+* Plays a game, writing the hub's output to the transcript file followed by
+* its exit status, and returns the seconds the hub ran for.
+*   - game, the game
+*   - transcript, the file to write the transcript to, which is emptied
+*/
+double play_corpus_game(CorpusGame* game, int transcript) {
+    if (ftruncate(transcript, 0) != 0 ||
+            lseek(transcript, 0, SEEK_SET) != 0) {
+        exit_program(IO_FAILURE);
+    }
+    double start = now_seconds();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(transcript, STDOUT_FILENO);
+        dup2(transcript, STDERR_FILENO);
+        unsetenv(CACHE_VARIABLE);
+        for (int i = 0; game->settings[i] != NULL; i++) {
+            putenv(game->settings[i]);
+        }
+        execv(game->arguments[0], game->arguments);
+        _exit(EXIT_FAILURE);
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0) {
+        status = -1;
+    }
+    double seconds = now_seconds() - start;
+    char statusLine[MAX_STATUS_LINE_LENGTH];
+    int length = snprintf(statusLine, MAX_STATUS_LINE_LENGTH,
+            "Exit status %d\n", WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    if (write(transcript, statusLine, length) != length) {
+        exit_program(IO_FAILURE);
+    }
+    return seconds;
+}
+
+/**
+* Returns true if the transcript just written matches the recorded one.
+*   - game, the game
+*   - transcript, the file the transcript was written to
+*/
+bool matches_golden(CorpusGame* game, int transcript) {
+    off_t length = lseek(transcript, 0, SEEK_END);
+    if (length != (off_t)game->goldenLength) {
+        return false;
+    }
+    char* played = malloc(length + 1);
+    bool matches = pread(transcript, played, length, 0) == length &&
+            memcmp(played, game->golden, length) == 0;
+    free(played);
+    return matches;
+}
+
+/**
+* Plays every game once and saves its transcript as the recording.
+*   - corpus, the corpus directory
+*   - games, the games
+*   - numberOfGames, the number of games
+*   - transcript, a scratch file for transcripts
+*/
+void record_corpus(const char* corpus, CorpusGame* games, int numberOfGames,
+        int transcript) {
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, MAX_PATH_LENGTH, "%s/%s", corpus, GOLDEN_DIRECTORY);
+    mkdir(path, GOLDEN_FILE_MODE | S_IXUSR | S_IXGRP | S_IXOTH);
+    for (int i = 0; i < numberOfGames; i++) {
+        play_corpus_game(&games[i], transcript);
+        off_t length = lseek(transcript, 0, SEEK_END);
+        char* played = malloc(length);
+        snprintf(path, MAX_PATH_LENGTH, "%s/%s/%s%s", corpus,
+                GOLDEN_DIRECTORY, games[i].name, GOLDEN_SUFFIX);
+        int golden = open(path, O_WRONLY | O_CREAT | O_TRUNC,
+                GOLDEN_FILE_MODE);
+        if (golden < 0 || pread(transcript, played, length, 0) != length ||
+                write(golden, played, length) != length) {
+            exit_program(IO_FAILURE);
+        }
+        close(golden);
+        free(played);
+    }
+    printf("Recorded %d games\n", numberOfGames);
+}
+
+/**
+* Returns true if the transcript just written by a hub built with
+* -DSTLUCIA_ALLOCATIONS reports no allocations during turns and, with its
+* report taken out, matches the recorded one. A player that allocates during
+* turns aborts, which the hub reports, so this checks the players as well.
+*   - game, the game
+*   - transcript, the file the transcript was written to
+*/
+bool allocation_free(CorpusGame* game, int transcript) {
+    off_t length = lseek(transcript, 0, SEEK_END);
+    char* played = malloc(length + 1);
+    if (pread(transcript, played, length, 0) != length) {
+        free(played);
+        return false;
+    }
+    played[length] = '\0';
+    char* report = strstr(played, ALLOCATION_REPORT);
+    char* reportEnd = report == NULL ? NULL : strchr(report, '\n');
+    bool allocationFree = reportEnd != NULL &&
+            (report == played || report[-1] == '\n');
+    if (allocationFree) {
+        *reportEnd = '\0';
+        allocationFree = strstr(report, NO_TURN_ALLOCATIONS) != NULL;
+        memmove(report, reportEnd + 1, played + length - reportEnd);
+        length -= reportEnd + 1 - report;
+    }
+    allocationFree = allocationFree &&
+            length == (off_t)game->goldenLength &&
+            memcmp(played, game->golden, length) == 0;
+    free(played);
+    return allocationFree;
+}
+
+/**
+* Plays every game once with a hub and players built with
+* -DSTLUCIA_ALLOCATIONS, checking that none allocates during turns. Returns
+* the number of games that did.
+*   - games, the games
+*   - numberOfGames, the number of games
+*   - transcript, a scratch file for transcripts
+*/
+int check_allocations(CorpusGame* games, int numberOfGames, int transcript) {
+    int failures = 0;
+    for (int i = 0; i < numberOfGames; i++) {
+        play_corpus_game(&games[i], transcript);
+        if (!allocation_free(&games[i], transcript)) {
+            fprintf(stderr, "%s failed the allocation check\n",
+                    games[i].name);
+            failures++;
+        }
+    }
+    printf("Games %d, allocating during turns %d\n", numberOfGames,
+            failures);
+    return failures;
+}
+
+/**
+* Returns the regularized incomplete beta function I_x(a, b), by Lentz's
+* continued fraction.
+*   - x, a, b, its arguments
+*/
+double incomplete_beta(double x, double a, double b) {
+    if (x <= 0.0) {
+        return 0.0;
+    } else if (x >= 1.0) {
+        return 1.0;
+    } else if (x > (a + 1.0) / (a + b + 2.0)) {
+        return 1.0 - incomplete_beta(1.0 - x, b, a);
+    }
+    double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) +
+            a * log(x) + b * log(1.0 - x)) / a;
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    d = 1.0 / (fabs(d) < BETA_TINY ? BETA_TINY : d);
+    double fraction = d;
+    for (int m = 1; m <= BETA_ITERATIONS; m++) {
+        for (int step = 0; step < 2; step++) {
+            double numerator = step == 0 ?
+                    m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)) :
+                    -(a + m) * (a + b + m) * x /
+                    ((a + 2 * m) * (a + 2 * m + 1));
+            d = 1.0 + numerator * d;
+            d = 1.0 / (fabs(d) < BETA_TINY ? BETA_TINY : d);
+            c = 1.0 + numerator / c;
+            c = fabs(c) < BETA_TINY ? BETA_TINY : c;
+            fraction *= c * d;
+            if (step == 1 && fabs(c * d - 1.0) < BETA_EPSILON) {
+                return front * fraction;
+            }
+        }
+    }
+    return front * fraction;
+}
+
+/**
+* Returns the probability that Student's t with the specified degrees of
+* freedom is at least |t| in either direction.
+*   - t, the statistic
+*   - freedom, the degrees of freedom
+*/
+double two_sided_p(double t, double freedom) {
+    return incomplete_beta(freedom / (freedom + t * t), freedom / 2.0, 0.5);
+}
+
+/**
+* Returns the t with the specified two sided p, by bisection.
+*   - p, the probability of exceeding t in either direction
+*   - freedom, the degrees of freedom
+*/
+double t_quantile(double p, double freedom) {
+    double low = 0.0;
+    double high = QUANTILE_UPPER_BOUND;
+    for (int i = 0; i < QUANTILE_ITERATIONS; i++) {
+        double middle = (low + high) / 2.0;
+        if (two_sided_p(middle, freedom) > p) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return (low + high) / 2.0;
+}
+
+/**
+* Returns the mean and sample standard deviation of the samples.
+*   - samples, the samples
+*   - count, the number of samples, at least 2
+*/
+Summary summarise(const double* samples, int count) {
+    Summary summary = {0.0, 0.0, count};
+    for (int i = 0; i < count; i++) {
+        summary.mean += samples[i];
+    }
+    summary.mean /= count;
+    for (int i = 0; i < count; i++) {
+        summary.deviation += (samples[i] - summary.mean) *
+                (samples[i] - summary.mean);
+    }
+    summary.deviation = sqrt(summary.deviation / (count - 1));
+    return summary;
+}
+
+/**
+* Prints the mean of the samples with its confidence interval.
+*   - label, what the samples are of
+*   - summary, the summary of the samples
+*/
+void print_interval(const char* label, Summary summary) {
+    double halfWidth = t_quantile(SIGNIFICANCE_LEVEL, summary.count - 1) *
+            summary.deviation / sqrt(summary.count);
+    printf("%s %.2f games/s, %d%% CI %.2f to %.2f, %d rounds\n", label,
+            summary.mean, CONFIDENCE_PERCENT, summary.mean - halfWidth,
+            summary.mean + halfWidth, summary.count);
+}
+
+/**
+* Plays every game the specified number of rounds, checking each transcript
+* against the recording. The games per second of each round is a sample,
+* and samples are appended to the samples file if there is one. Returns the
+* number of transcripts that did not match.
+*   - games, the games
+*   - numberOfGames, the number of games
+*   - transcript, a scratch file for transcripts
+*   - rounds, the number of rounds
+*   - samplesPath, the file to append samples to, or NULL
+*/
+int run_corpus(CorpusGame* games, int numberOfGames, int transcript,
+        int rounds, const char* samplesPath) {
+    double* samples = malloc(sizeof(double) * rounds);
+    int mismatches = 0;
+    for (int round = 0; round < rounds; round++) {
+        double seconds = 0.0;
+        for (int i = 0; i < numberOfGames; i++) {
+            seconds += play_corpus_game(&games[i], transcript);
+            if (!matches_golden(&games[i], transcript)) {
+                if (round == 0) {
+                    fprintf(stderr, "Transcript of %s differs\n",
+                            games[i].name);
+                }
+                mismatches++;
+            }
+        }
+        samples[round] = numberOfGames / seconds;
+    }
+    printf("Games %d, rounds %d, mismatched transcripts %d\n", numberOfGames,
+            rounds, mismatches);
+    if (rounds > 1) {
+        print_interval("Throughput", summarise(samples, rounds));
+    } else {
+        printf("Throughput %.2f games/s\n", samples[0]);
+    }
+    if (samplesPath != NULL) {
+        FILE* samplesFile = fopen(samplesPath, "a");
+        if (samplesFile == NULL) {
+            exit_program(IO_FAILURE);
+        }
+        for (int round = 0; round < rounds; round++) {
+            fprintf(samplesFile, "%.6f\n", samples[round]);
+        }
+        fclose(samplesFile);
+    }
+    free(samples);
+    return mismatches;
+}
+
+/**
+* Reads the samples in a samples file, one number per line. Exits if there
+* are fewer than two.
+*   - path, the samples file
+*   - samples, where to store the samples, MAX_SAMPLES in size
+*/
+int read_samples(const char* path, double* samples) {
+    FILE* samplesFile = fopen(path, "r");
+    if (samplesFile == NULL) {
+        exit_program(INVALID_SAMPLES);
+    }
+    int count = 0;
+    while (count < MAX_SAMPLES &&
+            fscanf(samplesFile, "%lf", &samples[count]) == 1) {
+        count++;
+    }
+    fclose(samplesFile);
+    if (count < 2) {
+        exit_program(INVALID_SAMPLES);
+    }
+    return count;
+}
+
+/**
+* Compares the samples of two builds with Welch's t-test, which does not
+* assume the two have the same variance, and prints whether the difference
+* in throughput is significant.
+*   - beforePath, the samples of the earlier build
+*   - afterPath, the samples of the later build
+*/
+void compare_samples(const char* beforePath, const char* afterPath) {
+    static double beforeSamples[MAX_SAMPLES];
+    static double afterSamples[MAX_SAMPLES];
+    Summary before = summarise(beforeSamples,
+            read_samples(beforePath, beforeSamples));
+    Summary after = summarise(afterSamples,
+            read_samples(afterPath, afterSamples));
+    print_interval("Before", before);
+    print_interval("After", after);
+    double beforeVariance = before.deviation * before.deviation / before.count;
+    double afterVariance = after.deviation * after.deviation / after.count;
+    double error = sqrt(beforeVariance + afterVariance);
+    if (error == 0.0) {
+        printf("Change %+.2f%%, no variance to test\n",
+                (after.mean / before.mean - 1.0) * PERCENT);
+        return;
+    }
+    double t = (after.mean - before.mean) / error;
+    double freedom = (beforeVariance + afterVariance) *
+            (beforeVariance + afterVariance) /
+            (beforeVariance * beforeVariance / (before.count - 1) +
+            afterVariance * afterVariance / (after.count - 1));
+    double p = two_sided_p(t, freedom);
+    printf("Change %+.2f%%, Welch t %.3f, df %.1f, p %.4f, %s\n",
+            (after.mean / before.mean - 1.0) * PERCENT, t, freedom, p,
+            p < SIGNIFICANCE_LEVEL ? (t < 0 ? "significantly slower" :
+            "significantly faster") : "not significant");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    const char* mode = argv[CORPUS_MODE_ARGUMENT_INDEX];
+    if (strcmp(mode, "compare") == 0) {
+        if (argc != COMPARE_ARGS) {
+            exit_program(INVALID_ARGUMENTS);
+        }
+        compare_samples(argv[COMPARE_BEFORE_ARGUMENT_INDEX],
+                argv[COMPARE_AFTER_ARGUMENT_INDEX]);
+        exit_program(SUCCESS);
+    }
+    bool recording = strcmp(mode, "record") == 0;
+    bool allocations = strcmp(mode, "allocations") == 0;
+    if (!(recording && argc == RECORD_ARGS) &&
+            !(allocations && argc == ALLOCATIONS_ARGS) &&
+            !(strcmp(mode, "run") == 0 && argc >= RUN_MIN_ARGS &&
+            argc <= RUN_MAX_ARGS)) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    static CorpusGame games[MAX_GAMES];
+    int numberOfGames = read_corpus(argv[CORPUS_DIRECTORY_ARGUMENT_INDEX],
+            argv[CORPUS_BIN_ARGUMENT_INDEX], games, recording);
+    FILE* scratch = tmpfile();
+    if (scratch == NULL) {
+        exit_program(IO_FAILURE);
+    }
+    int transcript = fileno(scratch);
+    if (recording) {
+        record_corpus(argv[CORPUS_DIRECTORY_ARGUMENT_INDEX], games,
+                numberOfGames, transcript);
+        exit_program(SUCCESS);
+    }
+    if (allocations) {
+        if (check_allocations(games, numberOfGames, transcript) > 0) {
+            exit_program(TURN_ALLOCATIONS);
+        }
+        exit_program(SUCCESS);
+    }
+    char* roundsError;
+    long rounds = strtol(argv[CORPUS_ROUNDS_ARGUMENT_INDEX], &roundsError,
+            BASE_FOR_INTEGER_CONVERSION);
+    if (*roundsError != '\0' || rounds < 1 || rounds > MAX_SAMPLES) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    int mismatches = run_corpus(games, numberOfGames, transcript, (int)rounds,
+            argc == RUN_MAX_ARGS ? argv[CORPUS_SAMPLES_ARGUMENT_INDEX] :
+            NULL);
+    if (mismatches > 0) {
+        exit_program(TRANSCRIPT_MISMATCH);
+    }
+    exit_program(SUCCESS);
+    return 0;
+}
@@ -10,20 +10,23 @@
 *   - rollFile, the roll file containing the latest rolls
 */
 void reroll(Game* game, Player** players, RollFile* rollFile) {
-    if (rollFile->latestDice->numberOfOnes < REROLL_NUMBER_DICE_THRESHOLD) {
+    int numberDiceThreshold = strategy_threshold(
+            "EAIT_REROLL_NUMBER_DICE_THRESHOLD", REROLL_NUMBER_DICE_THRESHOLD);
+    if (rollFile->latestDice->numberOfOnes < numberDiceThreshold) {
         rollFile->rerollDice->numberOfOnes = 
                 rollFile->latestDice->numberOfOnes;
     }
-    if (rollFile->latestDice->numberOfTwos < REROLL_NUMBER_DICE_THRESHOLD) {
+    if (rollFile->latestDice->numberOfTwos < numberDiceThreshold) {
         rollFile->rerollDice->numberOfTwos = 
                 rollFile->latestDice->numberOfTwos;
     }
-    if (rollFile->latestDice->numberOfThrees < REROLL_NUMBER_DICE_THRESHOLD) {
+    if (rollFile->latestDice->numberOfThrees < numberDiceThreshold) {
         rollFile->rerollDice->numberOfThrees = 
                 rollFile->latestDice->numberOfThrees;
     }
     if (players[game->currentPlayerNumber]->health > 
-            REROLL_HEALTH_THRESHOLD) {
+            strategy_threshold("EAIT_REROLL_HEALTH_THRESHOLD",
+            REROLL_HEALTH_THRESHOLD)) {
         rollFile->rerollDice->numberOfHs = rollFile->latestDice->numberOfHs;
     }
     rollFile->rerollDice->numberOfAs = rollFile->latestDice->numberOfAs;
@@ -46,8 +49,32 @@ void reroll(Game* game, Player** players, RollFile* rollFile) {
 */
 bool retreat(Game* game, Player** players) {
     if (players[game->currentPlayerNumber]->health < 
-            RETREAT_HEALTH_THRESHOLD) {
+            strategy_threshold("EAIT_RETREAT_HEALTH_THRESHOLD",
+            RETREAT_HEALTH_THRESHOLD)) {
         return true;
     }
     return false;
 }
+
+/**
+* Writes the policy the hub can play for this player and returns true. Rows
+* are "123HAP" for low and high health, outside then inside St Lucia. 'H's
+* are rerolled above the reroll health threshold, so from one more than it.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - policy, the policy message to write
+*/
+bool describe_policy(Game* game, Player** players, char* policy) {
+    int numbers = policy_value(strategy_threshold(
+            "EAIT_REROLL_NUMBER_DICE_THRESHOLD", REROLL_NUMBER_DICE_THRESHOLD),
+            POLICY_ALWAYS - POLICY_NEVER);
+    char rows[POLICY_ROW_LENGTH + 1];
+    sprintf(rows, "%d%d%d077%d%d%d777", numbers, numbers, numbers, numbers,
+            numbers, numbers);
+    sprintf(policy, "policy %02d %s %s %02d",
+            policy_value(strategy_threshold("EAIT_REROLL_HEALTH_THRESHOLD",
+            REROLL_HEALTH_THRESHOLD) + 1, POLICY_MAX_THRESHOLD), rows, rows,
+            policy_value(strategy_threshold("EAIT_RETREAT_HEALTH_THRESHOLD",
+            RETREAT_HEALTH_THRESHOLD), POLICY_MAX_THRESHOLD));
+    return true;
+}
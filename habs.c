@@ -11,7 +11,8 @@
 */
 void reroll(Game* game, Player** players, RollFile* rollFile) {
     if (players[game->currentPlayerNumber]->health < 
-            REROLL_HEALTH_THRESHOLD) {
+            strategy_threshold("HABS_REROLL_HEALTH_THRESHOLD",
+            REROLL_HEALTH_THRESHOLD)) {
         rollFile->rerollDice->numberOfAs = rollFile->latestDice->numberOfAs;
     }
     if (sum_dice_set(rollFile->rerollDice) == 0) {
@@ -31,12 +32,30 @@ void reroll(Game* game, Player** players, RollFile* rollFile) {
 */
 bool retreat(Game* game, Player** players) {
     if (players_remaining(game, players) == 
-            RETREAT_REMAINING_PLAYERS_THRESHOLD) {
+            strategy_threshold("HABS_RETREAT_REMAINING_PLAYERS_THRESHOLD",
+            RETREAT_REMAINING_PLAYERS_THRESHOLD)) {
         return false;
     }
     if (players[game->currentPlayerNumber]->health <
-            RETREAT_HEALTH_THRESHOLD) {
+            strategy_threshold("HABS_RETREAT_HEALTH_THRESHOLD",
+            RETREAT_HEALTH_THRESHOLD)) {
         return true;
     }
     return false;
 }
+
+/**
+* Writes the policy the hub can play for this player and returns true. Rows
+* are "123HAP" for low and high health, outside then inside St Lucia. Retreats
+* depend on the players remaining, so are left to the player.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - policy, the policy message to write
+*/
+bool describe_policy(Game* game, Player** players, char* policy) {
+    sprintf(policy, "policy %02d 000070000000 000070000000 %s",
+            policy_value(strategy_threshold("HABS_REROLL_HEALTH_THRESHOLD",
+            REROLL_HEALTH_THRESHOLD), POLICY_MAX_THRESHOLD),
+            POLICY_INTERACTIVE);
+    return true;
+}
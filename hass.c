@@ -44,3 +44,17 @@ void reroll(Game* game, Player** players, RollFile* rollFile) {
 bool retreat(Game* game, Player** players) {
     return false;
 }
+
+/**
+* Writes the policy the hub can play for this player and returns true. Rows
+* are "123HAP" for low and high health, outside then inside St Lucia; 'A's 
+* outside are kept only when enough to kill the player in St Lucia.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - policy, the policy message to write
+*/
+bool describe_policy(Game* game, Player** players, char* policy) {
+    sprintf(policy, "policy 00 7777%c77777%c7 777770777770 00",
+            POLICY_UNLESS_FATAL, POLICY_UNLESS_FATAL);
+    return true;
+}
@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "shared.h"
+#include "history.h"
+#include "allocations.h"
+
+/* Constants used in detecting repeated game states */
+#define STATE_FIELDS_PER_PLAYER 4
+#define STATE_FIELDS_PER_GAME 3
+#define INITIAL_HISTORY_CAPACITY 64
+#define EMPTY_HISTORY_SLOT -1
+
+/**
+* Writes the state of the game at the start of the active player's turn into
+* the specified array of history->stateLength ints.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - activePlayer, the player who is about to have their turn
+*   - state, the array to write the state into
+*/
+void capture_game_state(Game* game, Player** players, int activePlayer,
+        int* state) {
+    int field = 0;
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        state[field++] = players[i]->health;
+        state[field++] = players[i]->points;
+        state[field++] = players[i]->tokens;
+        state[field++] = (int)players[i]->status;
+    }
+    state[field++] = game->playerInStLucia;
+    state[field++] = activePlayer;
+    state[field++] = game->rollFile->index;
+}
+
+/**
+* Returns the combined points, tokens and eliminations of the players. This
+* never decreases, and is unchanged only if no player's points, tokens or
+* status has changed.
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+int game_progress(Game* game, Player** players) {
+    int progress = 0;
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        progress += players[i]->points * TOKENS_POINTS_THRESHOLD +
+                players[i]->tokens;
+        if (players[i]->status == ELIMINATED) {
+            progress++;
+        }
+    }
+    return progress;
+}
+
+/**
+* Empties the state history, allocating it the first time it is used.
+*   - history, the state history
+*   - game, a struct of the game state
+*/
+void reset_state_history(StateHistory* history, Game* game) {
+    if (history->states == NULL) {
+        history->stateLength = game->numberOfPlayers *
+                STATE_FIELDS_PER_PLAYER + STATE_FIELDS_PER_GAME;
+        history->capacity = INITIAL_HISTORY_CAPACITY;
+        history->states = malloc(sizeof(int) * history->capacity *
+                history->stateLength);
+        history->hashes = malloc(sizeof(unsigned long long) *
+                history->capacity);
+        history->slots = malloc(sizeof(int) * history->capacity * 2);
+    }
+    history->size = 0;
+    for (int i = 0; i < history->capacity * 2; i++) {
+        history->slots[i] = EMPTY_HISTORY_SLOT;
+    }
+}
+
+/**
+* Empties the state history at the start of a game.
+*   - history, the state history
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+void start_state_history(StateHistory* history, Game* game,
+        Player** players) {
+    reset_state_history(history, game);
+    history->progress = game_progress(game, players);
+}
+
+/**
+* Returns the hash table slot holding the specified state, or the empty slot
+* where it would be inserted.
+*   - history, the state history
+*   - state, the state to look up
+*   - hash, the Zobrist hash of the state
+*/
+int find_history_slot(StateHistory* history, int* state,
+        unsigned long long hash) {
+    int mask = history->capacity * 2 - 1;
+    int slot = (int)(hash & (unsigned)mask);
+    while (history->slots[slot] != EMPTY_HISTORY_SLOT) {
+        int* recorded = history->states +
+                history->slots[slot] * history->stateLength;
+        if (memcmp(recorded, state,
+                sizeof(int) * history->stateLength) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+* Doubles the capacity of the state history and rebuilds its hash table. The
+* history only grows while no progress is made, a logarithmic number of
+* times however long that lasts, so it is the one allocation turns may make.
+*   - history, the state history
+*/
+void grow_state_history(StateHistory* history) {
+    AllocationPhase phase = set_allocation_phase(PHASE_GROWTH);
+    history->capacity *= 2;
+    history->states = realloc(history->states,
+            sizeof(int) * history->capacity * history->stateLength);
+    history->hashes = realloc(history->hashes,
+            sizeof(unsigned long long) * history->capacity);
+    history->slots = realloc(history->slots,
+            sizeof(int) * history->capacity * 2);
+    for (int i = 0; i < history->capacity * 2; i++) {
+        history->slots[i] = EMPTY_HISTORY_SLOT;
+    }
+    for (int i = 0; i < history->size; i++) {
+        int* state = history->states + i * history->stateLength;
+        history->slots[find_history_slot(history, state,
+                history->hashes[i])] = i;
+    }
+    set_allocation_phase(phase);
+}
+
+/**
+* Records the state of the game at the start of the active player's turn.
+* Returns true if the game has been in exactly this state before, in which
+* case the deterministic players and roll file will repeat it forever. The
+* state is hashed in constant time from the game's Zobrist hash.
+*   - history, the state history
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - activePlayer, the player who is about to have their turn
+*/
+bool is_repeated_state(StateHistory* history, Game* game, Player** players,
+        int activePlayer) {
+    int progress = game_progress(game, players);
+    if (progress != history->progress) {
+        reset_state_history(history, game);
+        history->progress = progress;
+    }
+    if (history->size == history->capacity) {
+        grow_state_history(history);
+    }
+    int* state = history->states + history->size * history->stateLength;
+    capture_game_state(game, players, activePlayer, state);
+    unsigned long long hash = game->stateHash ^ zobrist_key(ZOBRIST_TURN,
+            activePlayer, game->rollFile->index);
+    int slot = find_history_slot(history, state, hash);
+    if (history->slots[slot] != EMPTY_HISTORY_SLOT) {
+        return true;
+    }
+    history->hashes[history->size] = hash;
+    history->slots[slot] = history->size;
+    history->size++;
+    return false;
+}
+
+/**
+* Frees the memory of the state history.
+*   - history, the state history
+*/
+void free_state_history(StateHistory* history) {
+    free(history->states);
+    free(history->hashes);
+    free(history->slots);
+    history->states = NULL;
+    history->hashes = NULL;
+    history->slots = NULL;
+}
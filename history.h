@@ -0,0 +1,35 @@
+#include <stdbool.h>
+#include "shared.h"
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/**
+* A struct for recording the game states seen at turn boundaries since any
+* player last gained points or tokens or was eliminated. Those only ever
+* increase, so no earlier state can repeat.
+*   - size, the number of states recorded
+*   - capacity, the number of states that fit in the allocated memory
+*   - stateLength, the number of ints in each state
+*   - progress, the combined points, tokens and eliminations of the states
+*   - states, the recorded states, stateLength ints each
+*   - hashes, the Zobrist hash of each recorded state
+*   - slots, a hash table of indices into states, twice capacity in size
+*/
+typedef struct {
+    int size;
+    int capacity;
+    int stateLength;
+    int progress;
+    int* states;
+    unsigned long long* hashes;
+    int* slots;
+} StateHistory;
+
+/* Function prototypes */
+void start_state_history(StateHistory* history, Game* game,
+        Player** players);
+bool is_repeated_state(StateHistory* history, Game* game, Player** players,
+        int activePlayer);
+void free_state_history(StateHistory* history);
+#endif
@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include "queue.h"
+#include "hosted.h"
+
+/* The status of a hosted player is returned through longjmp(), which cannot
+pass 0, so it is offset by this */
+#define EXIT_STATUS_OFFSET 1
+
+__thread FILE* hostedInput;
+__thread FILE* hostedOutput;
+__thread FILE* hostedError;
+
+/* Where hosted_exit() returns to on this thread */
+__thread jmp_buf hostedExit;
+
+/**
+* Ends the player running on this thread, returning the status from
+* hosted_run() in place of exiting the process.
+*   - status, the exit status of the player
+*/
+void hosted_exit(int status) {
+    longjmp(hostedExit, status + EXIT_STATUS_OFFSET);
+}
+
+/**
+* Runs the player's main() on the calling thread with its standard input and
+* output on the specified queues, and its standard error discarded as the
+* hub does for player processes. Returns the player's exit status. The
+* player's output queue is closed on return, which the hub sees as the end
+* of the pipe.
+*   - input, the queue of messages from the hub
+*   - output, the queue of messages to the hub
+*   - argc, argv, the arguments of the player
+*/
+int hosted_run(ByteQueue* input, ByteQueue* output, int argc, char** argv) {
+    hostedInput = open_queue(input, "r");
+    hostedOutput = open_queue(output, "w");
+    hostedError = fopen("/dev/null", "w");
+    if (hostedInput == NULL || hostedOutput == NULL || hostedError == NULL) {
+        queue_close(input);
+        queue_close(output);
+        return EXIT_FAILURE;
+    }
+    int status = setjmp(hostedExit);
+    if (status == 0) {
+        status = hosted_main(argc, argv);
+    } else {
+        status -= EXIT_STATUS_OFFSET;
+    }
+    fclose(hostedOutput);
+    fclose(hostedInput);
+    fclose(hostedError);
+    return status;
+}
@@ -0,0 +1,35 @@
+/* Forced into every source of a hosted faculty with -include hosted.h, so an
+unmodified player can run on a thread of the hub. The player's standard
+streams become queues to the hub, exiting returns from its thread, and the
+signal handlers it installs are left to the hub. */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "queue.h"
+
+#ifndef HOSTED_H
+#define HOSTED_H
+
+/* The streams and exit of the player running on this thread */
+extern __thread FILE* hostedInput;
+extern __thread FILE* hostedOutput;
+extern __thread FILE* hostedError;
+
+#undef stdin
+#undef stdout
+#undef stderr
+#define main hosted_main
+#define stdin hostedInput
+#define stdout hostedOutput
+#define stderr hostedError
+#define exit(status) hosted_exit(status)
+#define sigaction(signal, action, previous) ((void)(action))
+
+/* Function prototypes */
+int hosted_main(int argc, char** argv);
+void hosted_exit(int status) __attribute__((noreturn));
+int hosted_run(ByteQueue* input, ByteQueue* output, int argc, char** argv);
+#endif
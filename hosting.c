@@ -0,0 +1,155 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <link.h>
+#include <pthread.h>
+#include "shared.h"
+#include "queue.h"
+#include "hosting.h"
+
+#define HOSTED_ENTRY_POINT "hosted_run"
+#define HOSTED_ARGUMENT_COUNT 3
+#define MAX_ARGUMENT_LENGTH 4
+
+/**
+* A struct for a player hosted on a thread of the hub.
+*   - run, the hosted_run() of the faculty's library
+*   - toPlayer, the queue of messages to the player
+*   - fromPlayer, the queue of messages from the player
+*   - arguments, the player's argument strings
+*   - argv, the player's arguments
+*   - thread, the thread running the player
+*   - status, the player's exit status, once it has returned
+*/
+typedef struct {
+    int (*run)(ByteQueue*, ByteQueue*, int, char**);
+    ByteQueue* toPlayer;
+    ByteQueue* fromPlayer;
+    char arguments[HOSTED_ARGUMENT_COUNT - 1][MAX_ARGUMENT_LENGTH];
+    char* argv[HOSTED_ARGUMENT_COUNT + 1];
+    pthread_t thread;
+    int status;
+} HostedPlayer;
+
+/* The hosted players, indexed by player number */
+HostedPlayer hostedSeats[MAX_PLAYERS];
+
+/**
+* Runs a hosted player to completion.
+*   - argument, the HostedPlayer
+*/
+void* run_hosted_player(void* argument) {
+    HostedPlayer* hosted = argument;
+    hosted->status = hosted->run(hosted->toPlayer, hosted->fromPlayer,
+            HOSTED_ARGUMENT_COUNT, hosted->argv);
+    return NULL;
+}
+
+/**
+* Loads the faculty's shared library, the faculty path with
+* HOSTED_LIBRARY_SUFFIX appended. Returns NULL if it cannot be loaded.
+*   - faculty, the faculty as given on the command line
+*/
+void* load_hosted_library(char* faculty) {
+    char* path = malloc(strlen(faculty) + strlen(HOSTED_LIBRARY_SUFFIX) + 1);
+    if (path == NULL) {
+        return NULL;
+    }
+    sprintf(path, "%s%s", faculty, HOSTED_LIBRARY_SUFFIX);
+    void* library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    free(path);
+    return library;
+}
+
+/**
+* Finds the file the faculty's shared library is loaded from, searching the
+* same way host_player() does. Returns false if it cannot be loaded.
+*   - faculty, the faculty as given on the command line
+*   - path, where to store the path of the library
+*   - size, the size of path
+*/
+bool find_hosted_library(char* faculty, char* path, size_t size) {
+    void* library = load_hosted_library(faculty);
+    struct link_map* map;
+    if (library == NULL || dlinfo(library, RTLD_DI_LINKMAP, &map) != 0) {
+        return false;
+    }
+    snprintf(path, size, "%s", map->l_name);
+    return true;
+}
+
+/**
+* Loads the player's faculty as a shared library and starts it on its own
+* thread, connected to the hub by in-memory queues in place of pipes. Returns
+* false if the library or queues cannot be set up. The library is the
+* faculty path with HOSTED_LIBRARY_SUFFIX appended, built from the same
+* sources as the executable with -include hosted.h.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - playerNumber, the number of the player to host
+*/
+bool host_player(Game* game, Player** players, int playerNumber) {
+    HostedPlayer* hosted = &hostedSeats[playerNumber];
+    char* faculty = players[playerNumber]->faculty;
+    void* library = load_hosted_library(faculty);
+    if (library == NULL) {
+        return false;
+    }
+    *(void**)&hosted->run = dlsym(library, HOSTED_ENTRY_POINT);
+    hosted->toPlayer = calloc(1, sizeof(ByteQueue));
+    hosted->fromPlayer = calloc(1, sizeof(ByteQueue));
+    if (hosted->run == NULL || hosted->toPlayer == NULL ||
+            hosted->fromPlayer == NULL) {
+        return false;
+    }
+    if ((players[playerNumber]->inbox = open_queue(hosted->toPlayer,
+            "w")) == NULL) {
+        return false;
+    }
+    setvbuf(players[playerNumber]->inbox, NULL, _IONBF, 0);
+    if ((players[playerNumber]->outbox = open_queue(hosted->fromPlayer,
+            "r")) == NULL) {
+        return false;
+    }
+
+    sprintf(hosted->arguments[0], "%d", game->numberOfPlayers);
+    sprintf(hosted->arguments[1], "%c", players[playerNumber]->playerToken);
+    hosted->argv[0] = faculty;
+    hosted->argv[1] = hosted->arguments[0];
+    hosted->argv[2] = hosted->arguments[1];
+    hosted->argv[HOSTED_ARGUMENT_COUNT] = NULL;
+    return pthread_create(&hosted->thread, NULL, run_hosted_player,
+            hosted) == 0;
+}
+
+/**
+* Waits up to the specified time for a hosted player to return, as the hub
+* waits for player processes, then closes its streams. Returns false if it
+* has not returned.
+*   - players, an array of players
+*   - playerNumber, the number of the hosted player
+*   - seconds, the longest time to wait
+*   - status, set to the player's exit status
+*/
+bool join_hosted_player(Player** players, int playerNumber, int seconds,
+        int* status) {
+    HostedPlayer* hosted = &hostedSeats[playerNumber];
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += seconds;
+    if (pthread_timedjoin_np(hosted->thread, NULL, &deadline) != 0) {
+        return false;
+    }
+    *status = hosted->status;
+    fclose(players[playerNumber]->inbox);
+    fclose(players[playerNumber]->outbox);
+    players[playerNumber]->inbox = NULL;
+    players[playerNumber]->outbox = NULL;
+    free(hosted->toPlayer);
+    free(hosted->fromPlayer);
+    return true;
+}
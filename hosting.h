@@ -0,0 +1,15 @@
+#include <stdbool.h>
+#include "shared.h"
+
+#ifndef HOSTING_H
+#define HOSTING_H
+
+/* Hosted faculties are loaded from the faculty path with this suffix */
+#define HOSTED_LIBRARY_SUFFIX ".so"
+
+/* Function prototypes */
+bool find_hosted_library(char* faculty, char* path, size_t size);
+bool host_player(Game* game, Player** players, int playerNumber);
+bool join_hosted_player(Player** players, int playerNumber, int seconds,
+        int* status);
+#endif
@@ -1,14 +1,30 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <poll.h>
+#include <time.h>
 #include "shared.h"
+#include "hosting.h"
+#include "remote.h"
+#include "spectate.h"
+#include "allocations.h"
+#include "rollstream.h"
+#include "affinity.h"
+#include "uring.h"
+#include "history.h"
+
+/* The environment, whose settings are part of a cache entry's key */
+extern char** environ;
 
 /* Argument information for the St Lucia hub */
 #define HUB_MIN_ARGS 5
@@ -22,22 +38,60 @@
 #define PIPE_INPUT 1
 #define PIPE_OUTPUT 0
 
-/* Constants used in calculating points */
-#define STARTING_IN_STLUCIA_POINTS 2
-#define TOKENS_POINTS_THRESHOLD 10
-#define DICE_POINTS_THRESHOLD 2
-#define ONES_DICE_POINT_PENALTY 2
-#define TWOS_DICE_POINT_PENALTY 1
-#define THREES_DICE_POINT_PENALTY 0
-
 #define REROLLED_DICE_ROLL_INDEX 1
 
+/* Constants used by the on-disk result cache */
+#define CACHE_DIRECTORY_VARIABLE "STLUCIA_CACHE"
+#define CACHE_KEY_LENGTH 16
+#define CACHE_PATH_LENGTH 4096
+#define CACHE_READ_BUFFER_SIZE 4096
+#define CACHE_DIRECTORY_MODE 0755
+#define NO_CACHED_RESULT -1
+#define CACHED_DRAW "draw"
+#define CACHE_ENTRY_MODE 0644
+
+/* Entries hold the game's transcript followed by its result, a format that
+is part of the key so entries holding only a result are never replayed */
+#define CACHE_FORMAT "transcript"
+
+/* Players are run on threads of the hub when this variable is set */
+#define HOSTED_VARIABLE "STLUCIA_HOSTED"
+#define HOSTED_WAIT_SECONDS 2
+
+/* Players that fail during the game are eliminated rather than ending it
+when this variable is set */
+#define TOLERATE_FAILURES_VARIABLE "STLUCIA_TOLERATE_FAILURES"
+
+#define MILLISECONDS_PER_SECOND 1000
+#define NANOSECONDS_PER_MILLISECOND 1000000
+
+/* The winner run_game() returns for a game that started repeating itself */
+#define GAME_DRAWN -2
+
 /* A global variable for the game, needed by the SIGINT handler. */
 Game* game;
 
 /* A global variable for the players, needed by the SIGINT handler. */
 Player** players;
 
+/* Whether players are hosted on threads rather than run as processes */
+bool hostingEnabled = false;
+
+/* Whether messages to and from players go through io_uring rather than stdio */
+bool uringEnabled = false;
+
+/* Whether a player that fails is eliminated rather than ending the game */
+bool toleranceEnabled = false;
+
+/* Whether a player has been eliminated for failing, so the result depends on
+more than the roll file and faculties and is not cached */
+bool playerFailed = false;
+
+/* The cache entry being written as the game is played, which stderr is
+copied to, or -1, and the temporary path it is written at */
+int cacheEntryFd = -1;
+char cacheTemporaryPath[CACHE_PATH_LENGTH];
+
 /** 
  * An enum for the different exit codes
  *   - SUCCESS, normal exit due to game over
@@ -52,6 +106,8 @@ Player** players;
  *   - INVALID_REQUEST, one of the players sent a properly formed message 
  *   but it was not a legal action
  *   - SIGINT_ACTION, hub received SIGINT	
+ *   - DRAW_BY_REPETITION, the game reached a state it had already been in, 
+ *   so would never end
  */
 typedef enum {
     SUCCESS = 0,
@@ -63,13 +119,34 @@ typedef enum {
     PLAYER_QUIT = 6,
     INVALID_MESSAGE = 7,
     INVALID_REQUEST = 8,
-    SIGINT_ACTION = 9
+    SIGINT_ACTION = 9,
+    DRAW_BY_REPETITION = 10
 } ExitCodes;
 
+/* A global variable for the state history, freed when the program exits. */
+StateHistory history;
+
+
+/**
+* Sends the message specified to one player. Through io_uring the message is
+* queued, and written with every other queued message when the hub next 
+* waits for a reply or the game ends.
+*   - players, an array of players
+*   - playerNumber, the player to send the message to
+*   - message, the message to send
+*/
+void send_player_message(Player** players, int playerNumber, char* message) {
+    if (uringEnabled) {
+        queue_ring_message(playerNumber, message, strlen(message));
+        return;
+    }
+    fputs(message, players[playerNumber]->inbox);
+    fflush(players[playerNumber]->inbox);
+}
 
 /**
-* Sends the message specified to all players. Will not send the message to
-* eliminated players.
+* Sends the message specified to all players, and publishes it to any 
+* spectators. Will not send the message to eliminated players.
 *   - game, a struct of the game state
 *   - players, an array of players
 *   - activePlayer, the player who is currently having their turn
@@ -79,6 +156,7 @@ typedef enum {
 */
 void alert_remaining_players(Game* game, Player** players, int activePlayer, 
         char* message, bool skipActivePlayer) {
+    publish_event(message);
     for (int i = 0; i < game->numberOfPlayers; i++) {
         if (players[i]->status != REMAINING) {
             continue;
@@ -89,8 +167,7 @@ void alert_remaining_players(Game* game, Player** players, int activePlayer,
         if (players[i]->inbox == NULL) {
             continue;
         }
-        fprintf(players[i]->inbox, message);
-        fflush(players[i]->inbox);
+        send_player_message(players, i, message);
     }
 }
 
@@ -106,8 +183,24 @@ void close_remaining_players(Game* game, Player** players,
         char shutDown[MAX_MESSAGE_LENGTH];
         sprintf(shutDown, "shutdown\n");
         alert_remaining_players(game, players, 0, shutDown, false);
+        if (uringEnabled) {
+            flush_ring();
+        }
 
         for (int i = 0; i < game->numberOfPlayers; i++) {
+            if (players[i]->status == UNCONNECTED ||
+                    is_remote_faculty(players[i]->faculty)) {
+                continue;
+            }
+            if (hostingEnabled) {
+                int hostedStatus;
+                if (join_hosted_player(players, i, HOSTED_WAIT_SECONDS,
+                        &hostedStatus) && hostedStatus) {
+                    fprintf(stderr, "Player %c exited with status %d\n",
+                            get_player_label(i), hostedStatus);
+                }
+                continue;
+            }
             int childStatus;
             alarm(2); // stop waiting after 2 seconds
             waitpid(players[i]->pid, &childStatus, 0);
@@ -128,15 +221,11 @@ void close_remaining_players(Game* game, Player** players,
 }
 
 /**
-* Exits the game, with the specified exit status and a message.
-*   - game, a struct of the game state
-*   - players, an array of players
-*   - exitStatus, the status to exit with
+* Returns the message the hub prints to stderr when exiting with the specified
+* exit status.
+*   - exitStatus, the exit status
 */
-void exit_program(Game* game, Player** players, ExitCodes exitStatus) {
-    close_remaining_players(game, players, exitStatus);
-    free_allocated_memory(game, players);
-
+char* get_exit_message(ExitCodes exitStatus) {
     char* errorString;
     switch (exitStatus) {
         case SUCCESS:
@@ -170,14 +259,150 @@ void exit_program(Game* game, Player** players, ExitCodes exitStatus) {
         case SIGINT_ACTION:
             errorString = "SIGINT_ACTION caught\n";
             break;
+        case DRAW_BY_REPETITION:
+            errorString = "Game drawn by repetition\n";
+            break;
+    }
+    return errorString;
+}
+
+/**
+* Stops copying stderr to the cache entry being written.
+*   - removeEntry, whether to remove the unfinished entry, false in a child
+*       process so the hub's entry is left alone
+*/
+void discard_cached_transcript(bool removeEntry) {
+    if (cacheEntryFd < 0) {
+        return;
+    }
+    close(cacheEntryFd);
+    cacheEntryFd = -1;
+    if (removeEntry) {
+        unlink(cacheTemporaryPath);
+    }
+}
+
+/**
+* Exits the game, with the specified exit status and a message.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - exitStatus, the status to exit with
+*/
+void exit_program(Game* game, Player** players, ExitCodes exitStatus) {
+    set_allocation_phase(PHASE_EXIT);
+    discard_cached_transcript(true);
+    if (uringEnabled) {
+        flush_ring();
     }
-    fprintf(stderr, "%s", errorString);
+    close_remaining_players(game, players, exitStatus);
+    free_allocated_memory(game, players);
+    free_state_history(&history);
+
+    fprintf(stderr, "%s", get_exit_message(exitStatus));
+    report_allocations();
     exit((int)exitStatus);
 }
 
 /**
-* Sets up the hub pipe connection to the player specified. Will exit if piping 
-* fails.
+* Handles a player failing during the game by quitting, sending an invalid
+* message or making an invalid request. Exits with the failure's status,
+* unless failures are tolerated, in which case the player is eliminated as
+* if it had lost its last health, with the reason recorded in the
+* transcript, and leaves St Lucia empty if it was there.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - playerNumber, the player that failed
+*   - failure, the status the hub would otherwise exit with
+*/
+void fail_player(Game* game, Player** players, int playerNumber,
+        ExitCodes failure) {
+    if (!toleranceEnabled) {
+        exit_program(game, players, failure);
+    }
+    fprintf(stderr, "Player %c eliminated: %s", get_player_label(playerNumber),
+            get_exit_message(failure));
+    char eliminatedAnnouncement[MAX_MESSAGE_LENGTH];
+    sprintf(eliminatedAnnouncement, "eliminated %c\n",
+            get_player_label(playerNumber));
+    alert_remaining_players(game, players, playerNumber,
+            eliminatedAnnouncement, false);
+    set_player_status(playerNumber, ELIMINATED, game, players);
+    if (game->playerInStLucia == playerNumber) {
+        set_player_in_stlucia(EMPTY_STLUCIA, game);
+    }
+    playerFailed = true;
+}
+
+/**
+* Reads the next reply from the player specified into reply. Policies the
+* player sends ahead of its reply replace its current policy. Returns true if
+* a reply was read, or false if the player has terminated or sent an invalid
+* policy and was eliminated for it (see fail_player()).
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - playerNumber, the player to read from
+*   - reply, where to store the reply, MAX_MESSAGE_LENGTH in size
+*/
+bool read_player_reply(Game* game, Player** players, int playerNumber,
+        char* reply) {
+    char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH];
+    while (true) {
+        bool received = uringEnabled ? read_ring_line(playerNumber, reply,
+                MAX_MESSAGE_LENGTH) : fgets(reply, MAX_MESSAGE_LENGTH, 
+                players[playerNumber]->outbox) != NULL;
+        if (!received) {
+            fail_player(game, players, playerNumber, PLAYER_QUIT);
+            return false;
+        }
+        int numberCommands = interpret_message(reply, commands);
+        if (strcmp(commands[0], "policy") != 0) {
+            return true;
+        }
+        if (!parse_policy(commands, numberCommands, 
+                &players[playerNumber]->policy)) {
+            fail_player(game, players, playerNumber, INVALID_MESSAGE);
+            return false;
+        }
+    }
+}
+
+/**
+* Waits for the player to send '!' once it has started, or '#' followed by 
+* its policy, and marks it as remaining. Will exit if the player ends or 
+* sends anything else.
+*   - players, an array of players containing the desired player
+*   - playerNumber, the number of the player to wait for
+*   - game, a struct of the game state
+*/
+void receive_handshake(Player** players, int playerNumber, Game* game) {
+    //replies are read past stdio once io_uring starts, so none are buffered
+    if (uringEnabled) {
+        setvbuf(players[playerNumber]->outbox, NULL, _IONBF, 0);
+    }
+    char testCharacter;
+    if ((testCharacter = fgetc(players[playerNumber]->outbox)) == EOF) {
+        exit_program(game, players, PIPING_FAILURE);
+    }
+    if (testCharacter == POLICY_HANDSHAKE) {
+        char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH];
+        char policy[MAX_MESSAGE_LENGTH];
+        if (fgets(policy, MAX_MESSAGE_LENGTH, 
+                players[playerNumber]->outbox) == NULL) {
+            exit_program(game, players, PIPING_FAILURE);
+        }
+        if (!parse_policy(commands, interpret_message(policy, commands),
+                &players[playerNumber]->policy)) {
+            exit_program(game, players, PIPING_FAILURE);
+        }
+    } else if (testCharacter != '!') {
+        exit_program(game, players, PIPING_FAILURE); 
+    }
+    set_player_status(playerNumber, REMAINING, game, players);
+}
+
+/**
+* Sets up the hub pipe connection to the player specified, whose handshake is
+* read once every player has started. Will exit if piping fails.
 *   - players, an array of players containing the desired player
 *   - hubPipe, the pipe to be used to send messages from the hub to the player 
 *   - playerPipe, the pipe to be used to send messages from the player to the
@@ -194,6 +419,8 @@ void setup_hub(Player** players, int* hubPipe, int* playerPipe,
             "w")) == NULL) {
         exit_program(game, players, PIPING_FAILURE);
     }
+    //every message is one fprintf, so the inbox needs no buffer of its own
+    setvbuf(players[playerNumber]->inbox, NULL, _IONBF, 0);
     if (close(playerPipe[PIPE_INPUT]) != 0) {
         exit_program(game, players, PIPING_FAILURE);
     }
@@ -201,14 +428,6 @@ void setup_hub(Player** players, int* hubPipe, int* playerPipe,
             "r")) == NULL) {
         exit_program(game, players, PIPING_FAILURE);
     }
-    char testCharacter;
-    if ((testCharacter = fgetc(players[playerNumber]->outbox)) == EOF) {
-        exit_program(game, players, PIPING_FAILURE);
-    }
-    if (testCharacter != '!') {
-        exit_program(game, players, PIPING_FAILURE); 
-    }
-    players[playerNumber]->status = REMAINING;
 }
 
 /**
@@ -222,6 +441,7 @@ void setup_hub(Player** players, int* hubPipe, int* playerPipe,
 */
 void setup_player(Player** players, int* hubPipe, int* playerPipe, 
         int playerNumber, Game* game) {
+    discard_cached_transcript(false);
     if (close(hubPipe[PIPE_INPUT]) != 0) {
         exit_program(game, players, PIPING_FAILURE);
     }
@@ -246,13 +466,103 @@ void setup_player(Player** players, int* hubPipe, int* playerPipe,
 }
 
 /**
-* Sets up the pipe connections from the hub to all players. Will exit if 
-* piping fails.
+* Waits for every player that has not yet shaken hands, accepting remote 
+* players as they connect. Players are served in whatever order they become
+* ready, so a slow player does not hold up the others. Will exit if the
+* players are not all connected within STLUCIA_CONNECT_SECONDS, or a player
+* fails its handshake.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - listeners, the listening socket of each remote player's seat, or -1
+*/
+void connect_players(Game* game, Player** players, int* listeners) {
+    struct pollfd polls[MAX_PLAYERS];
+    int pollSeats[MAX_PLAYERS];
+    int timeout = integer_setting(CONNECT_SECONDS_VARIABLE,
+            DEFAULT_CONNECT_SECONDS, 0, MAX_CONNECT_SECONDS) *
+            MILLISECONDS_PER_SECOND;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long deadline = now.tv_sec * MILLISECONDS_PER_SECOND + 
+            now.tv_nsec / NANOSECONDS_PER_MILLISECOND + timeout;
+    while (true) {
+        int numberPolls = 0;
+        for (int i = 0; i < game->numberOfPlayers; i++) {
+            if (players[i]->status != UNCONNECTED) {
+                continue;
+            }
+            bool waitingSeat = players[i]->outbox == NULL;
+            for (int j = 0; j < i && waitingSeat; j++) {
+                waitingSeat = listeners[j] != listeners[i] ||
+                        players[j]->outbox != NULL;
+            }
+            if (players[i]->outbox != NULL) {
+                polls[numberPolls].fd = fileno(players[i]->outbox);
+            } else if (waitingSeat) {
+                polls[numberPolls].fd = listeners[i];
+            } else {
+                continue;
+            }
+            polls[numberPolls].events = POLLIN;
+            polls[numberPolls].revents = 0;
+            pollSeats[numberPolls++] = i;
+        }
+        if (numberPolls == 0) {
+            return;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long long remaining = deadline - (now.tv_sec * 
+                MILLISECONDS_PER_SECOND + now.tv_nsec / 
+                NANOSECONDS_PER_MILLISECOND);
+        int ready = poll(polls, numberPolls, remaining > 0 ? 
+                (int)remaining : 0);
+        if (ready == 0 || (ready < 0 && errno != EINTR)) {
+            exit_program(game, players, PIPING_FAILURE);
+        }
+        for (int p = 0; p < numberPolls && ready > 0; p++) {
+            int i = pollSeats[p];
+            if (polls[p].revents == 0) {
+                continue;
+            }
+            if (players[i]->outbox != NULL) {
+                receive_handshake(players, i, game);
+            } else {
+                accept_remote_player(listeners[i], game, players, i);
+            }
+        }
+    }
+}
+
+/**
+* Sets up the pipe connections from the hub to all players, or hosts them on
+* threads of the hub when hosting is enabled, and listens for players that
+* connect over a socket. Will exit if piping fails.
 *   - game, a struct of the game state
 *   - players, an array of players 
 */
 void setup_pipes(Game* game, Player** players) {
+    int listeners[MAX_PLAYERS];
     for (int i = 0; i < game->numberOfPlayers; i++) {
+        listeners[i] = -1;
+        if (is_remote_faculty(players[i]->faculty)) {
+            for (int j = 0; j < i && listeners[i] < 0; j++) {
+                if (strcmp(players[j]->faculty, players[i]->faculty) == 0) {
+                    listeners[i] = listeners[j];
+                }
+            }
+            if (listeners[i] < 0 && (listeners[i] = 
+                    listen_for_players(players[i]->faculty)) < 0) {
+                exit_program(game, players, PIPING_FAILURE);
+            }
+            continue;
+        }
+        if (hostingEnabled) {
+            if (!host_player(game, players, i)) {
+                exit_program(game, players, PIPING_FAILURE);
+            }
+            receive_handshake(players, i, game);
+            continue;
+        }
         int hubPipe[PIPE_SIZE];
         int playerPipe[PIPE_SIZE];
         if (pipe(hubPipe) != 0) {
@@ -267,13 +577,24 @@ void setup_pipes(Game* game, Player** players) {
             setup_hub(players, hubPipe, playerPipe, i, game);
         }
     }
+    connect_players(game, players, listeners);
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        bool lastSeat = listeners[i] >= 0;
+        for (int j = i + 1; j < game->numberOfPlayers && lastSeat; j++) {
+            lastSeat = listeners[j] != listeners[i];
+        }
+        if (lastSeat) {
+            stop_listening(listeners[i], players[i]->faculty);
+        }
+    }
 }
 
 /**
 * Waits for a response from the active player. If the player sends "keepall" 
 * returns true, otherwise returns false. If the player sends "reroll", the 
-* hub will reroll and send back a response. Will exit if the player has 
-* terminated or sends an invalid message.
+* hub will reroll and send back a response. If the player has terminated or
+* sends an invalid message it fails (see fail_player()), and true is returned
+* as no more responses are expected.
 *   - game, a struct of the game state
 *   - players, an array of players
 *   - activePlayer, the player who is currently having their turn
@@ -281,9 +602,8 @@ void setup_pipes(Game* game, Player** players) {
 bool keep_dice_response(Game* game, Player** players, int activePlayer) {
     char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH];
     char turnReply[MAX_MESSAGE_LENGTH]; 
-    if (fgets(turnReply, MAX_MESSAGE_LENGTH, 
-            players[activePlayer]->outbox) == NULL) {
-        exit_program(game, players, PLAYER_QUIT);
+    if (!read_player_reply(game, players, activePlayer, turnReply)) {
+        return true;
     }
     int numberCommands = interpret_message(turnReply, commands);
     if ((strcmp(commands[0], "keepall") == 0) && numberCommands == 1) {
@@ -291,7 +611,8 @@ bool keep_dice_response(Game* game, Player** players, int activePlayer) {
     } else if ((strcmp(commands[0], "reroll") == 0) && numberCommands == 2) {
         if (strlen(commands[REROLLED_DICE_ROLL_INDEX]) > DICE_SET_SIZE ||
                 invalid_roll(commands[REROLLED_DICE_ROLL_INDEX])) {
-            exit_program(game, players, INVALID_MESSAGE);
+            fail_player(game, players, activePlayer, INVALID_MESSAGE);
+            return true;
         }
         int dicetoReroll = (int)strlen(commands[REROLLED_DICE_ROLL_INDEX]);
         for (int i = 0; i < dicetoReroll; i++) {
@@ -301,39 +622,97 @@ bool keep_dice_response(Game* game, Player** players, int activePlayer) {
         add_dice_to_dice_set(game->rollFile, dicetoReroll, 
                 game->rollFile->latestDice);
         if (sum_dice_set(game->rollFile->latestDice) != DICE_SET_SIZE) {
-            exit_program(game, players, INVALID_REQUEST);
+            fail_player(game, players, activePlayer, INVALID_REQUEST);
+            return true;
         }
         create_dice_set_string(game->rollFile->latestDice);
-        fprintf(players[activePlayer]->inbox, "rerolled %s\n", 
+        char rerolledMessage[MAX_MESSAGE_LENGTH];
+        sprintf(rerolledMessage, "rerolled %s\n", 
                 game->rollFile->latestDice->rollString);
-        fflush(players[activePlayer]->inbox);
+        send_player_message(players, activePlayer, rerolledMessage);
         return false;
     } else if ((strcmp(commands[0], "stay") == 0) && numberCommands == 1) {
-        exit_program(game, players, INVALID_REQUEST);
+        fail_player(game, players, activePlayer, INVALID_REQUEST);
     } else if ((strcmp(commands[0], "go") == 0) && numberCommands == 1) {
-        exit_program(game, players, INVALID_REQUEST);
+        fail_player(game, players, activePlayer, INVALID_REQUEST);
     } else {
-        exit_program(game, players, INVALID_MESSAGE);
+        fail_player(game, players, activePlayer, INVALID_MESSAGE);
+    }
+    return true;
+}
+
+/**
+* Rerolls the latest dice as the active player's policy decides, as the 
+* player would have asked.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - activePlayer, the player who is currently having their turn
+*/
+void play_policy_rerolls(Game* game, Player** players, int activePlayer) {
+    char faces[NUMBER_OF_FACES] = {DICE_CHARACTER_1, DICE_CHARACTER_2,
+            DICE_CHARACTER_3, DICE_CHARACTER_4, DICE_CHARACTER_5,
+            DICE_CHARACTER_6};
+    int holderHealth = STARTING_HEALTH + 1;
+    if (game->playerInStLucia != EMPTY_STLUCIA && 
+            game->playerInStLucia != activePlayer) {
+        holderHealth = players[game->playerInStLucia]->health;
+    }
+    DiceSet* dice = game->rollFile->latestDice;
+    for (int i = 0; i < POLICY_ALLOWED_REROLLS; i++) {
+        int counts[NUMBER_OF_FACES] = {dice->numberOfOnes, 
+                dice->numberOfTwos, dice->numberOfThrees, dice->numberOfHs,
+                dice->numberOfAs, dice->numberOfPs};
+        int reroll[NUMBER_OF_FACES];
+        int diceToReroll = policy_reroll(&players[activePlayer]->policy,
+                players[activePlayer]->health, 
+                game->playerInStLucia == activePlayer, holderHealth, counts,
+                reroll);
+        if (diceToReroll == 0) {
+            return;
+        }
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            for (int j = 0; j < reroll[face]; j++) {
+                remove_die_from_dice_set(dice, faces[face]);
+            }
+        }
+        add_dice_to_dice_set(game->rollFile, diceToReroll, dice);
     }
-    return false;
 }
 
 /**
 * Generates and saves the final roll (after rerolls) for the active player in
-* the game struct. Alerts the players. Will exit if the player has terminated 
-* or sends an invalid message.
+* the game struct. Alerts the players. Returns true once the roll is final,
+* or false if the player terminated or sent an invalid message and was
+* eliminated for it (see fail_player()).
 *   - game, a struct of the game state
 *   - players, an array of players
 *   - activePlayer, the player who is currently having their turn
 */
-void get_player_roll(Game* game, Player** players, int activePlayer) {
-    create_dice_set_string(game->rollFile->latestDice);
-    fprintf(players[activePlayer]->inbox, "turn %s\n",
-            game->rollFile->latestDice->rollString);
-    fflush(players[activePlayer]->inbox);
+bool get_player_roll(Game* game, Player** players, int activePlayer) {
+    //the policy may change during the turn, so is read once
+    bool policyRerolls = players[activePlayer]->policy.rerolls;
+    if (policyRerolls) {
+        //the active player is told its final roll with everyone else
+        play_policy_rerolls(game, players, activePlayer);
+        create_dice_set_string(game->rollFile->latestDice);
+    } else {
+        create_dice_set_string(game->rollFile->latestDice);
+        char turnMessage[MAX_MESSAGE_LENGTH];
+        sprintf(turnMessage, "turn %s\n",
+                game->rollFile->latestDice->rollString);
+        send_player_message(players, activePlayer, turnMessage);
 
-    //continues to send rerolls to player until "keepall" is received
-    while (!keep_dice_response(game, players, activePlayer));
+        //continues to send rerolls to player until "keepall" is received
+        bool kept = false;
+        while (!kept) {
+            long long span = trace_begin();
+            kept = keep_dice_response(game, players, activePlayer);
+            trace_end("player reply", span);
+        }
+        if (players[activePlayer]->status == ELIMINATED) {
+            return false;
+        }
+    }
 
     fprintf(stderr, "Player %c rolled %s\n", get_player_label(activePlayer), 
             game->rollFile->latestDice->rollString);
@@ -341,7 +720,9 @@ void get_player_roll(Game* game, Player** players, int activePlayer) {
     sprintf(rolledAlert, "rolled %c %s\n",
             get_player_label(activePlayer),
             game->rollFile->latestDice->rollString);
-    alert_remaining_players(game, players, activePlayer, rolledAlert, true);
+    alert_remaining_players(game, players, activePlayer, rolledAlert, 
+            !policyRerolls);
+    return true;
 }
 
 
@@ -390,19 +771,20 @@ bool has_player_exceeded_win_points(Game* game, Player** players,
 */
 void claim_stlucia(Game* game, Player** players, int activePlayer) {
     char attackAlert[MAX_MESSAGE_LENGTH];
-    game->playerInStLucia = activePlayer;
+    set_player_in_stlucia(activePlayer, game);
     sprintf(attackAlert, "claim %c\n", get_player_label(activePlayer));
     fprintf(stderr, "Player %c claimed StLucia\n",
             get_player_label(activePlayer));
-    players[activePlayer]->points++; 
+    add_points(activePlayer, 1, game, players);
     alert_remaining_players(game, players, activePlayer, attackAlert, false);
 }
 
 /**
 * Waits for a response from the active player after asking "stay?". If the 
 * player sends "stay", does nothing. If the player sends "go", the player 
-* will claim St Lucia. Will exit if the player in St Lucia has terminated 
-* or sends an invalid message.
+* will claim St Lucia. If the player in St Lucia has terminated or sends an 
+* invalid message it fails (see fail_player()), leaving St Lucia to the 
+* active player.
 *   - game, a struct of the game state
 *   - players, an array of players
 *   - activePlayer, the player who is currently having their turn
@@ -412,11 +794,12 @@ void receive_stay_reply(Game* game, Player** players, int activePlayer,
         int playerInStLucia) {
     char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH];
     char stayReply[MAX_MESSAGE_LENGTH];
-    if (fgets(stayReply, MAX_MESSAGE_LENGTH,
-            players[playerInStLucia]->outbox) == NULL) {
-        exit_program(game, players, PLAYER_QUIT);
+    if (!read_player_reply(game, players, playerInStLucia, stayReply)) {
+        claim_stlucia(game, players, activePlayer);
+        return;
     }
     int numberCommands = interpret_message(stayReply, commands);
+    ExitCodes failure = SUCCESS;
     if (players[game->playerInStLucia]->health <= 0) {
         claim_stlucia(game, players, activePlayer);
     } else if ((strcmp(commands[0], "stay") == 0) && numberCommands == 1) {
@@ -424,15 +807,20 @@ void receive_stay_reply(Game* game, Player** players, int activePlayer,
     } else if ((strcmp(commands[0], "go") == 0) && numberCommands == 1) {
         claim_stlucia(game, players, activePlayer);
     } else if ((strcmp(commands[0], "keepall") == 0) && numberCommands == 1) {
-        exit_program(game, players, INVALID_REQUEST);
+        failure = INVALID_REQUEST;
     } else if ((strcmp(commands[0], "reroll") == 0) && numberCommands == 2) {
         if (strlen(commands[REROLLED_DICE_ROLL_INDEX]) > DICE_SET_SIZE ||
                 invalid_roll(commands[REROLLED_DICE_ROLL_INDEX])) {
-            exit_program(game, players, INVALID_REQUEST);
+            failure = INVALID_REQUEST;
+        } else {
+            failure = INVALID_MESSAGE;
         }
-        exit_program(game, players, INVALID_MESSAGE);
     } else {
-        exit_program(game, players, INVALID_MESSAGE);
+        failure = INVALID_MESSAGE;
+    }
+    if (failure != SUCCESS) {
+        fail_player(game, players, playerInStLucia, failure);
+        claim_stlucia(game, players, activePlayer);
     }
 }
 
@@ -475,11 +863,21 @@ void attack(Game* game, Player** players, int activePlayer) {
                     players, true);
             alert_remaining_players(game, players, activePlayer, attackAlert, 
                     false);
-            fprintf(players[game->playerInStLucia]->inbox,
-                    "stay?\n");
-            fflush(players[game->playerInStLucia]->inbox);
-            receive_stay_reply(game, players, activePlayer,
-                    game->playerInStLucia);
+            Player* holder = players[game->playerInStLucia];
+            if (!holder->policy.retreats) {
+                long long span = trace_begin();
+                char stayMessage[MAX_MESSAGE_LENGTH];
+                sprintf(stayMessage, "stay?\n");
+                send_player_message(players, game->playerInStLucia, 
+                        stayMessage);
+                receive_stay_reply(game, players, activePlayer,
+                        game->playerInStLucia);
+                trace_end("stay?", span);
+            } else if (holder->health < 
+                    holder->policy.retreatHealthThreshold || 
+                    holder->health <= 0) {
+                claim_stlucia(game, players, activePlayer);
+            }
         }
     }
 }
@@ -494,27 +892,22 @@ void attack(Game* game, Player** players, int activePlayer) {
 */
 void gain_points(Game* game, Player** players, int activePlayer, 
         int startingPoints) {
-    players[activePlayer]->tokens +=
+    int tokens = players[activePlayer]->tokens + 
             game->rollFile->latestDice->numberOfPs;
     /* Convert tokens to points */
-    while (players[activePlayer]->tokens > (TOKENS_POINTS_THRESHOLD - 1)) {
-        players[activePlayer]->tokens -= TOKENS_POINTS_THRESHOLD;
-        players[activePlayer]->points++;
-    }
+    add_points(activePlayer, tokens / TOKENS_POINTS_THRESHOLD, game, players);
+    set_tokens(activePlayer, tokens % TOKENS_POINTS_THRESHOLD, game, players);
     if (game->rollFile->latestDice->numberOfOnes > DICE_POINTS_THRESHOLD) {
-        players[activePlayer]->points +=
-                (game->rollFile->latestDice->numberOfOnes - 
-                ONES_DICE_POINT_PENALTY);
+        add_points(activePlayer, game->rollFile->latestDice->numberOfOnes - 
+                ONES_DICE_POINT_PENALTY, game, players);
     }
     if (game->rollFile->latestDice->numberOfTwos > DICE_POINTS_THRESHOLD) {
-        players[activePlayer]->points +=
-                (game->rollFile->latestDice->numberOfTwos - 
-                TWOS_DICE_POINT_PENALTY);
+        add_points(activePlayer, game->rollFile->latestDice->numberOfTwos - 
+                TWOS_DICE_POINT_PENALTY, game, players);
     }
     if (game->rollFile->latestDice->numberOfThrees > DICE_POINTS_THRESHOLD) {
-        players[activePlayer]->points +=
-                game->rollFile->latestDice->numberOfThrees - 
-                THREES_DICE_POINT_PENALTY;
+        add_points(activePlayer, game->rollFile->latestDice->numberOfThrees - 
+                THREES_DICE_POINT_PENALTY, game, players);
     }
     int pointsGained = players[activePlayer]->points - startingPoints;
     if (pointsGained > 0) {
@@ -547,7 +940,7 @@ void update_eliminated_players(Game* game, Player** players,
                     get_player_label(i));
             alert_remaining_players(game, players, activePlayer, 
                     eliminatedAnnouncement, false); 
-            players[i]->status = ELIMINATED; 
+            set_player_status(i, ELIMINATED, game, players);
         }
     }
 }
@@ -571,7 +964,7 @@ bool check_game_over(Game* game, Player** players, int activePlayer) {
         alert_remaining_players(game, players, activePlayer, winAnnouncement, 
                 false);
         for (int i = 0; i < game->numberOfPlayers; i++) {
-            players[i]->status = ELIMINATED;
+            set_player_status(i, ELIMINATED, game, players);
         }
         return true;
     }
@@ -579,36 +972,63 @@ bool check_game_over(Game* game, Player** players, int activePlayer) {
 }
 
 /**
-* Runs the main game loop. Exits if a player quits unexpectedly or sends an
-* invalid message.
+* Runs the main game loop and returns the number of the winning player, or
+* GAME_DRAWN if the game started repeating itself. Exits if a player quits 
+* unexpectedly or sends an invalid message, unless failures are tolerated.
 *   - game, a struct of the game state
 *   - players, an array of players
 */
-void run_game(Game* game, Player** players) {
+int run_game(Game* game, Player** players) {
     int activePlayer = 0;
     bool winner = false;
+    char turnNames[MAX_PLAYERS][MAX_MESSAGE_LENGTH];
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        sprintf(turnNames[i], "turn %c", get_player_label(i));
+    }
+    start_state_history(&history, game, players);
+    set_allocation_phase(PHASE_TURNS);
     while (!winner) {
+        if (is_repeated_state(&history, game, players, activePlayer)) {
+            return GAME_DRAWN;
+        }
+        long long turnSpan = trace_begin();
         int startingPoints = players[activePlayer]->points;
         if (activePlayer == game->playerInStLucia) {
-            players[activePlayer]->points += STARTING_IN_STLUCIA_POINTS;
+            add_points(activePlayer, STARTING_IN_STLUCIA_POINTS, game, 
+                    players);
         }
+        long long span = trace_begin();
         reset_dice_set(game->rollFile->latestDice);
         
         add_dice_to_dice_set(game->rollFile, DICE_SET_SIZE,
                 game->rollFile->latestDice);
+        trace_end("dice", span);
         
-        get_player_roll(game, players, activePlayer);
+        span = trace_begin();
+        bool rolled = get_player_roll(game, players, activePlayer);
+        trace_end("get_player_roll", span);
         
-        heal(activePlayer, game, players, true,
-                game->rollFile->latestDice->numberOfHs);
+        if (rolled) {
+            span = trace_begin();
+            heal(activePlayer, game, players, true,
+                    game->rollFile->latestDice->numberOfHs);
+            trace_end("heal", span);
 
-        attack(game, players, activePlayer);
+            span = trace_begin();
+            attack(game, players, activePlayer);
+            trace_end("attack", span);
 
-        gain_points(game, players, activePlayer, startingPoints);
+            span = trace_begin();
+            gain_points(game, players, activePlayer, startingPoints);
+            trace_end("gain_points", span);
 
-        update_eliminated_players(game, players, activePlayer);
+            span = trace_begin();
+            update_eliminated_players(game, players, activePlayer);
+            trace_end("eliminations", span);
 
-        winner = check_game_over(game, players, activePlayer);
+            winner = check_game_over(game, players, activePlayer);
+        }
+        trace_end(turnNames[activePlayer], turnSpan);
 
         while (!winner) {
             activePlayer = (activePlayer + 1) % game->numberOfPlayers; 
@@ -616,57 +1036,284 @@ void run_game(Game* game, Player** players) {
                 break;
             }
         }
+        //only a player failing on its own turn leaves the next one alone
+        if (!rolled && is_player_last_remaining(game, players, 
+                activePlayer)) {
+            winner = check_game_over(game, players, activePlayer);
+        }
     }
+    return activePlayer;
+}
+
+/**
+* Exits when the game reaches an invalid part of a streamed roll file.
+*/
+void invalid_streamed_rolls(void) {
+    exit_program(game, players, INVALID_FILE);
 }
 
 /**
-* Saves the roll file after opening it and checking for errors. Exits if 
+* Saves the roll file after opening it and checking for errors. Roll files 
+* of at least STLUCIA_STREAM_THRESHOLD bytes are streamed as the game plays
+* instead, so the game starts at once however large the file. Exits if 
 * unable to open the roll file or the contents are invalid. 
 *   - game, a struct of the game state
 *   - filePath, the file path of the roll file 
 */
 void create_roll_file(Game* game, char* filePath, Player** players) {
-    FILE* loadFile = fopen(filePath, "r");
-    /* Array size will dynamically adjust, starting at size 8 */
-    int initialArraySize = 8; 
-    int index = 0;
-    char* rolls = malloc(sizeof(char) * initialArraySize); 
-    int currentCharacter;
-    if (loadFile == NULL) {
+    struct stat status;
+    if (stat(filePath, &status) == 0 && status.st_size >=
+            long_integer_setting(STREAM_THRESHOLD_VARIABLE,
+            DEFAULT_STREAM_THRESHOLD, 0, LLONG_MAX)) {
+        int opened = open_roll_stream(filePath, game->rollFile, 
+                invalid_streamed_rolls);
+        if (opened < 0) {
+            exit_program(game, players, OPEN_ERROR);
+        } else if (opened == 0) {
+            exit_program(game, players, INVALID_FILE);
+        }
+        return;
+    }
+    int size = read_packed_roll_file(filePath, 
+            &game->rollFile->packedRolls);
+    if (size < 0) {
         exit_program(game, players, OPEN_ERROR);
+    } else if (size == 0) {
+        exit_program(game, players, INVALID_FILE);
     }
-    while (true) {
-        currentCharacter = fgetc(loadFile);
-        if (feof(loadFile)) {
-            if (index == 0) {
-                exit_program(game, players, INVALID_FILE);
-            }
-            break;
-        } else if (currentCharacter == '\n') {
-            continue;
-        } else if (currentCharacter == DICE_CHARACTER_1 || 
-                currentCharacter == DICE_CHARACTER_2 ||
-                currentCharacter == DICE_CHARACTER_3 || 
-                currentCharacter == DICE_CHARACTER_4 ||
-                currentCharacter == DICE_CHARACTER_5 || 
-                currentCharacter == DICE_CHARACTER_6) {
-            rolls[index] = currentCharacter;
-            index++;
-            if (index > initialArraySize / 2) {
-                initialArraySize *= 2;
-                rolls = (char*)realloc(rolls, initialArraySize);
+    game->rollFile->index = 0;
+    game->rollFile->size = size;
+}
+
+/**
+* Hashes the contents of the faculty executable, searching PATH the same way 
+* execlp() does. Returns false if the executable cannot be read.
+*   - faculty, the faculty as given on the command line
+*   - hash, updated with the contents of the executable
+*/
+bool hash_faculty(char* faculty, unsigned long long* hash) {
+    char path[CACHE_PATH_LENGTH];
+    FILE* executable = NULL;
+    char* searchPath = getenv("PATH");
+    if (strchr(faculty, '/') != NULL || searchPath == NULL) {
+        executable = fopen(faculty, "rb");
+    } else {
+        while (executable == NULL && *searchPath != '\0') {
+            size_t directoryLength = strcspn(searchPath, ":");
+            snprintf(path, CACHE_PATH_LENGTH, "%.*s/%s", 
+                    (int)directoryLength, searchPath, faculty);
+            executable = fopen(path, "rb");
+            searchPath += directoryLength;
+            if (*searchPath == ':') {
+                searchPath++;
             }
+        }
+    }
+    if (executable == NULL) {
+        return false;
+    }
+    unsigned char buffer[CACHE_READ_BUFFER_SIZE];
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer, 1, CACHE_READ_BUFFER_SIZE, 
+            executable)) > 0) {
+        *hash = hash_bytes(*hash, buffer, bytesRead);
+    }
+    fclose(executable);
+    return true;
+}
+
+/**
+* Adds every STLUCIA_ setting in the environment other than the cache
+* directory to the hash, so results played with different player settings,
+* such as strategy thresholds or the MCTS search budget, are cached apart.
+* Settings are combined regardless of their order in the environment.
+*   - hash, the hash to add to
+*/
+void hash_settings(unsigned long long* hash) {
+    unsigned long long settings = 0;
+    size_t prefixLength = strlen(THRESHOLD_VARIABLE_PREFIX);
+    size_t cacheLength = strlen(CACHE_DIRECTORY_VARIABLE);
+    for (char** variable = environ; *variable != NULL; variable++) {
+        if (strncmp(*variable, THRESHOLD_VARIABLE_PREFIX, 
+                prefixLength) == 0 && 
+                (strncmp(*variable, CACHE_DIRECTORY_VARIABLE, 
+                cacheLength) != 0 || (*variable)[cacheLength] != '=')) {
+            settings += hash_bytes(HASH_SEED, *variable, strlen(*variable));
+        }
+    }
+    *hash = hash_bytes(*hash, &settings, sizeof(settings));
+}
+
+/**
+* Builds the path of the cache entry for this game from the roll file, score
+* limit, seat order, faculty executables, or libraries if players are hosted,
+* and STLUCIA_ settings. Returns false if caching is not enabled, the roll
+* file is streamed or a faculty cannot be hashed.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - entryPath, the path of the cache entry
+*/
+bool get_cache_entry_path(Game* game, Player** players, char* entryPath) {
+    char* directory = getenv(CACHE_DIRECTORY_VARIABLE);
+    if (directory == NULL || *directory == '\0' || 
+            game->rollFile->stream != NULL) {
+        return false;
+    }
+    unsigned long long key = hash_bytes(HASH_SEED, CACHE_FORMAT,
+            strlen(CACHE_FORMAT));
+    key = hash_bytes(key, &game->rollFile->size, sizeof(int));
+    key = hash_bytes(key, game->rollFile->packedRolls, 
+            packed_roll_bytes(game->rollFile->size));
+    key = hash_bytes(key, &game->scoreLimit, sizeof(int));
+    key = hash_bytes(key, &game->numberOfPlayers, sizeof(int));
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        char library[CACHE_PATH_LENGTH];
+        if (hostingEnabled && !find_hosted_library(players[i]->faculty,
+                library, CACHE_PATH_LENGTH)) {
+            return false;
+        }
+        if (!hash_faculty(hostingEnabled ? library : players[i]->faculty,
+                &key)) {
+            return false;
+        }
+    }
+    hash_settings(&key);
+    mkdir(directory, CACHE_DIRECTORY_MODE);
+    snprintf(entryPath, CACHE_PATH_LENGTH, "%s/%0*llx", directory, 
+            CACHE_KEY_LENGTH, key);
+    return true;
+}
+
+/**
+* Replays the game recorded in the cache entry, writing its transcript to
+* stderr. Returns the number of the winning player, GAME_DRAWN if the game
+* was drawn, or NO_CACHED_RESULT, having written nothing, if there is no
+* valid entry.
+*   - game, a struct of the game state
+*   - entryPath, the path of the cache entry
+*/
+int replay_cached_game(Game* game, char* entryPath) {
+    FILE* entry = fopen(entryPath, "r");
+    if (entry == NULL) {
+        return NO_CACHED_RESULT;
+    }
+    struct stat status;
+    char* contents = NULL;
+    if (fstat(fileno(entry), &status) == 0 && status.st_size > 0) {
+        contents = malloc(status.st_size + 1);
+    }
+    if (contents == NULL || fread(contents, 1, status.st_size, entry) !=
+            (size_t)status.st_size || contents[status.st_size - 1] != '\n') {
+        free(contents);
+        fclose(entry);
+        return NO_CACHED_RESULT;
+    }
+    fclose(entry);
+    contents[status.st_size - 1] = '\0';
+    char* record = strrchr(contents, '\n');
+    record = record == NULL ? contents : record + 1;
+    char label;
+    int result = NO_CACHED_RESULT;
+    if (strcmp(record, CACHED_DRAW) == 0) {
+        result = GAME_DRAWN;
+    } else if (sscanf(record, "winner %c", &label) == 1 &&
+            get_player_number(label) >= 0 &&
+            get_player_number(label) < game->numberOfPlayers) {
+        result = get_player_number(label);
+    }
+    if (result != NO_CACHED_RESULT) {
+        fwrite(contents, 1, record - contents, stderr);
+    }
+    free(contents);
+    return result;
+}
+
+/**
+* Writes all of a buffer to a file descriptor. Returns false if it cannot.
+*   - fd, the file descriptor
+*   - buffer, the bytes to write
+*   - size, the number of bytes
+*/
+bool write_fully(int fd, const char* buffer, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, buffer, size);
+        if (written < 0 && errno == EINTR) {
             continue;
+        } else if (written <= 0) {
+            return false;
         }
-        exit_program(game, players, INVALID_FILE);
+        buffer += written;
+        size -= written;
     }
-    game->rollFile->index = 0;
-    game->rollFile->size = index;
-    game->rollFile->diceRolls = malloc(sizeof(char) * initialArraySize);
-    for (int i = 0; i < index; i++) {
-        game->rollFile->diceRolls[i] = rolls[i];
+    return true;
+}
+
+/**
+* Writes the hub's stderr to fd 2 and to the cache entry being written. Only
+* write() is used, so a turn still allocates nothing.
+*   - cookie, unused
+*   - buffer, the bytes to write
+*   - size, the number of bytes
+*/
+ssize_t write_transcript(void* cookie, const char* buffer, size_t size) {
+    if (cacheEntryFd >= 0 && !write_fully(cacheEntryFd, buffer, size)) {
+        discard_cached_transcript(true);
+    }
+    write_fully(STDERR_FILENO, buffer, size);
+    return (ssize_t)size;
+}
+
+/**
+* Starts writing a cache entry for this game at a temporary path, copying
+* everything written to stderr from now on into it, so the game can be
+* replayed from the cache.
+*   - entryPath, the path of the cache entry
+*/
+void start_cached_transcript(char* entryPath) {
+    snprintf(cacheTemporaryPath, CACHE_PATH_LENGTH, "%s.%d", entryPath, 
+            (int)getpid());
+    cacheEntryFd = open(cacheTemporaryPath, O_WRONLY | O_CREAT | O_TRUNC |
+            O_CLOEXEC, CACHE_ENTRY_MODE);
+    if (cacheEntryFd < 0) {
+        return;
     }
-    free(rolls);
+    cookie_io_functions_t functions = {
+        .read = NULL,
+        .write = write_transcript,
+        .seek = NULL,
+        .close = NULL
+    };
+    FILE* transcript = fopencookie(NULL, "w", functions);
+    if (transcript == NULL) {
+        discard_cached_transcript(true);
+        return;
+    }
+    setvbuf(transcript, NULL, _IONBF, 0);
+    stderr = transcript;
+}
+
+/**
+* Finishes the cache entry with the winner of the completed game, or
+* GAME_DRAWN, after its transcript. The entry is written to a temporary file
+* and renamed, so concurrent hubs never see a partial entry.
+*   - entryPath, the path of the cache entry
+*   - winner, the number of the winning player
+*/
+void write_cached_result(char* entryPath, int winner) {
+    if (cacheEntryFd < 0) {
+        return;
+    }
+    char record[MAX_MESSAGE_LENGTH];
+    int length = winner == GAME_DRAWN ?
+            snprintf(record, MAX_MESSAGE_LENGTH, "%s\n", CACHED_DRAW) :
+            snprintf(record, MAX_MESSAGE_LENGTH, "winner %c\n",
+            get_player_label(winner));
+    bool written = write_fully(cacheEntryFd, record, length);
+    if (close(cacheEntryFd) != 0 || !written ||
+            rename(cacheTemporaryPath, entryPath) != 0) {
+        unlink(cacheTemporaryPath);
+    }
+    cacheEntryFd = -1;
 }
 
 /**
@@ -688,6 +1335,9 @@ int main(int argc, char** argv) {
     sigpipe.sa_handler = SIG_IGN;
     sigaction(SIGPIPE, &sigpipe, 0);
 
+    //pinned before any memory, thread or player is created, which follow
+    pin_to_core_set();
+
     game = malloc(sizeof(Game));
     initialise_game(game);
     game->mallocProgress = GAME;
@@ -713,9 +1363,47 @@ int main(int argc, char** argv) {
     create_roll_file(game, argv[1], players);
     game->mallocProgress = ROLL_FILE;
 
+    char* hostedSetting = getenv(HOSTED_VARIABLE);
+    hostingEnabled = hostedSetting != NULL && *hostedSetting != '\0';
+    char cacheEntryPath[CACHE_PATH_LENGTH];
+    bool cacheEnabled = get_cache_entry_path(game, players, cacheEntryPath);
+    if (cacheEnabled) {
+        int cachedWinner = replay_cached_game(game, cacheEntryPath);
+        if (cachedWinner == GAME_DRAWN) {
+            exit_program(game, players, DRAW_BY_REPETITION);
+        } else if (cachedWinner != NO_CACHED_RESULT) {
+            exit_program(game, players, SUCCESS);
+        }
+        start_cached_transcript(cacheEntryPath);
+    }
+
+    char* spectateSetting = getenv(SPECTATE_VARIABLE);
+    if (spectateSetting != NULL && *spectateSetting != '\0' &&
+            !open_spectator_ring(spectateSetting)) {
+        fprintf(stderr, "Unable to open spectator ring\n");
+    }
+
+    open_trace("hub");
+
+    char* toleranceSetting = getenv(TOLERATE_FAILURES_VARIABLE);
+    toleranceEnabled = toleranceSetting != NULL && *toleranceSetting != '\0';
+    //hosted players have no file descriptors for io_uring to use
+    char* uringSetting = getenv(URING_VARIABLE);
+    uringEnabled = uringSetting != NULL && *uringSetting != '\0' &&
+            !hostingEnabled && open_player_ring();
     setup_pipes(game, players);
+    for (int i = 0; i < game->numberOfPlayers && uringEnabled; i++) {
+        attach_ring_player(i, fileno(players[i]->inbox),
+                fileno(players[i]->outbox));
+    }
 
-    run_game(game, players);
+    int winner = run_game(game, players);
+    if (!playerFailed) {
+        write_cached_result(cacheEntryPath, winner);
+    }
+    if (winner == GAME_DRAWN) {
+        exit_program(game, players, DRAW_BY_REPETITION);
+    }
 
     exit_program(game, players, SUCCESS);
     return 0; 
@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include "shared.h"
+
+/* Argument information for the load generator */
+#define LOAD_ARGS 3
+#define LOAD_LABEL_ARGUMENT_INDEX 2
+
+/* Variables configuring the load generator */
+#define LATENCY_VARIABLE "STLUCIA_LOAD_LATENCY_US"
+#define JITTER_VARIABLE "STLUCIA_LOAD_JITTER_US"
+#define RETREAT_VARIABLE "STLUCIA_LOAD_RETREAT"
+#define FAILURE_TURN_VARIABLE "STLUCIA_LOAD_FAILURE_TURN"
+#define SLOW_READ_VARIABLE "STLUCIA_LOAD_SLOW_READ_US"
+#define FAILURE_VARIABLE "STLUCIA_LOAD_FAILURE"
+#define REPORT_VARIABLE "STLUCIA_LOAD_REPORT"
+#define REPORT_FILE_MODE 0644
+
+/* Failures start on the first turn unless STLUCIA_LOAD_FAILURE_TURN says */
+#define DEFAULT_FAILURE_TURN 1
+
+/* The longest latency or jitter, in microseconds, so the two together fit
+in nanoseconds */
+#define MAX_DELAY_US (LLONG_MAX / NANOSECONDS_PER_MICROSECOND / 2)
+
+/* The replies the load generator sends */
+#define KEEP_REPLY "keepall\n"
+#define STAY_REPLY "stay\n"
+#define RETREAT_REPLY "go\n"
+#define GARBAGE_REPLY "\x01garbage\n"
+
+#define INPUT_BUFFER_SIZE 4096
+#define MAX_REPORT_LENGTH 128
+#define JITTER_MULTIPLIER 6364136223846793005ULL
+#define JITTER_INCREMENT 1442695040888963407ULL
+#define JITTER_SHIFT 33
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, the game ended or the hub shut the player down
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - PIPING_FAILURE, the hub closed the pipe early
+*   - DISCONNECTED, the player disconnected on purpose
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    PIPING_FAILURE = 2,
+    DISCONNECTED = 3
+} ExitCodes;
+
+/**
+* An enum for the ways the load generator can misbehave.
+*   - FAILURE_NONE, answers every message at once
+*   - FAILURE_SLOW, reads its pipe a byte at a time, pausing between bytes
+*   - FAILURE_DISCONNECT, exits without replying on the failure turn
+*   - FAILURE_GARBAGE, replies with an invalid message on the failure turn
+*/
+typedef enum {
+    FAILURE_NONE,
+    FAILURE_SLOW,
+    FAILURE_DISCONNECT,
+    FAILURE_GARBAGE
+} Failure;
+
+/**
+* A struct for the load generator's settings and what it has seen.
+*   - label, the player's label
+*   - latency, nanoseconds to wait before each reply
+*   - jitter, the most nanoseconds to add to the latency at random
+*   - slowRead, nanoseconds to wait between bytes when reading slowly
+*   - retreat, whether to leave St Lucia when asked
+*   - failure, how to misbehave
+*   - failureTurn, the turn to misbehave on
+*   - random, the state of the jitter generator
+*   - turns, the number of turns the player was asked to roll
+*   - stays, the number of times the player was asked to stay
+*   - messages, the number of messages received
+*/
+typedef struct {
+    char label;
+    long long latency;
+    long long jitter;
+    long long slowRead;
+    bool retreat;
+    Failure failure;
+    int failureTurn;
+    unsigned long long random;
+    unsigned long turns;
+    unsigned long stays;
+    unsigned long messages;
+} Load;
+
+/**
+* Appends what the player has seen to the file named by STLUCIA_LOAD_REPORT,
+* as "label turns stays messages", in one write so players never mix.
+*   - load, the load generator
+*/
+void write_report(Load* load) {
+    char* path = getenv(REPORT_VARIABLE);
+    if (path == NULL || *path == '\0') {
+        return;
+    }
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, REPORT_FILE_MODE);
+    if (fd < 0) {
+        return;
+    }
+    char report[MAX_REPORT_LENGTH];
+    int length = snprintf(report, MAX_REPORT_LENGTH, "%c %lu %lu %lu\n",
+            load->label, load->turns, load->stays, load->messages);
+    if (write(fd, report, length) != length) {
+        /* The report is lost, which the benchmark sees as a missing player */
+    }
+    close(fd);
+}
+
+/**
+* Reports what the player has seen and exits with the specified status.
+*   - load, the load generator, or NULL before it is set up
+*   - exitStatus, the status to exit with
+*/
+void exit_program(Load* load, ExitCodes exitStatus) {
+    if (load != NULL) {
+        write_report(load);
+    }
+    if (exitStatus == INVALID_ARGUMENTS) {
+        fprintf(stderr, "Usage: LOAD number_of_players my_id\n");
+    }
+    exit(exitStatus);
+}
+
+/**
+* Sleeps for the specified number of nanoseconds, if any.
+*   - nanoseconds, how long to sleep
+*/
+void pause_for(long long nanoseconds) {
+    if (nanoseconds <= 0) {
+        return;
+    }
+    struct timespec delay = {nanoseconds / TRACE_NANOSECONDS_PER_SECOND,
+            nanoseconds % TRACE_NANOSECONDS_PER_SECOND};
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+/**
+* Writes a reply to the hub after the configured latency and jitter. Exits
+* if the hub has gone.
+*   - load, the load generator
+*   - reply, the reply, ending in a newline
+*/
+void send_reply(Load* load, const char* reply) {
+    long long delay = load->latency;
+    if (load->jitter > 0) {
+        load->random = load->random * JITTER_MULTIPLIER + JITTER_INCREMENT;
+        delay += (long long)((load->random >> JITTER_SHIFT) %
+                (unsigned long long)(load->jitter + 1));
+    }
+    pause_for(delay);
+    size_t length = strlen(reply);
+    if (write(STDOUT_FILENO, reply, length) != (ssize_t)length) {
+        exit_program(load, PIPING_FAILURE);
+    }
+}
+
+/**
+* Answers one message from the hub. Everything but a request for a reply
+* and the end of the player's game is counted and ignored.
+*   - load, the load generator
+*   - message, the message, without its newline
+*/
+void handle_message(Load* load, const char* message) {
+    load->messages++;
+    if (strncmp(message, "turn ", strlen("turn ")) == 0) {
+        load->turns++;
+        if (load->failure != FAILURE_NONE &&
+                load->turns == (unsigned long)load->failureTurn) {
+            if (load->failure == FAILURE_DISCONNECT) {
+                exit_program(load, DISCONNECTED);
+            } else if (load->failure == FAILURE_GARBAGE) {
+                send_reply(load, GARBAGE_REPLY);
+                return;
+            }
+        }
+        send_reply(load, KEEP_REPLY);
+    } else if (strcmp(message, "stay?") == 0) {
+        load->stays++;
+        send_reply(load, load->retreat ? RETREAT_REPLY : STAY_REPLY);
+    } else if (strcmp(message, "shutdown") == 0 ||
+            strncmp(message, "winner ", strlen("winner ")) == 0) {
+        exit_program(load, SUCCESS);
+    } else if (strncmp(message, "eliminated ", strlen("eliminated ")) == 0 &&
+            message[strlen("eliminated ")] == load->label) {
+        exit_program(load, SUCCESS);
+    }
+}
+
+/**
+* Reads messages from the hub with read() and answers them until the game
+* ends. Messages are split in place in the input buffer, so nothing is
+* copied or allocated. A slow reader reads a byte at a time.
+*   - load, the load generator
+*/
+void run_load(Load* load) {
+    char input[INPUT_BUFFER_SIZE];
+    size_t length = 0;
+    while (true) {
+        size_t want = load->failure == FAILURE_SLOW ? 1 :
+                sizeof(input) - length;
+        if (load->failure == FAILURE_SLOW) {
+            pause_for(load->slowRead);
+        }
+        ssize_t got = read(STDIN_FILENO, input + length, want);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        } else if (got <= 0) {
+            exit_program(load, PIPING_FAILURE);
+        }
+        length += got;
+        size_t start = 0;
+        char* newline;
+        while ((newline = memchr(input + start, '\n', length - start))
+                != NULL) {
+            *newline = '\0';
+            handle_message(load, input + start);
+            start = newline - input + 1;
+        }
+        if (start == 0 && length == sizeof(input)) {
+            exit_program(load, PIPING_FAILURE);
+        }
+        memmove(input, input + start, length - start);
+        length -= start;
+    }
+}
+
+/**
+* Returns how the load generator should misbehave, from STLUCIA_LOAD_FAILURE
+* of "slow", "disconnect" or "garbage".
+*/
+Failure load_failure(void) {
+    char* setting = getenv(FAILURE_VARIABLE);
+    if (setting == NULL) {
+        return FAILURE_NONE;
+    } else if (strcmp(setting, "slow") == 0) {
+        return FAILURE_SLOW;
+    } else if (strcmp(setting, "disconnect") == 0) {
+        return FAILURE_DISCONNECT;
+    } else if (strcmp(setting, "garbage") == 0) {
+        return FAILURE_GARBAGE;
+    }
+    return FAILURE_NONE;
+}
+
+int main(int argc, char** argv) {
+    struct sigaction sigint;
+    memset(&sigint, 0, sizeof(sigint));
+    sigint.sa_handler = SIG_IGN;
+    sigaction(SIGINT, &sigint, 0);
+    sigaction(SIGPIPE, &sigint, 0);
+
+    if (argc != LOAD_ARGS ||
+            strlen(argv[LOAD_LABEL_ARGUMENT_INDEX]) != LABEL_LENGTH) {
+        exit_program(NULL, INVALID_ARGUMENTS);
+    }
+    Load load;
+    memset(&load, 0, sizeof(load));
+    load.label = argv[LOAD_LABEL_ARGUMENT_INDEX][0];
+    load.latency = long_integer_setting(LATENCY_VARIABLE, 0, 0,
+            MAX_DELAY_US) * NANOSECONDS_PER_MICROSECOND;
+    load.jitter = long_integer_setting(JITTER_VARIABLE, 0, 0, MAX_DELAY_US) *
+            NANOSECONDS_PER_MICROSECOND;
+    load.slowRead = long_integer_setting(SLOW_READ_VARIABLE, 0, 0,
+            MAX_DELAY_US) * NANOSECONDS_PER_MICROSECOND;
+    load.retreat = integer_setting(RETREAT_VARIABLE, 0, INT_MIN, INT_MAX) != 0;
+    load.failure = load_failure();
+    load.failureTurn = integer_setting(FAILURE_TURN_VARIABLE,
+            DEFAULT_FAILURE_TURN, 0, INT_MAX);
+    load.random = HASH_SEED ^ (unsigned long long)load.label;
+
+    if (write(STDOUT_FILENO, "!", 1) != 1) {
+        exit_program(&load, PIPING_FAILURE);
+    }
+    run_load(&load);
+    return 0;
+}
@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include "shared.h"
+#include "lockstep.h"
+
+/* The faculty names accepted by lookup_faculty(), indexed by Faculty */
+const char* facultyNames[NUMBER_OF_FACULTIES] = {
+    "eait", "science", "mabs", "habs", "hass"
+};
+
+/**
+* Finds the faculty with the specified name, ignoring case and any leading
+* directories, so "./EAIT" names the eait faculty. Returns false if there is
+* no such faculty.
+*   - name, the name of the faculty
+*   - faculty, set to the faculty found
+*/
+bool lookup_faculty(char* name, Faculty* faculty) {
+    char* baseName = strrchr(name, '/');
+    baseName = (baseName == NULL) ? name : baseName + 1;
+    for (int i = 0; i < NUMBER_OF_FACULTIES; i++) {
+        if (strcasecmp(baseName, facultyNames[i]) == 0) {
+            *faculty = (Faculty)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+* Sets up the specified strategy to play the faculty with the thresholds
+* compiled into its player.
+*   - faculty, the faculty to play
+*   - strategy, the strategy to set up
+*/
+void default_strategy(Faculty faculty, Strategy* strategy) {
+    strategy->faculty = faculty;
+    strategy->rerollNumberDiceThreshold = EAIT_REROLL_NUMBER_DICE_THRESHOLD;
+    strategy->rerollHealthThreshold = EAIT_REROLL_HEALTH_THRESHOLD;
+    strategy->retreatHealthThreshold = EAIT_RETREAT_HEALTH_THRESHOLD;
+    strategy->retreatRemainingPlayersThreshold =
+            HABS_RETREAT_REMAINING_PLAYERS_THRESHOLD;
+    if (faculty == HABS_FACULTY) {
+        strategy->rerollHealthThreshold = HABS_REROLL_HEALTH_THRESHOLD;
+        strategy->retreatHealthThreshold = HABS_RETREAT_HEALTH_THRESHOLD;
+    } else if (faculty == SCIENCE_FACULTY) {
+        strategy->rerollHealthThreshold = SCIENCE_REROLL_HEALTH_THRESHOLD;
+    }
+}
+
+/**
+* Allocates the lane arrays of the lockstep engine. Returns false if memory
+* could not be allocated. Strategies must be set by the caller.
+*   - lockstep, the engine to initialise
+*   - lanes, the number of games to play at once
+*   - numberOfPlayers, the number of players in each game
+*   - scoreLimit, the score limit of each game
+*   - maxTurns, the number of turns after which games are drawn
+*/
+bool initialise_lockstep(Lockstep* lockstep, int lanes, int numberOfPlayers,
+        int scoreLimit, int maxTurns) {
+    memset(lockstep, 0, sizeof(Lockstep));
+    lockstep->lanes = lanes;
+    lockstep->numberOfPlayers = numberOfPlayers;
+    lockstep->scoreLimit = scoreLimit;
+    lockstep->maxTurns = maxTurns;
+    for (int i = 0; i < numberOfPlayers; i++) {
+        default_strategy(EAIT_FACULTY, &lockstep->strategies[i]);
+    }
+
+    size_t perPlayer = sizeof(int) * lanes * numberOfPlayers;
+    size_t perFace = sizeof(int) * lanes * NUMBER_OF_FACES;
+    size_t perGame = sizeof(int) * lanes;
+    lockstep->health = malloc(perPlayer);
+    lockstep->points = malloc(perPlayer);
+    lockstep->tokens = malloc(perPlayer);
+    lockstep->alive = malloc(perPlayer);
+    lockstep->playerInStLucia = malloc(perGame);
+    lockstep->activePlayer = malloc(perGame);
+    lockstep->rollIndex = malloc(perGame);
+    lockstep->winner = malloc(perGame);
+    lockstep->turns = malloc(perGame);
+    lockstep->kept = malloc(perGame);
+    lockstep->dice = malloc(perFace);
+    lockstep->reroll = malloc(perFace);
+    return lockstep->health != NULL && lockstep->points != NULL &&
+            lockstep->tokens != NULL && lockstep->alive != NULL &&
+            lockstep->playerInStLucia != NULL &&
+            lockstep->activePlayer != NULL && lockstep->rollIndex != NULL &&
+            lockstep->winner != NULL && lockstep->turns != NULL &&
+            lockstep->kept != NULL && lockstep->dice != NULL &&
+            lockstep->reroll != NULL;
+}
+
+/**
+* Stores the roll file as DiceFace indices. Returns false if the rolls are
+* empty or contain an invalid die.
+*   - lockstep, the engine to load the rolls into
+*   - diceRolls, the dice characters of the roll file
+*   - size, the number of dice in the roll file
+*/
+bool load_lockstep_rolls(Lockstep* lockstep, char* diceRolls, int size) {
+    if (size <= 0) {
+        return false;
+    }
+    free(lockstep->faces);
+    lockstep->faces = malloc(sizeof(unsigned char) * size);
+    lockstep->rollFileSize = size;
+    if (lockstep->faces == NULL) {
+        return false;
+    }
+    for (int i = 0; i < size; i++) {
+        int face = get_face_index(diceRolls[i]);
+        if (face < 0) {
+            return false;
+        }
+        lockstep->faces[i] = (unsigned char)face;
+    }
+    return true;
+}
+
+/**
+* Starts a new game in every lane. Lane n starts rolling from roll file index
+* firstRollIndex + n, wrapping like get_next_die().
+*   - lockstep, the engine to reset
+*   - firstRollIndex, the roll file index of the first lane
+*/
+void reset_lockstep(Lockstep* lockstep, int firstRollIndex) {
+    int lanes = lockstep->lanes;
+    for (int i = 0; i < lanes * lockstep->numberOfPlayers; i++) {
+        lockstep->health[i] = STARTING_HEALTH;
+        lockstep->points[i] = 0;
+        lockstep->tokens[i] = 0;
+        lockstep->alive[i] = 1;
+    }
+    for (int lane = 0; lane < lanes; lane++) {
+        lockstep->playerInStLucia[lane] = EMPTY_STLUCIA;
+        lockstep->activePlayer[lane] = 0;
+        lockstep->rollIndex[lane] =
+                (firstRollIndex + lane) % lockstep->rollFileSize;
+        lockstep->winner[lane] = LOCKSTEP_PLAYING;
+        lockstep->turns[lane] = 0;
+    }
+}
+
+/**
+* Awards the St Lucia points to active players who start their turn in St
+* Lucia, and clears the dice of every lane.
+*   - lockstep, the engine
+*/
+void start_turns(Lockstep* lockstep) {
+    int lanes = lockstep->lanes;
+    for (int lane = 0; lane < lanes; lane++) {
+        int active = lockstep->activePlayer[lane];
+        int inStLucia = lockstep->playerInStLucia[lane] == active;
+        int playing = lockstep->winner[lane] == LOCKSTEP_PLAYING;
+        lockstep->points[active * lanes + lane] +=
+                STARTING_IN_STLUCIA_POINTS * (inStLucia & playing);
+        lockstep->kept[lane] = !playing;
+    }
+    memset(lockstep->dice, 0, sizeof(int) * lanes * NUMBER_OF_FACES);
+}
+
+/**
+* Draws dice from the roll file into the dice of each lane that has not kept
+* its dice. Draws DICE_SET_SIZE dice for the first roll of a turn, otherwise
+* as many dice as the lane is rerolling.
+*   - lockstep, the engine
+*   - firstRoll, true for the first roll of a turn
+*/
+void draw_dice(Lockstep* lockstep, bool firstRoll) {
+    int lanes = lockstep->lanes;
+    int* dice = lockstep->dice;
+    int* reroll = lockstep->reroll;
+    for (int die = 0; die < DICE_SET_SIZE; die++) {
+        for (int lane = 0; lane < lanes; lane++) {
+            int count = DICE_SET_SIZE;
+            if (!firstRoll) {
+                count = reroll[FACE_ONE * lanes + lane] +
+                        reroll[FACE_TWO * lanes + lane] +
+                        reroll[FACE_THREE * lanes + lane] +
+                        reroll[FACE_H * lanes + lane] +
+                        reroll[FACE_A * lanes + lane] +
+                        reroll[FACE_P * lanes + lane];
+            }
+            int draw = (die < count) & !lockstep->kept[lane];
+            int index = lockstep->rollIndex[lane];
+            int face = lockstep->faces[index];
+            for (int f = 0; f < NUMBER_OF_FACES; f++) {
+                dice[f * lanes + lane] += draw & (face == f);
+            }
+            index += draw;
+            lockstep->rollIndex[lane] =
+                    (index == lockstep->rollFileSize) ? 0 : index;
+        }
+    }
+}
+
+/**
+* Sets the dice a player rerolls, as the strategy's faculty reroll() would.
+* Returns the number of dice rerolled. Branch free, so it vectorises when 
+* inlined into a loop over lanes.
+*   - strategy, the strategy of the player
+*   - health, the player's health
+*   - inStLucia, whether the player is in St Lucia
+*   - holderHealth, the health of the player in St Lucia, or more than 
+*       STARTING_HEALTH if St Lucia is empty
+*   - dice, the dice held, indexed by DiceFace
+*   - reroll, set to the dice to reroll, indexed by DiceFace
+*/
+int strategy_reroll(Strategy* strategy, int health, int inStLucia,
+        int holderHealth, const int* dice, int* reroll) {
+    int eait = strategy->faculty == EAIT_FACULTY;
+    int science = strategy->faculty == SCIENCE_FACULTY;
+    int mabs = strategy->faculty == MABS_FACULTY;
+    int habs = strategy->faculty == HABS_FACULTY;
+    int hass = strategy->faculty == HASS_FACULTY;
+    int lowHealth = health < strategy->rerollHealthThreshold;
+    int highHealth = health > strategy->rerollHealthThreshold;
+    int threshold = strategy->rerollNumberDiceThreshold;
+    int ones = dice[FACE_ONE];
+    int twos = dice[FACE_TWO];
+    int threes = dice[FACE_THREE];
+    int as = dice[FACE_A];
+
+    reroll[FACE_ONE] = ones * ((eait & (ones < threshold)) | science |
+            mabs | hass);
+    reroll[FACE_TWO] = twos * ((eait & (twos < threshold)) | science |
+            mabs | hass);
+    reroll[FACE_THREE] = threes * ((eait & (threes < threshold)) |
+            science | hass);
+    reroll[FACE_H] = dice[FACE_H] * ((eait & highHealth) |
+            (science & !lowHealth) | (mabs & inStLucia) | hass);
+    reroll[FACE_A] = as * (eait | (science & lowHealth) |
+            (mabs & !inStLucia) | (habs & lowHealth) |
+            (hass & (inStLucia | (as < holderHealth))));
+    reroll[FACE_P] = dice[FACE_P] * (eait | science | mabs |
+            (hass & !inStLucia));
+    return reroll[FACE_ONE] + reroll[FACE_TWO] + reroll[FACE_THREE] +
+            reroll[FACE_H] + reroll[FACE_A] + reroll[FACE_P];
+}
+
+/**
+* Returns whether a player in St Lucia retreats after being attacked, as the
+* strategy's faculty retreat() would.
+*   - strategy, the strategy of the player
+*   - health, the player's health
+*   - remaining, the number of players not eliminated
+*/
+int strategy_retreats(Strategy* strategy, int health, int remaining) {
+    int lowHealth = health < strategy->retreatHealthThreshold;
+    switch (strategy->faculty) {
+        case EAIT_FACULTY:
+            return lowHealth;
+        case HABS_FACULTY:
+            return lowHealth &&
+                    remaining != strategy->retreatRemainingPlayersThreshold;
+        case HASS_FACULTY:
+            return false;
+        default:
+            return true;
+    }
+}
+
+/**
+* Decides which dice the active player of each lane rerolls, as the active
+* player's faculty reroll() would, removing them from the lane's dice. Lanes
+* whose player rerolls nothing have kept their dice.
+*   - lockstep, the engine
+*/
+void choose_rerolls(Lockstep* lockstep) {
+    int lanes = lockstep->lanes;
+    int* dice = lockstep->dice;
+    int* reroll = lockstep->reroll;
+    for (int lane = 0; lane < lanes; lane++) {
+        int active = lockstep->activePlayer[lane];
+        int holder = lockstep->playerInStLucia[lane];
+        int holderHealth = (holder == EMPTY_STLUCIA) ?
+                STARTING_HEALTH + 1 : lockstep->health[holder * lanes + lane];
+        int held[NUMBER_OF_FACES];
+        int rerolled[NUMBER_OF_FACES];
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            held[face] = dice[face * lanes + lane];
+        }
+        int total = strategy_reroll(&lockstep->strategies[active],
+                lockstep->health[active * lanes + lane], holder == active,
+                holderHealth, held, rerolled);
+        int keep = lockstep->kept[lane];
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            reroll[face * lanes + lane] = rerolled[face] * !keep;
+        }
+        lockstep->kept[lane] = keep | (total == 0);
+    }
+    for (int i = 0; i < lanes * NUMBER_OF_FACES; i++) {
+        dice[i] -= reroll[i];
+    }
+}
+
+/**
+* Heals the active player of each lane by the 'H's rolled, as heal() does.
+*   - lockstep, the engine
+*/
+void heal_active_players(Lockstep* lockstep) {
+    int lanes = lockstep->lanes;
+    for (int lane = 0; lane < lanes; lane++) {
+        int active = lockstep->activePlayer[lane];
+        int playing = lockstep->winner[lane] == LOCKSTEP_PLAYING;
+        int outside = lockstep->playerInStLucia[lane] != active;
+        int* health = &lockstep->health[active * lanes + lane];
+        int healed = *health + lockstep->dice[FACE_H * lanes + lane] *
+                (playing & outside);
+        *health = (healed > STARTING_HEALTH) ? STARTING_HEALTH : healed;
+    }
+}
+
+/**
+* Decides whether the player in St Lucia of the specified lane retreats, as
+* their faculty retreat() would.
+*   - lockstep, the engine
+*   - lane, the lane of the game
+*   - holder, the player in St Lucia
+*/
+int retreats(Lockstep* lockstep, int lane, int holder) {
+    int lanes = lockstep->lanes;
+    int remaining = 0;
+    for (int i = 0; i < lockstep->numberOfPlayers; i++) {
+        remaining += lockstep->alive[i * lanes + lane];
+    }
+    return strategy_retreats(&lockstep->strategies[holder],
+            lockstep->health[holder * lanes + lane], remaining);
+}
+
+/**
+* Resolves the 'A's rolled by the active player of each lane, as attack()
+* does: claiming an empty St Lucia, attacking out from St Lucia or attacking
+* in, in which case the player in St Lucia may retreat.
+*   - lockstep, the engine
+*/
+void attack_players(Lockstep* lockstep) {
+    int lanes = lockstep->lanes;
+    for (int lane = 0; lane < lanes; lane++) {
+        int damage = lockstep->dice[FACE_A * lanes + lane];
+        if (damage == 0 || lockstep->winner[lane] != LOCKSTEP_PLAYING) {
+            continue;
+        }
+        int active = lockstep->activePlayer[lane];
+        int holder = lockstep->playerInStLucia[lane];
+        if (holder == active) {
+            for (int i = 0; i < lockstep->numberOfPlayers; i++) {
+                int* health = &lockstep->health[i * lanes + lane];
+                int hit = (i != active) & lockstep->alive[i * lanes + lane];
+                int damaged = *health - damage * hit;
+                *health = (damaged < 0) ? 0 : damaged;
+            }
+            continue;
+        }
+        if (holder != EMPTY_STLUCIA) {
+            int* health = &lockstep->health[holder * lanes + lane];
+            *health = (*health - damage < 0) ? 0 : *health - damage;
+            if (*health > 0 && !retreats(lockstep, lane, holder)) {
+                continue;
+            }
+        }
+        lockstep->playerInStLucia[lane] = active;
+        lockstep->points[active * lanes + lane]++;
+    }
+}
+
+/**
+* Adds the tokens and points of the active player of each lane's dice, as
+* gain_points() does.
+*   - lockstep, the engine
+*/
+void gain_lockstep_points(Lockstep* lockstep) {
+    int lanes = lockstep->lanes;
+    int* dice = lockstep->dice;
+    for (int lane = 0; lane < lanes; lane++) {
+        int active = lockstep->activePlayer[lane];
+        int playing = lockstep->winner[lane] == LOCKSTEP_PLAYING;
+        int ones = dice[FACE_ONE * lanes + lane];
+        int twos = dice[FACE_TWO * lanes + lane];
+        int threes = dice[FACE_THREE * lanes + lane];
+        int tokens = lockstep->tokens[active * lanes + lane] +
+                dice[FACE_P * lanes + lane] * playing;
+        int points = tokens / TOKENS_POINTS_THRESHOLD;
+        points += (ones - ONES_DICE_POINT_PENALTY) *
+                (ones > DICE_POINTS_THRESHOLD);
+        points += (twos - TWOS_DICE_POINT_PENALTY) *
+                (twos > DICE_POINTS_THRESHOLD);
+        points += (threes - THREES_DICE_POINT_PENALTY) *
+                (threes > DICE_POINTS_THRESHOLD);
+        lockstep->tokens[active * lanes + lane] =
+                tokens % TOKENS_POINTS_THRESHOLD;
+        lockstep->points[active * lanes + lane] += points * playing;
+    }
+}
+
+/**
+* Eliminates players with no health, checks whether the active player of
+* each lane has won and passes the turn to the next remaining player.
+* Returns the number of games still being played.
+*   - lockstep, the engine
+*/
+int finish_turns(Lockstep* lockstep) {
+    int lanes = lockstep->lanes;
+    int numberOfPlayers = lockstep->numberOfPlayers;
+    for (int i = 0; i < lanes * numberOfPlayers; i++) {
+        lockstep->alive[i] &= lockstep->health[i] > 0;
+    }
+    int playing = 0;
+    for (int lane = 0; lane < lanes; lane++) {
+        if (lockstep->winner[lane] != LOCKSTEP_PLAYING) {
+            continue;
+        }
+        int active = lockstep->activePlayer[lane];
+        int others = 0;
+        for (int i = 0; i < numberOfPlayers; i++) {
+            others += lockstep->alive[i * lanes + lane] * (i != active);
+        }
+        lockstep->turns[lane]++;
+        if (others == 0 ||
+                lockstep->points[active * lanes + lane] >=
+                lockstep->scoreLimit) {
+            lockstep->winner[lane] = active;
+            continue;
+        }
+        if (lockstep->turns[lane] >= lockstep->maxTurns) {
+            lockstep->winner[lane] = LOCKSTEP_DRAWN;
+            continue;
+        }
+        do {
+            active = (active + 1) % numberOfPlayers;
+        } while (!lockstep->alive[active * lanes + lane]);
+        lockstep->activePlayer[lane] = active;
+        playing++;
+    }
+    return playing;
+}
+
+/**
+* Plays one turn of every game still being played. Returns the number of
+* games still being played afterwards.
+*   - lockstep, the engine
+*/
+int play_lockstep_turn(Lockstep* lockstep) {
+    start_turns(lockstep);
+    draw_dice(lockstep, true);
+    for (int i = 0; i < LOCKSTEP_ALLOWED_REROLLS; i++) {
+        choose_rerolls(lockstep);
+        draw_dice(lockstep, false);
+    }
+    heal_active_players(lockstep);
+    attack_players(lockstep);
+    gain_lockstep_points(lockstep);
+    return finish_turns(lockstep);
+}
+
+/**
+* Plays every game to completion. Games longer than maxTurns are drawn.
+*   - lockstep, the engine
+*/
+void run_lockstep(Lockstep* lockstep) {
+    while (play_lockstep_turn(lockstep) > 0);
+}
+
+/**
+* Frees the memory allocated by the lockstep engine.
+*   - lockstep, the engine
+*/
+void free_lockstep(Lockstep* lockstep) {
+    free(lockstep->faces);
+    free(lockstep->health);
+    free(lockstep->points);
+    free(lockstep->tokens);
+    free(lockstep->alive);
+    free(lockstep->playerInStLucia);
+    free(lockstep->activePlayer);
+    free(lockstep->rollIndex);
+    free(lockstep->winner);
+    free(lockstep->turns);
+    free(lockstep->kept);
+    free(lockstep->dice);
+    free(lockstep->reroll);
+}
@@ -0,0 +1,114 @@
+#include <stdbool.h>
+#include "shared.h"
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+/* Default thresholds of the faculty strategies, as in the faculty sources */
+#define EAIT_REROLL_NUMBER_DICE_THRESHOLD 3
+#define EAIT_REROLL_HEALTH_THRESHOLD 5
+#define EAIT_RETREAT_HEALTH_THRESHOLD 5
+#define HABS_REROLL_HEALTH_THRESHOLD 5
+#define HABS_RETREAT_HEALTH_THRESHOLD 4
+#define HABS_RETREAT_REMAINING_PLAYERS_THRESHOLD 2
+#define SCIENCE_REROLL_HEALTH_THRESHOLD 5
+
+/* Game properties the hub and players enforce through the protocol */
+#define LOCKSTEP_ALLOWED_REROLLS 2
+
+/* Values of the winner array other than a player number */
+#define LOCKSTEP_PLAYING -1
+#define LOCKSTEP_DRAWN -2
+
+/**
+* An enum for the faculties the lockstep engine can play.
+*/
+typedef enum {
+    EAIT_FACULTY = 0,
+    SCIENCE_FACULTY = 1,
+    MABS_FACULTY = 2,
+    HABS_FACULTY = 3,
+    HASS_FACULTY = 4,
+    NUMBER_OF_FACULTIES = 5
+} Faculty;
+
+/**
+* A struct for the strategy played in a seat: a faculty and the thresholds it
+* uses. Thresholds a faculty does not use are ignored.
+*   - faculty, the faculty in the seat
+*   - rerollNumberDiceThreshold, rerolls numbers rolled fewer times than this
+*   - rerollHealthThreshold, the health that decides whether to reroll 'H's
+*       or 'A's
+*   - retreatHealthThreshold, retreats from St Lucia below this health
+*   - retreatRemainingPlayersThreshold, never retreats with this many players
+*       remaining
+*/
+typedef struct {
+    Faculty faculty;
+    int rerollNumberDiceThreshold;
+    int rerollHealthThreshold;
+    int retreatHealthThreshold;
+    int retreatRemainingPlayersThreshold;
+} Strategy;
+
+/**
+* A struct for advancing many independent games in lockstep. All games share
+* the seats, score limit and roll file, but each game starts from its own
+* roll file index. Game state is stored as a struct of arrays with one lane
+* per game, so each rule is a loop over lanes the compiler can vectorise.
+* Per player arrays hold numberOfPlayers rows of lanes ints, indexed by
+* player * lanes + lane. Per face arrays hold NUMBER_OF_FACES rows likewise.
+*   - lanes, the number of games
+*   - numberOfPlayers, the number of players in each game
+*   - scoreLimit, the score limit of each game
+*   - maxTurns, the number of turns after which unfinished games are drawn
+*   - rollFileSize, the number of dice in the roll file
+*   - faces, the roll file as DiceFace indices
+*   - strategies, the strategy played in each seat
+*   - health, points, tokens, alive, per player state
+*   - playerInStLucia, activePlayer, rollIndex, per game state
+*   - winner, the winning player, or LOCKSTEP_PLAYING or LOCKSTEP_DRAWN
+*   - turns, the number of turns played in each game
+*   - dice, the latest dice rolled in each game, per face
+*   - reroll, the dice the active player is rerolling, per face
+*   - kept, whether the active player has kept all their dice
+*/
+typedef struct {
+    int lanes;
+    int numberOfPlayers;
+    int scoreLimit;
+    int maxTurns;
+    int rollFileSize;
+    unsigned char* faces;
+    Strategy strategies[MAX_PLAYERS];
+    int* health;
+    int* points;
+    int* tokens;
+    int* alive;
+    int* playerInStLucia;
+    int* activePlayer;
+    int* rollIndex;
+    int* winner;
+    int* turns;
+    int* dice;
+    int* reroll;
+    int* kept;
+} Lockstep;
+
+/* The name of each faculty, indexed by Faculty */
+extern const char* facultyNames[NUMBER_OF_FACULTIES];
+
+/* Function prototypes */
+bool lookup_faculty(char* name, Faculty* faculty);
+void default_strategy(Faculty faculty, Strategy* strategy);
+int strategy_reroll(Strategy* strategy, int health, int inStLucia,
+        int holderHealth, const int* dice, int* reroll);
+int strategy_retreats(Strategy* strategy, int health, int remaining);
+bool initialise_lockstep(Lockstep* lockstep, int lanes, int numberOfPlayers,
+        int scoreLimit, int maxTurns);
+bool load_lockstep_rolls(Lockstep* lockstep, char* diceRolls, int size);
+void reset_lockstep(Lockstep* lockstep, int firstRollIndex);
+int play_lockstep_turn(Lockstep* lockstep);
+void run_lockstep(Lockstep* lockstep);
+void free_lockstep(Lockstep* lockstep);
+#endif
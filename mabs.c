@@ -34,3 +34,16 @@ void reroll(Game* game, Player** players, RollFile* rollFile) {
 bool retreat(Game* game, Player** players) {
     return true;
 }
+
+/**
+* Writes the policy the hub can play for this player and returns true. Rows
+* are "123HAP" for low and high health, outside then inside St Lucia.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - policy, the policy message to write
+*/
+bool describe_policy(Game* game, Player** players, char* policy) {
+    sprintf(policy, "policy 00 770077770077 770707770707 %02d",
+            POLICY_MAX_THRESHOLD);
+    return true;
+}
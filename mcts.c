@@ -0,0 +1,390 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "shared.h"
+#include "lockstep.h"
+#include "model.h"
+
+/* Default search settings, overridden by these variables */
+#define DECISION_ROLLOUTS_VARIABLE "STLUCIA_DECISION_ROLLOUTS"
+#define DECISION_ROLLOUTS 65536
+#define SCORE_LIMIT_VARIABLE "STLUCIA_SCORE_LIMIT"
+#define SCORE_LIMIT 15
+#define SEARCH_THREADS_VARIABLE "STLUCIA_SEARCH_THREADS"
+#define SEARCH_THREADS 0
+#define SEARCH_SEED_VARIABLE "STLUCIA_SEARCH_SEED"
+#define SEARCH_SEED 0
+
+/* Each decision is searched from this many independently seeded roots, so
+the search plays the same rollouts however many threads share them */
+#define SEARCH_ROOTS 16
+
+/* Rollouts still running after this many turns are drawn */
+#define ROLLOUT_MAX_TURNS 1000
+
+/* The most distinct rerolls of a dice set */
+#define MAX_ACTIONS 64
+
+/* Actions of a retreat decision */
+#define STAY_ACTION 0
+#define GO_ACTION 1
+
+/* The UCB1 exploration constant */
+#define EXPLORATION_CONSTANT 1.4
+
+#define DRAW_REWARD 0.5
+
+/**
+* An enum for the decisions the search is asked to make.
+*   - REROLL_DECISION, which dice to reroll
+*   - RETREAT_DECISION, whether to leave St Lucia after being attacked
+*/
+typedef enum {
+    REROLL_DECISION,
+    RETREAT_DECISION
+} DecisionType;
+
+/**
+* A struct for a decision being searched, shared by all search threads.
+*   - type, the decision being made
+*   - self, the number of the searching player
+*   - root, the model game at the decision
+*   - dice, the active player's dice, indexed by DiceFace
+*   - rerollsMade, the number of rerolls already made this turn
+*   - numberOfActions, the number of actions available
+*   - actions, the dice each action rerolls, for a reroll decision
+*   - rolloutsPerRoot, the rollouts played from each root
+*   - nextRoot, the next root to be searched by a thread
+*/
+typedef struct {
+    DecisionType type;
+    int self;
+    ModelGame root;
+    int dice[NUMBER_OF_FACES];
+    int rerollsMade;
+    int numberOfActions;
+    int actions[MAX_ACTIONS][NUMBER_OF_FACES];
+    long rolloutsPerRoot;
+    int nextRoot;
+} Decision;
+
+/**
+* A struct for the statistics gathered at one root of the search.
+*   - decision, the decision being searched
+*   - state, the root's random generator state
+*   - visits, the rollouts played from each action
+*   - rewards, the total reward of the rollouts from each action
+*/
+typedef struct {
+    Decision* decision;
+    unsigned long long state;
+    long visits[MAX_ACTIONS];
+    double rewards[MAX_ACTIONS];
+} Searcher;
+
+/**
+* Copies the counts of a dice set into an array indexed by DiceFace.
+*   - diceSet, the dice set to copy
+*   - dice, the array to fill
+*/
+void get_dice_counts(DiceSet* diceSet, int* dice) {
+    dice[FACE_ONE] = diceSet->numberOfOnes;
+    dice[FACE_TWO] = diceSet->numberOfTwos;
+    dice[FACE_THREE] = diceSet->numberOfThrees;
+    dice[FACE_H] = diceSet->numberOfHs;
+    dice[FACE_A] = diceSet->numberOfAs;
+    dice[FACE_P] = diceSet->numberOfPs;
+}
+
+/**
+* Fills the model game with the state the player has tracked from the hub's
+* messages. The score limit is not sent to players, so it is assumed.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - activePlayer, the player whose turn it is
+*   - model, the model game to fill
+*/
+void build_model(Game* game, Player** players, int activePlayer,
+        ModelGame* model) {
+    model->numberOfPlayers = game->numberOfPlayers;
+    model->scoreLimit = integer_setting(SCORE_LIMIT_VARIABLE, SCORE_LIMIT, 1,
+            INT_MAX);
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        model->health[i] = players[i]->health;
+        model->points[i] = players[i]->points;
+        model->tokens[i] = players[i]->tokens;
+        model->alive[i] = players[i]->status != ELIMINATED;
+    }
+    model->playerInStLucia = game->playerInStLucia;
+    model->activePlayer = activePlayer;
+    model->winner = MODEL_PLAYING;
+}
+
+/**
+* Adds every distinct choice of dice to reroll to the decision's actions,
+* starting from the specified face.
+*   - decision, the decision to add actions to
+*   - reroll, the dice chosen so far
+*   - face, the face to choose next
+*/
+void add_reroll_actions(Decision* decision, int* reroll, int face) {
+    if (face == NUMBER_OF_FACES) {
+        memcpy(decision->actions[decision->numberOfActions++], reroll,
+                sizeof(int) * NUMBER_OF_FACES);
+        return;
+    }
+    for (int count = 0; count <= decision->dice[face]; count++) {
+        reroll[face] = count;
+        add_reroll_actions(decision, reroll, face + 1);
+    }
+}
+
+/**
+* Plays a game out from the decision after taking the specified action, with
+* each opponent playing a faculty sampled uniformly. Returns the searching
+* player's reward.
+*   - decision, the decision being searched
+*   - action, the action taken
+*   - state, the random generator state
+*/
+double rollout(Decision* decision, int action, unsigned long long* state) {
+    ModelGame game = decision->root;
+    Strategy strategies[MAX_PLAYERS];
+    for (int i = 0; i < game.numberOfPlayers; i++) {
+        Faculty faculty = (i == decision->self) ? EAIT_FACULTY :
+                (Faculty)(model_random(state) % NUMBER_OF_FACULTIES);
+        default_strategy(faculty, &strategies[i]);
+    }
+    int dice[NUMBER_OF_FACES];
+    memcpy(dice, decision->dice, sizeof(dice));
+
+    if (decision->type == REROLL_DECISION) {
+        int count = 0;
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            dice[face] -= decision->actions[action][face];
+            count += decision->actions[action][face];
+        }
+        model_roll(dice, count, state);
+        if (count > 0) {
+            model_finish_rolls(&game, &strategies[game.activePlayer], dice,
+                    decision->rerollsMade + 1, state);
+        }
+        if (model_heal_and_attack(&game, dice)) {
+            int holder = game.playerInStLucia;
+            if (strategy_retreats(&strategies[holder], game.health[holder],
+                    model_remaining(&game))) {
+                model_claim(&game);
+            }
+        }
+    } else if (action == GO_ACTION) {
+        model_claim(&game);
+    }
+    model_end_turn(&game, dice);
+
+    int winner = model_play_game(&game, strategies, ROLLOUT_MAX_TURNS, state);
+    if (winner == decision->self) {
+        return 1.0;
+    }
+    return (winner == MODEL_DRAWN) ? DRAW_REWARD : 0.0;
+}
+
+/**
+* Returns the action with the highest UCB1 score, trying each action once
+* first.
+*   - searcher, the searching thread's statistics
+*   - totalVisits, the rollouts played so far
+*/
+int select_action(Searcher* searcher, long totalVisits) {
+    int best = 0;
+    double bestScore = -1.0;
+    double logVisits = log((double)totalVisits);
+    for (int i = 0; i < searcher->decision->numberOfActions; i++) {
+        if (searcher->visits[i] == 0) {
+            return i;
+        }
+        double score = searcher->rewards[i] / searcher->visits[i] +
+                EXPLORATION_CONSTANT * sqrt(logVisits / searcher->visits[i]);
+        if (score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+* Searches roots taken from the decision until every root has played its
+* rollouts. Each root is searched independently and merged afterwards.
+*   - argument, the array of SEARCH_ROOTS Searchers
+*/
+void* search_decision(void* argument) {
+    Searcher* searchers = argument;
+    while (true) {
+        int root = __atomic_fetch_add(&searchers[0].decision->nextRoot, 1,
+                __ATOMIC_RELAXED);
+        if (root >= SEARCH_ROOTS) {
+            return NULL;
+        }
+        Searcher* searcher = &searchers[root];
+        for (long totalVisits = 0;
+                totalVisits < searcher->decision->rolloutsPerRoot;
+                totalVisits++) {
+            int action = select_action(searcher, totalVisits);
+            searcher->rewards[action] += rollout(searcher->decision, action,
+                    &searcher->state);
+            searcher->visits[action]++;
+        }
+    }
+}
+
+/**
+* Returns the seed of the decision's search: STLUCIA_SEARCH_SEED combined
+* with everything the decision depends on, so the same decision is always
+* searched the same way and a repeated game state gets the same reply.
+*   - decision, the decision to search
+*/
+unsigned long long decision_seed(Decision* decision) {
+    unsigned long long seed = (unsigned long long)long_integer_setting(
+            SEARCH_SEED_VARIABLE, SEARCH_SEED, LLONG_MIN, LLONG_MAX);
+    unsigned long long hash = hash_bytes(HASH_SEED, &seed, sizeof(seed));
+    hash = hash_bytes(hash, &decision->type, sizeof(decision->type));
+    hash = hash_bytes(hash, &decision->self, sizeof(decision->self));
+    hash = hash_bytes(hash, &decision->root, sizeof(decision->root));
+    hash = hash_bytes(hash, decision->dice, sizeof(decision->dice));
+    return hash_bytes(hash, &decision->rerollsMade,
+            sizeof(decision->rerollsMade));
+}
+
+/**
+* Searches the decision on every core for STLUCIA_DECISION_ROLLOUTS rollouts
+* and returns the action visited most across all roots.
+*   - decision, the decision to search
+*/
+int choose_action(Decision* decision) {
+    if (decision->numberOfActions == 1) {
+        return 0;
+    }
+    int threads = integer_setting(SEARCH_THREADS_VARIABLE, SEARCH_THREADS, 0,
+            INT_MAX);
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > SEARCH_ROOTS) {
+        threads = SEARCH_ROOTS;
+    }
+    decision->rolloutsPerRoot = integer_setting(DECISION_ROLLOUTS_VARIABLE,
+            DECISION_ROLLOUTS, 1, INT_MAX) / SEARCH_ROOTS;
+    if (decision->rolloutsPerRoot < 1) {
+        decision->rolloutsPerRoot = 1;
+    }
+    decision->nextRoot = 0;
+
+    Searcher searchers[SEARCH_ROOTS];
+    pthread_t workers[SEARCH_ROOTS];
+    unsigned long long seed = decision_seed(decision);
+    for (int i = 0; i < SEARCH_ROOTS; i++) {
+        memset(&searchers[i], 0, sizeof(Searcher));
+        searchers[i].decision = decision;
+        searchers[i].state = (seed + (i + 1) * HASH_PRIME) | 1;
+    }
+    int started = 1;
+    while (started < threads && pthread_create(&workers[started], NULL,
+            search_decision, searchers) == 0) {
+        started++;
+    }
+    search_decision(searchers);
+    for (int i = 1; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    int best = 0;
+    long bestVisits = -1;
+    for (int action = 0; action < decision->numberOfActions; action++) {
+        long visits = 0;
+        for (int i = 0; i < SEARCH_ROOTS; i++) {
+            visits += searchers[i].visits[action];
+        }
+        if (visits > bestVisits) {
+            bestVisits = visits;
+            best = action;
+        }
+    }
+    return best;
+}
+
+/**
+* Decides which dice to reroll by searching the rerolls of the latest dice,
+* and sends the hub the appropriate message.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - rollFile, the roll file containing the latest rolls
+*/
+void reroll(Game* game, Player** players, RollFile* rollFile) {
+    static Decision decision;
+    decision.type = REROLL_DECISION;
+    decision.self = game->currentPlayerNumber;
+    build_model(game, players, game->currentPlayerNumber, &decision.root);
+    model_begin_turn(&decision.root);
+    get_dice_counts(rollFile->latestDice, decision.dice);
+    decision.rerollsMade = game->numberOfRerolls;
+    decision.numberOfActions = 0;
+    int reroll[NUMBER_OF_FACES];
+    add_reroll_actions(&decision, reroll, 0);
+
+    int* chosen = decision.actions[choose_action(&decision)];
+    rollFile->rerollDice->numberOfOnes = chosen[FACE_ONE];
+    rollFile->rerollDice->numberOfTwos = chosen[FACE_TWO];
+    rollFile->rerollDice->numberOfThrees = chosen[FACE_THREE];
+    rollFile->rerollDice->numberOfHs = chosen[FACE_H];
+    rollFile->rerollDice->numberOfAs = chosen[FACE_A];
+    rollFile->rerollDice->numberOfPs = chosen[FACE_P];
+
+    if (sum_dice_set(rollFile->rerollDice) == 0) {
+        act_on_dice(game, players);
+    } else {
+        create_dice_set_string(rollFile->rerollDice);
+        fprintf(stdout, "reroll %s\n", rollFile->rerollDice->rollString);
+        fflush(stdout);
+    }
+}
+
+/**
+* Decides whether to retreat after being attacked by searching both replies.
+* Returns true if so, otherwise returns false.
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+bool retreat(Game* game, Player** players) {
+    if (players[game->currentPlayerNumber]->health <= 0) {
+        return true;
+    }
+    static Decision decision;
+    int attacker = game->rollingPlayerNumber;
+    decision.type = RETREAT_DECISION;
+    decision.self = game->currentPlayerNumber;
+    build_model(game, players, attacker, &decision.root);
+    get_dice_counts(game->rollFile->oppositionDice, decision.dice);
+    /* The attacker's tokens already include this roll, which ending the
+    turn in the model adds again */
+    decision.root.tokens[attacker] = (decision.root.tokens[attacker] +
+            TOKENS_POINTS_THRESHOLD - decision.dice[FACE_P]) %
+            TOKENS_POINTS_THRESHOLD;
+    decision.numberOfActions = GO_ACTION + 1;
+    return choose_action(&decision) == GO_ACTION;
+}
+
+/**
+* Returns false, as every decision is searched so the hub must ask for it.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - policy, the policy message to write
+*/
+bool describe_policy(Game* game, Player** players, char* policy) {
+    return false;
+}
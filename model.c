@@ -0,0 +1,211 @@
+#include <stdbool.h>
+#include "shared.h"
+#include "lockstep.h"
+#include "model.h"
+
+/* Multiplier of the xorshift64* generator */
+#define MODEL_RANDOM_MULTIPLIER 2685821657736338717ULL
+#define MODEL_RANDOM_BITS 32
+
+/**
+* Returns the next number from a xorshift64* generator. The state must not
+* be 0.
+*   - state, the generator state
+*/
+unsigned long long model_random(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * MODEL_RANDOM_MULTIPLIER;
+}
+
+/**
+* Adds the specified number of random dice to the dice.
+*   - dice, the dice, indexed by DiceFace
+*   - count, the number of dice to roll
+*   - state, the generator state
+*/
+void model_roll(int* dice, int count, unsigned long long* state) {
+    for (int i = 0; i < count; i++) {
+        dice[(model_random(state) >> MODEL_RANDOM_BITS) % NUMBER_OF_FACES]++;
+    }
+}
+
+/**
+* Returns the number of players not eliminated.
+*   - game, the model game
+*/
+int model_remaining(ModelGame* game) {
+    int remaining = 0;
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        remaining += game->alive[i];
+    }
+    return remaining;
+}
+
+/**
+* Awards the St Lucia points if the active player starts their turn there.
+*   - game, the model game
+*/
+void model_begin_turn(ModelGame* game) {
+    if (game->playerInStLucia == game->activePlayer) {
+        game->points[game->activePlayer] += STARTING_IN_STLUCIA_POINTS;
+    }
+}
+
+/**
+* Makes the active player's remaining rerolls by the specified strategy.
+*   - game, the model game
+*   - strategy, the strategy of the active player
+*   - dice, the dice held, indexed by DiceFace
+*   - rerollsMade, the number of rerolls already made this turn
+*   - state, the generator state
+*/
+void model_finish_rolls(ModelGame* game, Strategy* strategy, int* dice,
+        int rerollsMade, unsigned long long* state) {
+    int active = game->activePlayer;
+    int holder = game->playerInStLucia;
+    int holderHealth = (holder == EMPTY_STLUCIA) ? STARTING_HEALTH + 1 :
+            game->health[holder];
+    for (int i = rerollsMade; i < LOCKSTEP_ALLOWED_REROLLS; i++) {
+        int reroll[NUMBER_OF_FACES];
+        int count = strategy_reroll(strategy, game->health[active],
+                holder == active, holderHealth, dice, reroll);
+        if (count == 0) {
+            return;
+        }
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            dice[face] -= reroll[face];
+        }
+        model_roll(dice, count, state);
+    }
+}
+
+/**
+* Heals the active player and resolves their attacks, as heal() and attack()
+* do. Returns true if the player in St Lucia was attacked and survived, so
+* must choose whether to retreat.
+*   - game, the model game
+*   - dice, the active player's dice, indexed by DiceFace
+*/
+bool model_heal_and_attack(ModelGame* game, const int* dice) {
+    int active = game->activePlayer;
+    int holder = game->playerInStLucia;
+    if (holder != active) {
+        game->health[active] += dice[FACE_H];
+        if (game->health[active] > STARTING_HEALTH) {
+            game->health[active] = STARTING_HEALTH;
+        }
+    }
+    int damage = dice[FACE_A];
+    if (damage == 0) {
+        return false;
+    }
+    if (holder == EMPTY_STLUCIA) {
+        model_claim(game);
+    } else if (holder == active) {
+        for (int i = 0; i < game->numberOfPlayers; i++) {
+            if (i != active && game->alive[i]) {
+                game->health[i] = (game->health[i] < damage) ? 0 :
+                        game->health[i] - damage;
+            }
+        }
+    } else {
+        game->health[holder] = (game->health[holder] < damage) ? 0 :
+                game->health[holder] - damage;
+        if (game->health[holder] == 0) {
+            model_claim(game);
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+* Moves the active player into St Lucia, as claim_stlucia() does.
+*   - game, the model game
+*/
+void model_claim(ModelGame* game) {
+    game->playerInStLucia = game->activePlayer;
+    game->points[game->activePlayer]++;
+}
+
+/**
+* Scores the active player's dice, eliminates players with no health, checks
+* for a winner and passes the turn on, as the end of run_game()'s turn does.
+*   - game, the model game
+*   - dice, the active player's dice, indexed by DiceFace
+*/
+void model_end_turn(ModelGame* game, const int* dice) {
+    int active = game->activePlayer;
+    game->tokens[active] += dice[FACE_P];
+    game->points[active] += game->tokens[active] / TOKENS_POINTS_THRESHOLD;
+    game->tokens[active] %= TOKENS_POINTS_THRESHOLD;
+    if (dice[FACE_ONE] > DICE_POINTS_THRESHOLD) {
+        game->points[active] += dice[FACE_ONE] - ONES_DICE_POINT_PENALTY;
+    }
+    if (dice[FACE_TWO] > DICE_POINTS_THRESHOLD) {
+        game->points[active] += dice[FACE_TWO] - TWOS_DICE_POINT_PENALTY;
+    }
+    if (dice[FACE_THREE] > DICE_POINTS_THRESHOLD) {
+        game->points[active] += dice[FACE_THREE] - THREES_DICE_POINT_PENALTY;
+    }
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        if (game->health[i] < 1) {
+            game->alive[i] = 0;
+        }
+    }
+    if (model_remaining(game) == 1 ||
+            game->points[active] >= game->scoreLimit) {
+        game->winner = active;
+        return;
+    }
+    do {
+        active = (active + 1) % game->numberOfPlayers;
+    } while (!game->alive[active]);
+    game->activePlayer = active;
+}
+
+/**
+* Plays the active player's turn with random dice, every player using the
+* strategy of their seat.
+*   - game, the model game
+*   - strategies, the strategy of each player
+*   - state, the generator state
+*/
+void model_play_turn(ModelGame* game, Strategy* strategies,
+        unsigned long long* state) {
+    int dice[NUMBER_OF_FACES] = {0};
+    model_begin_turn(game);
+    model_roll(dice, DICE_SET_SIZE, state);
+    model_finish_rolls(game, &strategies[game->activePlayer], dice, 0, state);
+    if (model_heal_and_attack(game, dice)) {
+        int holder = game->playerInStLucia;
+        if (strategy_retreats(&strategies[holder], game->health[holder],
+                model_remaining(game))) {
+            model_claim(game);
+        }
+    }
+    model_end_turn(game, dice);
+}
+
+/**
+* Plays the game to the end and returns the winner, or MODEL_DRAWN if it
+* lasts more than the specified number of turns.
+*   - game, the model game
+*   - strategies, the strategy of each player
+*   - maxTurns, the number of turns after which the game is drawn
+*   - state, the generator state
+*/
+int model_play_game(ModelGame* game, Strategy* strategies, int maxTurns,
+        unsigned long long* state) {
+    for (int turn = 0; turn < maxTurns && game->winner == MODEL_PLAYING;
+            turn++) {
+        model_play_turn(game, strategies, state);
+    }
+    if (game->winner == MODEL_PLAYING) {
+        game->winner = MODEL_DRAWN;
+    }
+    return game->winner;
+}
@@ -0,0 +1,48 @@
+#include <stdbool.h>
+#include "shared.h"
+#include "lockstep.h"
+
+#ifndef MODEL_H
+#define MODEL_H
+
+/* Values of ModelGame::winner other than a player number */
+#define MODEL_PLAYING -1
+#define MODEL_DRAWN -2
+
+/**
+* A struct for the compact state of a game simulated in memory, with the
+* same rules as the hub but random dice in place of the roll file.
+*   - numberOfPlayers, the number of players in the game
+*   - scoreLimit, the score limit of the game
+*   - health, points, tokens, alive, per player state
+*   - playerInStLucia, the player in St Lucia or EMPTY_STLUCIA
+*   - activePlayer, the player whose turn it is
+*   - winner, the winning player, or MODEL_PLAYING or MODEL_DRAWN
+*/
+typedef struct {
+    int numberOfPlayers;
+    int scoreLimit;
+    int health[MAX_PLAYERS];
+    int points[MAX_PLAYERS];
+    int tokens[MAX_PLAYERS];
+    int alive[MAX_PLAYERS];
+    int playerInStLucia;
+    int activePlayer;
+    int winner;
+} ModelGame;
+
+/* Function prototypes */
+unsigned long long model_random(unsigned long long* state);
+void model_roll(int* dice, int count, unsigned long long* state);
+int model_remaining(ModelGame* game);
+void model_begin_turn(ModelGame* game);
+void model_finish_rolls(ModelGame* game, Strategy* strategy, int* dice,
+        int rerollsMade, unsigned long long* state);
+bool model_heal_and_attack(ModelGame* game, const int* dice);
+void model_claim(ModelGame* game);
+void model_end_turn(ModelGame* game, const int* dice);
+void model_play_turn(ModelGame* game, Strategy* strategies,
+        unsigned long long* state);
+int model_play_game(ModelGame* game, Strategy* strategies, int maxTurns,
+        unsigned long long* state);
+#endif
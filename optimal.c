@@ -0,0 +1,64 @@
+#include "shared.h"
+#include "policy.h"
+#define RETREAT_HEALTH_THRESHOLD 5
+
+/**
+* Decides whether to reroll by looking up the latest dice in the reroll 
+* policy table, and sends the hub the appropriate message.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - rollFile, the roll file containing the latest rolls
+*/
+void reroll(Game* game, Player** players, RollFile* rollFile) {
+    int counts[NUMBER_OF_FACES] = {
+        rollFile->latestDice->numberOfOnes,
+        rollFile->latestDice->numberOfTwos,
+        rollFile->latestDice->numberOfThrees,
+        rollFile->latestDice->numberOfHs,
+        rollFile->latestDice->numberOfAs,
+        rollFile->latestDice->numberOfPs
+    };
+    unpack_dice_counts(rerollPolicy[game->numberOfRerolls]
+            [rank_dice_counts(counts)], counts);
+    rollFile->rerollDice->numberOfOnes = counts[FACE_ONE];
+    rollFile->rerollDice->numberOfTwos = counts[FACE_TWO];
+    rollFile->rerollDice->numberOfThrees = counts[FACE_THREE];
+    rollFile->rerollDice->numberOfHs = counts[FACE_H];
+    rollFile->rerollDice->numberOfAs = counts[FACE_A];
+    rollFile->rerollDice->numberOfPs = counts[FACE_P];
+
+    if (sum_dice_set(rollFile->rerollDice) == 0) {
+        act_on_dice(game, players);
+    } else {
+        create_dice_set_string(rollFile->rerollDice);
+        fprintf(stdout, "reroll %s\n", rollFile->rerollDice->rollString);
+        fflush(stdout);
+    }
+}
+
+/**
+* Decides whether to retreat after being attacked. Returns true if so,
+* otherwise returns false.
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+bool retreat(Game* game, Player** players) {
+    if (players[game->currentPlayerNumber]->health <
+            RETREAT_HEALTH_THRESHOLD) {
+        return true;
+    }
+    return false;
+}
+
+/**
+* Writes the policy the hub can play for this player and returns true. Rerolls
+* are looked up in the table, so are left to the player.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - policy, the policy message to write
+*/
+bool describe_policy(Game* game, Player** players, char* policy) {
+    sprintf(policy, "policy 00 %s %s %02d", POLICY_INTERACTIVE,
+            POLICY_INTERACTIVE, RETREAT_HEALTH_THRESHOLD);
+    return true;
+}
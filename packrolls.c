@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "shared.h"
+
+/* Argument information for the roll file converter */
+#define PACK_ARGS 3
+#define PACK_INPUT_ARGUMENT_INDEX 1
+#define PACK_OUTPUT_ARGUMENT_INDEX 2
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, the roll file was converted
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - OPEN_ERROR, unable to open the roll file for reading
+*   - INVALID_FILE, contents of the roll file are invalid
+*   - WRITE_ERROR, unable to write the packed roll file
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    OPEN_ERROR = 2,
+    INVALID_FILE = 3,
+    WRITE_ERROR = 4
+} ExitCodes;
+
+/**
+* Exits the program with the specified exit status. Prints the corresponding
+* error message to stderr.
+*   - exitStatus, the exit status
+*/
+void exit_program(ExitCodes exitStatus) {
+    const char* errorString;
+    switch (exitStatus) {
+        case SUCCESS:
+            exit(SUCCESS);
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-packrolls rollfile packedfile";
+            break;
+        case OPEN_ERROR:
+            errorString = "Unable to access rollfile";
+            break;
+        case INVALID_FILE:
+            errorString = "Error reading rolls";
+            break;
+        case WRITE_ERROR:
+            errorString = "Unable to write packed rolls";
+            break;
+    }
+    fprintf(stderr, "%s\n", errorString);
+    exit(exitStatus);
+}
+
+int main(int argc, char** argv) {
+    if (argc != PACK_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    unsigned char* packedRolls;
+    int size = read_packed_roll_file(argv[PACK_INPUT_ARGUMENT_INDEX],
+            &packedRolls);
+    if (size < 0) {
+        exit_program(OPEN_ERROR);
+    } else if (size == 0) {
+        exit_program(INVALID_FILE);
+    }
+    if (!write_packed_roll_file(argv[PACK_OUTPUT_ARGUMENT_INDEX], packedRolls,
+            size)) {
+        exit_program(WRITE_ERROR);
+    }
+    printf("Packed %d dice into %zu bytes\n", size,
+            PACKED_ROLL_HEADER_LENGTH + packed_roll_bytes(size));
+    free(packedRolls);
+    exit_program(SUCCESS);
+    return 0;
+}
@@ -9,6 +9,7 @@
 #include <fcntl.h>
 #include <signal.h>
 #include "shared.h"
+#include "allocations.h"
 
 /* Game constants */
 #define ALLOWED_REROLLS 2
@@ -16,8 +17,14 @@
 /* Format properties of the player arguments, for error
 checking */
 #define PLAYER_ARGUMENT_COUNT 3
+#define MULTIPLEXED_ARGUMENT_COUNT 4
 #define LABEL_ARGUMENT_INDEX 2
 #define PLAYER_COUNT_ARGUMENT_INDEX 1
+#define TABLES_ARGUMENT_INDEX 3
+#define MAX_TABLES 4096
+
+/* Messages of a multiplexed player start with this and the game's table */
+#define TABLE_TAG '@'
 
 /* Format properties of all the messages the player can receive, for error
 checking */
@@ -66,6 +73,8 @@ checking */
 *   - INVALID_ID, invalid player ID 
 *   - PIPING_FAILURE, pipe from stlucia closed unexpectedly
 *   - INVALID_MESSAGE, unexpectedly lost contact with StLucia
+*   - INVALID_TABLES, invalid number of tables
+*   - MEMORY_FAILURE, the games of the tables could not be allocated
 */
 typedef enum {
     SUCCESS = 0,
@@ -73,9 +82,24 @@ typedef enum {
     INVALID_PLAYER_COUNT = 2,
     INVALID_ID = 3,
     PIPING_FAILURE = 4,
-    INVALID_MESSAGE = 5
+    INVALID_MESSAGE = 5,
+    INVALID_TABLES = 6,
+    MEMORY_FAILURE = 7
 } ExitCodes;
 
+/**
+* A struct for the state of one game a multiplexed player is playing.
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+typedef struct {
+    Game* game;
+    Player** players;
+} Table;
+
+/* The number of games played at once, or 0 if the player plays one game */
+int numberOfTables = 0;
+
 /**
 * Exits the game, with the specified exit status and a message.
 *   - game, a struct of the game state
@@ -83,6 +107,7 @@ typedef enum {
 *   - exitStatus, the exit status to exit with
 */
 void exit_program(Game* game, Player** players, ExitCodes exitStatus) {
+    set_allocation_phase(PHASE_EXIT);
     free_allocated_memory(game, players);
 
     char* errorString;
@@ -91,7 +116,8 @@ void exit_program(Game* game, Player** players, ExitCodes exitStatus) {
             errorString = "";
             break;
         case INVALID_ARGUMENT_COUNT:
-            errorString = "Usage: player number_of_players my_id\n";
+            errorString = "Usage: player number_of_players my_id "
+                    "[tables]\n";
             break;
         case INVALID_PLAYER_COUNT:
             errorString = "Invalid player count\n";
@@ -105,11 +131,40 @@ void exit_program(Game* game, Player** players, ExitCodes exitStatus) {
         case INVALID_MESSAGE:
             errorString = "Bad message from StLucia\n";
             break;
+        case INVALID_TABLES:
+            errorString = "Invalid number of tables\n";
+            break;
+        case MEMORY_FAILURE:
+            errorString = "Unable to allocate tables\n";
+            break;
     }
     fprintf(stderr, "%s", errorString);
+    report_allocations();
     exit((int)exitStatus);
 }
 
+/**
+* Ends the player's part in a game. A player playing one game exits, while a
+* multiplexed player resets the game's state for the table's next game.
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+void end_game(Game* game, Player** players) {
+    if (numberOfTables == 0) {
+        exit_program(game, players, SUCCESS);
+    }
+    game->playerInStLucia = EMPTY_STLUCIA;
+    game->numberOfRerolls = 0;
+    game->rollingPlayerNumber = 0;
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        players[i]->health = STARTING_HEALTH;
+        players[i]->tokens = 0;
+        players[i]->points = 0;
+        players[i]->status = UNCONNECTED;
+    }
+    game->stateHash = hash_game_state(game, players);
+}
+
 /**
 * Sends the hub "keepall", accepts the rolled dice and acts on the roll.
 *   - game, a struct of the game state
@@ -118,6 +173,10 @@ void exit_program(Game* game, Player** players, ExitCodes exitStatus) {
 void act_on_dice(Game* game, Player** players) {
     fprintf(stdout, "keepall\n"); 
     fflush(stdout);
+    set_tokens(game->currentPlayerNumber, 
+            (players[game->currentPlayerNumber]->tokens + 
+            game->rollFile->latestDice->numberOfPs) % TOKENS_POINTS_THRESHOLD,
+            game, players);
     heal(game->currentPlayerNumber, game, players, false, 
             game->rollFile->latestDice->numberOfHs);
 }
@@ -139,7 +198,9 @@ void handle_turn(char* roll, Game* game, Player** players) {
         act_on_dice(game, players);
         return;
     }
+    long long span = trace_begin();
     reroll(game, players, game->rollFile);
+    trace_end("reroll", span);
 }
 
 /**
@@ -169,6 +230,7 @@ void validate_turn(char* message, Game* game, Player** players,
         char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH], int numberCommands) {
     if (strcmp(commands[0], "turn") == 0) {
         game->numberOfRerolls = 0;
+        game->rollingPlayerNumber = game->currentPlayerNumber;
         if (strlen(commands[TURN_DICE_ROLL_INDEX]) != DICE_SET_SIZE ||
                 numberCommands != TURN_MESSAGE_SIZE ||
                 invalid_roll(commands[TURN_DICE_ROLL_INDEX])) {
@@ -216,14 +278,16 @@ void validate_rolled(char* message, Game* game, Player** players,
             invalid_roll(commands[ROLLED_DICE_ROLL_INDEX])) {
         exit_program(game, players, INVALID_MESSAGE);
     }
-    int healing = 0;
+    int player = get_player_number(commands[ROLLED_PLAYER_LABEL_INDEX][0]);
+    DiceSet* dice = game->rollFile->oppositionDice;
+    reset_dice_set(dice);
     for (int i = 0; i < DICE_SET_SIZE; i++) {
-        if (commands[ROLLED_DICE_ROLL_INDEX][i] == 'H') {
-            healing++;
-        }
+        add_die_to_dice_set(dice, commands[ROLLED_DICE_ROLL_INDEX][i]);
     }
-    heal(get_player_number(commands[ROLLED_PLAYER_LABEL_INDEX][0]), game, 
-            players, false, healing);
+    game->rollingPlayerNumber = player;
+    set_tokens(player, (players[player]->tokens + dice->numberOfPs) %
+            TOKENS_POINTS_THRESHOLD, game, players);
+    heal(player, game, players, false, dice->numberOfHs);
 }
 
 /**
@@ -243,6 +307,8 @@ void validate_points(char* message, Game* game, Player** players,
             numberCommands != POINTS_MESSAGE_SIZE) {
         exit_program(game, players, INVALID_MESSAGE);
     }
+    add_points(get_player_number(commands[POINTS_PLAYER_LABEL_INDEX][0]),
+            atoi(commands[POINTS_VALUE_INDEX]), game, players);
 }
 
 /**
@@ -300,9 +366,13 @@ void validate_eliminated(char* message, Game* game, Player** players,
         exit_program(game, players, INVALID_MESSAGE);
     }
     int player = get_player_number(commands[ELIMINATED_PLAYER_LABEL_INDEX][0]);
-    players[player]->status = ELIMINATED;
+    set_player_status(player, ELIMINATED, game, players);
+    //a hub tolerating failures eliminates a failed player wherever it is
+    if (player == game->playerInStLucia) {
+        set_player_in_stlucia(EMPTY_STLUCIA, game);
+    }
     if (player == game->currentPlayerNumber) {
-        exit_program(game, players, SUCCESS);
+        end_game(game, players);
     }
 }
 
@@ -322,8 +392,8 @@ void validate_claim(char* message, Game* game, Player** players,
             numberCommands != CLAIM_MESSAGE_SIZE) {
         exit_program(game, players, INVALID_MESSAGE);
     }
-    game->playerInStLucia = 
-            get_player_number(commands[CLAIM_PLAYER_LABEL_INDEX][0]);
+    set_player_in_stlucia(
+            get_player_number(commands[CLAIM_PLAYER_LABEL_INDEX][0]), game);
 }
 
 /**
@@ -365,7 +435,7 @@ void validate_winner(char* message, Game* game, Player** players,
             numberCommands != WINNER_MESSAGE_SIZE) {
         exit_program(game, players, INVALID_MESSAGE);
     }
-    exit_program(game, players, SUCCESS);
+    end_game(game, players);
 }
 
 /**
@@ -381,7 +451,7 @@ void validate_shutdown(char* message, Game* game, Player** players,
     if (numberCommands != SHUTDOWN_MESSAGE_SIZE) {
         exit_program(game, players, INVALID_MESSAGE);
     }
-    exit_program(game, players, SUCCESS);
+    end_game(game, players);
 }
 
 /**
@@ -392,6 +462,7 @@ void validate_shutdown(char* message, Game* game, Player** players,
 *   - players, an array of players
 */
 void handle_message(char* message, Game* game, Player** players) {
+    long long span = trace_begin();
     fprintf(stderr, "From StLucia:%s", message);  
     char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH];
     int numberCommands = interpret_message(message, commands);
@@ -419,6 +490,7 @@ void handle_message(char* message, Game* game, Player** players) {
     } else {
         exit_program(game, players, INVALID_MESSAGE);
     }
+    trace_end(commands[0], span);
 }
 
 /**
@@ -431,6 +503,7 @@ void handle_message(char* message, Game* game, Player** players) {
 void initiate_response_loop(Game* game, Player** players) {
     char message[MAX_MESSAGE_LENGTH];
     char* error;
+    set_allocation_phase(PHASE_TURNS);
     while (true) {
         error = fgets(message, MAX_MESSAGE_LENGTH, stdin);
         if (error == NULL) {
@@ -440,6 +513,87 @@ void initiate_response_loop(Game* game, Player** players) {
     }
 }
 
+/**
+* Returns true if the player answers the specified message from the hub.
+*   - message, the message received from the hub
+*/
+bool expects_reply(char* message) {
+    char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH];
+    interpret_message(message, commands);
+    return strcmp(commands[0], "turn") == 0 || 
+            strcmp(commands[0], "rerolled") == 0 ||
+            strcmp(commands[0], "stay?") == 0;
+}
+
+/**
+* Allocates the state of every game a multiplexed player plays up front, the
+* first table using the game and players already set up. Returns NULL if
+* the tables cannot be allocated.
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+Table* allocate_tables(Game* game, Player** players) {
+    Table* tables = malloc(sizeof(Table) * numberOfTables);
+    if (tables == NULL) {
+        return NULL;
+    }
+    tables[0].game = game;
+    tables[0].players = players;
+    for (int i = 1; i < numberOfTables; i++) {
+        tables[i].game = malloc(sizeof(Game));
+        if (tables[i].game == NULL) {
+            return NULL;
+        }
+        initialise_game(tables[i].game);
+        tables[i].game->numberOfPlayers = game->numberOfPlayers;
+        tables[i].game->currentPlayerNumber = game->currentPlayerNumber;
+        tables[i].players = malloc(sizeof(Player*) * game->numberOfPlayers);
+        if (tables[i].players == NULL) {
+            return NULL;
+        }
+        initialise_players(tables[i].game, tables[i].players);
+        tables[i].game->mallocProgress = PLAYERS;
+    }
+    return tables;
+}
+
+/**
+* Starts a loop that waits for messages from the hub for any of the games a
+* multiplexed player is playing. Each message starts with '@' and the table
+* of its game, and the player's replies are tagged the same way. An untagged
+* "shutdown" ends every game. If an error occurs this will exit the program.
+*   - tables, the state of the game at each table
+*/
+void initiate_multiplexed_loop(Table* tables) {
+    char message[MAX_MESSAGE_LENGTH];
+    set_allocation_phase(PHASE_TURNS);
+    while (true) {
+        if (fgets(message, MAX_MESSAGE_LENGTH, stdin) == NULL) {
+            exit_program(tables[0].game, tables[0].players, PIPING_FAILURE);
+        }
+        if (message[0] != TABLE_TAG) {
+            if (strcmp(message, "shutdown\n") != 0) {
+                exit_program(tables[0].game, tables[0].players, 
+                        INVALID_MESSAGE);
+            }
+            exit_program(tables[0].game, tables[0].players, SUCCESS);
+        }
+        char* tagEnd;
+        long table = strtol(message + 1, &tagEnd, 
+                BASE_FOR_INTEGER_CONVERSION);
+        if (tagEnd == message + 1 || *tagEnd != ' ' || table < 0 ||
+                table >= numberOfTables) {
+            exit_program(tables[0].game, tables[0].players, 
+                    INVALID_MESSAGE);
+        }
+        if (expects_reply(tagEnd + 1)) {
+            fprintf(stdout, "%c%ld ", TABLE_TAG, table);
+        }
+        handle_message(tagEnd + 1, tables[table].game, 
+                tables[table].players);
+    }
+}
+
 int main(int argc, char** argv) {
     //Define SIGINT and SIGPIPE handlers
     struct sigaction sigint;
@@ -451,11 +605,16 @@ int main(int argc, char** argv) {
     sigpipe.sa_handler = SIG_IGN;
     sigaction(SIGPIPE, &sigpipe, 0);
 
+    //stdin is given its buffer now rather than by the first message read
+    char inputBuffer[BUFSIZ];
+    setvbuf(stdin, inputBuffer, _IOFBF, sizeof(inputBuffer));
+
     Game* game = malloc(sizeof(Game));
     initialise_game(game);
     game->mallocProgress = GAME;
 
-    if (argc != PLAYER_ARGUMENT_COUNT) {
+    if (argc != PLAYER_ARGUMENT_COUNT && 
+            argc != MULTIPLEXED_ARGUMENT_COUNT) {
         exit_program(game, NULL, INVALID_ARGUMENT_COUNT);
     }
 
@@ -482,9 +641,38 @@ int main(int argc, char** argv) {
     if (strlen(argv[LABEL_ARGUMENT_INDEX]) != 1) {
         exit_program(game, players, INVALID_ID);
     }
-    fprintf(stdout, "!");
+    Table* tables = NULL;
+    if (argc == MULTIPLEXED_ARGUMENT_COUNT) {
+        char* tablesError;
+        numberOfTables = (int)strtol(argv[TABLES_ARGUMENT_INDEX], 
+                &tablesError, BASE_FOR_INTEGER_CONVERSION);
+        if (*tablesError != '\0' || numberOfTables < 1 || 
+                numberOfTables > MAX_TABLES) {
+            exit_program(game, players, INVALID_TABLES);
+        }
+        //allocated before the handshake, so a failure shows as a player
+        //that does not play tables
+        tables = allocate_tables(game, players);
+        if (tables == NULL) {
+            exit_program(game, players, MEMORY_FAILURE);
+        }
+    }
+    char traceName[MAX_TRACE_EVENT_LENGTH];
+    snprintf(traceName, MAX_TRACE_EVENT_LENGTH, "Player %s (%s)", 
+            argv[LABEL_ARGUMENT_INDEX], argv[0]);
+    open_trace(traceName);
+
+    char policy[MAX_MESSAGE_LENGTH];
+    if (describe_policy(game, players, policy)) {
+        fprintf(stdout, "#%s\n", policy);
+    } else {
+        fprintf(stdout, "!");
+    }
     fflush(stdout);
 
+    if (tables != NULL) {
+        initiate_multiplexed_loop(tables);
+    }
     initiate_response_loop(game, players);
 
     exit_program(game, players, SUCCESS);
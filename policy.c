@@ -0,0 +1,78 @@
+#include "shared.h"
+#include "policy.h"
+
+/*
+* The number of ways to distribute n dice among k faces, indexed [n][k], for
+* ranking sets of DICE_SET_SIZE dice.
+*/
+const int distributions[DICE_SET_SIZE + 1][NUMBER_OF_FACES + 1] = {
+    {1, 1, 1, 1, 1, 1, 1},
+    {0, 1, 2, 3, 4, 5, 6},
+    {0, 1, 3, 6, 10, 15, 21},
+    {0, 1, 4, 10, 20, 35, 56},
+    {0, 1, 5, 15, 35, 70, 126},
+    {0, 1, 6, 21, 56, 126, 252},
+    {0, 1, 7, 28, 84, 210, 462},
+};
+
+/**
+* Returns the rank, from 0 to POLICY_DICE_SETS - 1, of a set of 
+* DICE_SET_SIZE dice in lexicographic order of their face counts.
+*   - counts, the number of each face, indexed by DiceFace
+*/
+int rank_dice_counts(const int* counts) {
+    int rank = 0;
+    int remaining = DICE_SET_SIZE;
+    for (int face = 0; face < NUMBER_OF_FACES - 1; face++) {
+        int facesAfter = NUMBER_OF_FACES - 1 - face;
+        for (int count = 0; count < counts[face]; count++) {
+            rank += distributions[remaining - count][facesAfter];
+        }
+        remaining -= counts[face];
+    }
+    return rank;
+}
+
+/**
+* Sets the face counts of the set of DICE_SET_SIZE dice with the specified 
+* rank. The inverse of rank_dice_counts().
+*   - rank, the rank of the dice set
+*   - counts, the number of each face, indexed by DiceFace
+*/
+void unrank_dice_counts(int rank, int* counts) {
+    int remaining = DICE_SET_SIZE;
+    for (int face = 0; face < NUMBER_OF_FACES - 1; face++) {
+        int facesAfter = NUMBER_OF_FACES - 1 - face;
+        counts[face] = 0;
+        while (rank >= distributions[remaining][facesAfter]) {
+            rank -= distributions[remaining][facesAfter];
+            remaining--;
+            counts[face]++;
+        }
+    }
+    counts[NUMBER_OF_FACES - 1] = remaining;
+}
+
+/**
+* Packs face counts into a policy table entry.
+*   - counts, the number of each face, indexed by DiceFace
+*/
+unsigned int pack_dice_counts(const int* counts) {
+    unsigned int packed = 0;
+    for (int face = 0; face < NUMBER_OF_FACES; face++) {
+        packed |= (unsigned int)counts[face] << (face * POLICY_FACE_BITS);
+    }
+    return packed;
+}
+
+/**
+* Unpacks a policy table entry into face counts.
+*   - packed, the policy table entry
+*   - counts, the number of each face, indexed by DiceFace
+*/
+void unpack_dice_counts(unsigned int packed, int* counts) {
+    for (int face = 0; face < NUMBER_OF_FACES; face++) {
+        counts[face] = (int)(packed >> (face * POLICY_FACE_BITS)) &
+                POLICY_FACE_MASK;
+    }
+}
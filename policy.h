@@ -0,0 +1,25 @@
+#include "shared.h"
+
+#ifndef POLICY_H
+#define POLICY_H
+
+/* Shape of the reroll policy table */
+#define POLICY_STAGES 2
+#define POLICY_DICE_SETS 462
+#define POLICY_FACE_BITS 3
+#define POLICY_FACE_MASK 7
+
+/**
+* The reroll policy table, generated by stlucia-policygen. Indexed by the
+* number of rerolls already made this turn and the rank of the dice held, 
+* each entry packs the number of each face to reroll into POLICY_FACE_BITS 
+* bits, FACE_ONE in the lowest bits.
+*/
+extern const unsigned int rerollPolicy[POLICY_STAGES][POLICY_DICE_SETS];
+
+/* Function prototypes */
+int rank_dice_counts(const int* counts);
+void unrank_dice_counts(int rank, int* counts);
+unsigned int pack_dice_counts(const int* counts);
+void unpack_dice_counts(unsigned int packed, int* counts);
+#endif
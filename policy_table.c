@@ -0,0 +1,166 @@
+/*
+* Reroll policy generated by stlucia-policygen 1 0.2 0.3. Do not edit.
+* Expected turn utility 2.583493.
+*/
+#include "policy.h"
+
+const unsigned int rerollPolicy[POLICY_STAGES][POLICY_DICE_SETS] = {
+    {
+        0x30000, 0x29000, 0x22000, 0x1b000, 0x14000, 0x0d000,
+        0x00000, 0x28200, 0x21200, 0x1a200, 0x13200, 0x0c200,
+        0x05200, 0x20400, 0x19400, 0x12400, 0x0b400, 0x04400,
+        0x18600, 0x11600, 0x0a600, 0x03600, 0x10800, 0x09800,
+        0x02800, 0x08a00, 0x01a00, 0x00c00, 0x28000, 0x21000,
+        0x1a000, 0x13000, 0x0c000, 0x05000, 0x20200, 0x19200,
+        0x12200, 0x0b200, 0x04200, 0x18400, 0x11400, 0x0a400,
+        0x03400, 0x10600, 0x09600, 0x02600, 0x08800, 0x01800,
+        0x00a00, 0x20000, 0x19000, 0x12000, 0x0b000, 0x04000,
+        0x18200, 0x11200, 0x0a200, 0x03200, 0x10400, 0x09400,
+        0x02400, 0x08600, 0x01600, 0x00800, 0x18000, 0x11000,
+        0x0a000, 0x03000, 0x10200, 0x09200, 0x02200, 0x08400,
+        0x01400, 0x00600, 0x10000, 0x09000, 0x02000, 0x08200,
+        0x01200, 0x00400, 0x08000, 0x01000, 0x00200, 0x00000,
+        0x28000, 0x21000, 0x1a000, 0x13000, 0x0c000, 0x05000,
+        0x20200, 0x19200, 0x12200, 0x0b200, 0x04200, 0x18400,
+        0x11400, 0x0a400, 0x03400, 0x10600, 0x09600, 0x02600,
+        0x08800, 0x01800, 0x00a00, 0x20008, 0x19008, 0x12008,
+        0x0b008, 0x04008, 0x18208, 0x11208, 0x0a208, 0x03208,
+        0x10408, 0x09408, 0x02408, 0x08608, 0x01608, 0x00808,
+        0x18008, 0x11008, 0x0a008, 0x03008, 0x10208, 0x09208,
+        0x02208, 0x08408, 0x01408, 0x00608, 0x10008, 0x09008,
+        0x02008, 0x08208, 0x01208, 0x00408, 0x08008, 0x01008,
+        0x00208, 0x00008, 0x20000, 0x19000, 0x12000, 0x0b000,
+        0x04000, 0x18200, 0x11200, 0x0a200, 0x03200, 0x10400,
+        0x09400, 0x02400, 0x08600, 0x01600, 0x00800, 0x18000,
+        0x11000, 0x0a000, 0x03000, 0x10200, 0x09200, 0x02200,
+        0x08400, 0x01400, 0x00600, 0x10010, 0x09010, 0x02010,
+        0x08210, 0x01210, 0x00410, 0x08010, 0x01010, 0x00210,
+        0x00010, 0x18000, 0x11000, 0x0a000, 0x03000, 0x10200,
+        0x09200, 0x02200, 0x08400, 0x01400, 0x00600, 0x10040,
+        0x09040, 0x02040, 0x08240, 0x01240, 0x00440, 0x08000,
+        0x01000, 0x00200, 0x00000, 0x10000, 0x09000, 0x02000,
+        0x08200, 0x01200, 0x00400, 0x08040, 0x01040, 0x00240,
+        0x00080, 0x08000, 0x01000, 0x00200, 0x00040, 0x00000,
+        0x28001, 0x21001, 0x1a001, 0x13001, 0x0c001, 0x05001,
+        0x20201, 0x19201, 0x12201, 0x0b201, 0x04201, 0x18401,
+        0x11401, 0x0a401, 0x03401, 0x10601, 0x09601, 0x02601,
+        0x08801, 0x01801, 0x00a01, 0x20001, 0x19001, 0x12001,
+        0x0b001, 0x04001, 0x18201, 0x11201, 0x0a201, 0x03201,
+        0x10401, 0x09401, 0x02401, 0x08601, 0x01601, 0x00801,
+        0x18001, 0x11001, 0x0a001, 0x03001, 0x10201, 0x09201,
+        0x02201, 0x08401, 0x01401, 0x00601, 0x10001, 0x09001,
+        0x02001, 0x08201, 0x01201, 0x00401, 0x08001, 0x01001,
+        0x00201, 0x00001, 0x20001, 0x19001, 0x12001, 0x0b001,
+        0x04001, 0x18201, 0x11201, 0x0a201, 0x03201, 0x10401,
+        0x09401, 0x02401, 0x08601, 0x01601, 0x00801, 0x18009,
+        0x11009, 0x0a009, 0x03009, 0x10209, 0x09209, 0x02209,
+        0x08409, 0x01409, 0x00609, 0x10009, 0x09009, 0x02009,
+        0x08209, 0x01209, 0x00409, 0x08009, 0x01009, 0x00209,
+        0x00009, 0x18001, 0x11001, 0x0a001, 0x03001, 0x10201,
+        0x09201, 0x02201, 0x08401, 0x01401, 0x00601, 0x10001,
+        0x09001, 0x02001, 0x08201, 0x01201, 0x00401, 0x08011,
+        0x01011, 0x00211, 0x00011, 0x10001, 0x09001, 0x02001,
+        0x08201, 0x01201, 0x00401, 0x08041, 0x01041, 0x00241,
+        0x00001, 0x08001, 0x01001, 0x00201, 0x00041, 0x00001,
+        0x20000, 0x19000, 0x12000, 0x0b000, 0x04000, 0x18200,
+        0x11200, 0x0a200, 0x03200, 0x10400, 0x09400, 0x02400,
+        0x08600, 0x01600, 0x00800, 0x18002, 0x11002, 0x0a002,
+        0x03002, 0x10202, 0x09202, 0x02202, 0x08402, 0x01402,
+        0x00602, 0x10002, 0x09002, 0x02002, 0x08202, 0x01202,
+        0x00402, 0x08002, 0x01002, 0x00202, 0x00002, 0x18002,
+        0x11002, 0x0a002, 0x03002, 0x10202, 0x09202, 0x02202,
+        0x08402, 0x01402, 0x00602, 0x1000a, 0x0900a, 0x0200a,
+        0x0820a, 0x0120a, 0x0040a, 0x0800a, 0x0100a, 0x0020a,
+        0x0000a, 0x10002, 0x09002, 0x02002, 0x08202, 0x01202,
+        0x00402, 0x08002, 0x01002, 0x00202, 0x00012, 0x08002,
+        0x01002, 0x00202, 0x00042, 0x00002, 0x18000, 0x11000,
+        0x0a000, 0x03000, 0x10200, 0x09200, 0x02200, 0x08400,
+        0x01400, 0x00600, 0x10003, 0x09003, 0x02003, 0x08203,
+        0x01203, 0x00403, 0x08003, 0x01003, 0x00203, 0x00003,
+        0x10008, 0x09008, 0x02008, 0x08208, 0x01208, 0x00408,
+        0x0800b, 0x0100b, 0x0020b, 0x0000b, 0x08003, 0x01003,
+        0x00203, 0x00003, 0x00003, 0x10000, 0x09000, 0x02000,
+        0x08200, 0x01200, 0x00400, 0x08040, 0x01040, 0x00240,
+        0x00004, 0x08008, 0x01008, 0x00208, 0x00048, 0x00010,
+        0x08000, 0x01000, 0x00200, 0x00040, 0x00008, 0x00000,
+    },
+    {
+        0x30000, 0x28000, 0x20000, 0x18000, 0x00000, 0x00000,
+        0x00000, 0x28200, 0x20200, 0x18000, 0x00000, 0x08000,
+        0x00000, 0x20400, 0x18000, 0x00000, 0x00000, 0x00000,
+        0x18600, 0x00000, 0x00000, 0x00000, 0x10800, 0x00000,
+        0x00000, 0x00000, 0x00000, 0x00000, 0x28000, 0x21000,
+        0x1a000, 0x13000, 0x00040, 0x00040, 0x20200, 0x19200,
+        0x12200, 0x00040, 0x00040, 0x18400, 0x11400, 0x0a400,
+        0x00040, 0x10600, 0x09600, 0x00040, 0x08800, 0x01800,
+        0x00a00, 0x20000, 0x19000, 0x12000, 0x0b000, 0x04000,
+        0x18200, 0x11200, 0x0a200, 0x03200, 0x10400, 0x09400,
+        0x02400, 0x08600, 0x01600, 0x00800, 0x18000, 0x10000,
+        0x08000, 0x00000, 0x10200, 0x08200, 0x00200, 0x08400,
+        0x00400, 0x00600, 0x10000, 0x08000, 0x00000, 0x08200,
+        0x00200, 0x00400, 0x08000, 0x00000, 0x00200, 0x00000,
+        0x28000, 0x21000, 0x18008, 0x10008, 0x00008, 0x00008,
+        0x20200, 0x19200, 0x10008, 0x00008, 0x00008, 0x18400,
+        0x11400, 0x00008, 0x00008, 0x10600, 0x08008, 0x00008,
+        0x08800, 0x00008, 0x00008, 0x20008, 0x19008, 0x12008,
+        0x0b008, 0x00048, 0x18208, 0x11208, 0x0a208, 0x00048,
+        0x10408, 0x09408, 0x02408, 0x08608, 0x01608, 0x00808,
+        0x18008, 0x11008, 0x0a008, 0x03008, 0x10208, 0x09208,
+        0x02208, 0x08408, 0x01408, 0x00608, 0x10008, 0x08008,
+        0x00008, 0x08208, 0x00208, 0x00408, 0x08008, 0x00008,
+        0x00208, 0x00008, 0x20000, 0x19000, 0x12000, 0x0b000,
+        0x04000, 0x18200, 0x11200, 0x0a200, 0x03200, 0x10400,
+        0x09400, 0x02400, 0x08600, 0x01600, 0x00800, 0x18040,
+        0x11040, 0x0a040, 0x03040, 0x10240, 0x09240, 0x02240,
+        0x08440, 0x01440, 0x00640, 0x10010, 0x09010, 0x02010,
+        0x08210, 0x01210, 0x00410, 0x08010, 0x00010, 0x00210,
+        0x00010, 0x18000, 0x10000, 0x08000, 0x00000, 0x10200,
+        0x08200, 0x00200, 0x08400, 0x00400, 0x00600, 0x10040,
+        0x08040, 0x00040, 0x08240, 0x00240, 0x00440, 0x08080,
+        0x00080, 0x00280, 0x00000, 0x10000, 0x08000, 0x00000,
+        0x08200, 0x00200, 0x00400, 0x08040, 0x00040, 0x00240,
+        0x00080, 0x08000, 0x00000, 0x00200, 0x00040, 0x00000,
+        0x28001, 0x20001, 0x18001, 0x10001, 0x00001, 0x00001,
+        0x20201, 0x18201, 0x10001, 0x00001, 0x00001, 0x18401,
+        0x10001, 0x00001, 0x00001, 0x10601, 0x08001, 0x00001,
+        0x08801, 0x00001, 0x00001, 0x20001, 0x19001, 0x12001,
+        0x0b001, 0x00041, 0x18201, 0x11201, 0x0a201, 0x00041,
+        0x10401, 0x09401, 0x02401, 0x08601, 0x01601, 0x00801,
+        0x18001, 0x11001, 0x0a001, 0x03001, 0x10201, 0x09201,
+        0x02201, 0x08401, 0x01401, 0x00601, 0x10001, 0x08001,
+        0x00001, 0x08201, 0x00201, 0x00401, 0x08001, 0x00001,
+        0x00201, 0x00001, 0x20001, 0x19001, 0x10009, 0x08009,
+        0x00009, 0x18201, 0x11201, 0x08009, 0x00009, 0x10401,
+        0x09401, 0x00009, 0x08601, 0x00009, 0x00801, 0x18009,
+        0x11009, 0x0a009, 0x03009, 0x10209, 0x09209, 0x02209,
+        0x08409, 0x01409, 0x00609, 0x10009, 0x09009, 0x02009,
+        0x08209, 0x01209, 0x00409, 0x08009, 0x00009, 0x00209,
+        0x00009, 0x18001, 0x11001, 0x0a001, 0x03001, 0x10201,
+        0x09201, 0x02201, 0x08401, 0x01401, 0x00601, 0x10041,
+        0x09041, 0x02041, 0x08241, 0x01241, 0x00441, 0x08011,
+        0x01011, 0x00211, 0x00011, 0x10001, 0x08001, 0x00001,
+        0x08201, 0x00201, 0x00401, 0x08041, 0x00041, 0x00241,
+        0x00081, 0x08001, 0x00001, 0x00201, 0x00041, 0x00001,
+        0x20000, 0x19000, 0x12000, 0x08002, 0x00002, 0x18200,
+        0x11200, 0x0a200, 0x00002, 0x10400, 0x09400, 0x00002,
+        0x08600, 0x01600, 0x00800, 0x18002, 0x11002, 0x0a002,
+        0x03002, 0x10202, 0x09202, 0x02202, 0x08402, 0x01402,
+        0x00602, 0x10002, 0x09002, 0x02002, 0x08202, 0x01202,
+        0x00402, 0x08002, 0x00002, 0x00202, 0x00002, 0x18008,
+        0x11008, 0x0a008, 0x0000a, 0x10208, 0x09208, 0x02208,
+        0x08408, 0x01408, 0x00608, 0x1000a, 0x0900a, 0x0200a,
+        0x0820a, 0x0120a, 0x0040a, 0x0800a, 0x0100a, 0x0020a,
+        0x0000a, 0x10002, 0x09002, 0x02002, 0x08202, 0x01202,
+        0x00402, 0x08042, 0x01042, 0x00242, 0x00012, 0x08002,
+        0x00002, 0x00202, 0x00042, 0x00002, 0x18000, 0x10000,
+        0x08000, 0x00000, 0x10200, 0x08200, 0x00200, 0x08400,
+        0x00400, 0x00600, 0x10040, 0x08040, 0x00040, 0x08240,
+        0x00240, 0x00440, 0x08003, 0x01003, 0x00203, 0x00000,
+        0x10008, 0x08008, 0x00008, 0x08208, 0x00208, 0x00408,
+        0x08048, 0x00048, 0x00248, 0x0000b, 0x08010, 0x00010,
+        0x00210, 0x00050, 0x00000, 0x10000, 0x08000, 0x00000,
+        0x08200, 0x00200, 0x00400, 0x08040, 0x00040, 0x00240,
+        0x00080, 0x08008, 0x00008, 0x00208, 0x00048, 0x00010,
+        0x08000, 0x00000, 0x00200, 0x00040, 0x00008, 0x00000,
+    },
+};
@@ -0,0 +1,376 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#include "shared.h"
+#include "policy.h"
+
+/* Argument information for the policy generator */
+#define POLICYGEN_ARGS 4
+#define POINTS_WEIGHT_ARGUMENT_INDEX 1
+#define HEARTS_WEIGHT_ARGUMENT_INDEX 2
+#define ATTACKS_WEIGHT_ARGUMENT_INDEX 3
+
+/* Every set of up to DICE_SET_SIZE dice is keyed by its counts in base 7 */
+#define KEY_BASE (DICE_SET_SIZE + 1)
+#define NUMBER_OF_KEYS 117649
+#define MAX_DICE_SETS 924
+#define MAX_THREADS 64
+#define TABLE_ENTRIES_PER_LINE 6
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, the table was written
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - INVALID_WEIGHT, a weight is not a number
+*   - THREAD_FAILURE, a worker thread could not be started
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    INVALID_WEIGHT = 2,
+    THREAD_FAILURE = 3
+} ExitCodes;
+
+/**
+* A struct for a set of up to DICE_SET_SIZE dice.
+*   - counts, the number of each face
+*   - size, the number of dice
+*   - key, the counts in base KEY_BASE
+*   - probability, the chance of rolling exactly this set with size dice
+*/
+typedef struct {
+    int counts[NUMBER_OF_FACES];
+    int size;
+    int key;
+    double probability;
+} DiceCounts;
+
+/**
+* A struct for the state of the dynamic program.
+*   - pointsWeight, heartsWeight, attacksWeight, the utility of a point, a
+*       heart and an attack
+*   - sets, every set of up to DICE_SET_SIZE dice
+*   - numberOfSets, the number of sets
+*   - value, the expected utility of holding a full set with the rolls
+*       remaining in the stage being solved, indexed by key
+*   - keepValue, the expected utility of keeping a set and rolling the rest,
+*       indexed by key
+*   - policy, the dice rerolled for each stage and full set rank
+*/
+typedef struct {
+    double pointsWeight;
+    double heartsWeight;
+    double attacksWeight;
+    DiceCounts sets[MAX_DICE_SETS];
+    int numberOfSets;
+    double value[NUMBER_OF_KEYS];
+    double keepValue[NUMBER_OF_KEYS];
+    unsigned int policy[POLICY_STAGES][POLICY_DICE_SETS];
+} Solver;
+
+/**
+* A struct for the range of work given to a worker thread.
+*   - solver, the shared solver state
+*   - first, the first index
+*   - last, one past the last index
+*   - stage, the policy stage being solved
+*/
+typedef struct {
+    Solver* solver;
+    int first;
+    int last;
+    int stage;
+} Work;
+
+/**
+* Exits the program, with the specified exit status and a message.
+*   - exitStatus, the status to exit with
+*/
+void exit_program(ExitCodes exitStatus) {
+    char* errorString = "";
+    switch (exitStatus) {
+        case SUCCESS:
+            errorString = "";
+            break;
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-policygen pointsweight "
+                    "heartsweight attacksweight\n";
+            break;
+        case INVALID_WEIGHT:
+            errorString = "Invalid weight\n";
+            break;
+        case THREAD_FAILURE:
+            errorString = "Unable to start thread\n";
+            break;
+    }
+    fprintf(stderr, "%s", errorString);
+    exit((int)exitStatus);
+}
+
+/**
+* Returns the key of the specified face counts.
+*   - counts, the number of each face
+*/
+int dice_key(const int* counts) {
+    int key = 0;
+    for (int face = NUMBER_OF_FACES - 1; face >= 0; face--) {
+        key = key * KEY_BASE + counts[face];
+    }
+    return key;
+}
+
+/**
+* Adds every set of up to DICE_SET_SIZE dice to the solver, with the chance
+* of rolling it.
+*   - solver, the solver
+*   - counts, the counts chosen for the faces before face
+*   - face, the face to choose the count of
+*   - size, the number of dice chosen so far
+*/
+void enumerate_sets(Solver* solver, int* counts, int face, int size) {
+    if (face == NUMBER_OF_FACES) {
+        DiceCounts* set = &solver->sets[solver->numberOfSets++];
+        memcpy(set->counts, counts, sizeof(set->counts));
+        set->size = size;
+        set->key = dice_key(counts);
+        /* size! / (counts[0]! ... counts[5]!) / 6^size */
+        set->probability = 1.0;
+        int die = 0;
+        for (int f = 0; f < NUMBER_OF_FACES; f++) {
+            for (int i = 1; i <= counts[f]; i++) {
+                die++;
+                set->probability *= (double)die / i / NUMBER_OF_FACES;
+            }
+        }
+        return;
+    }
+    for (int count = 0; size + count <= DICE_SET_SIZE; count++) {
+        counts[face] = count;
+        enumerate_sets(solver, counts, face + 1, size + count);
+    }
+    counts[face] = 0;
+}
+
+/**
+* Returns the utility of finishing a turn with the specified full set,
+* counting each token as a tenth of a point.
+*   - solver, the solver
+*   - counts, the number of each face
+*/
+double turn_utility(Solver* solver, const int* counts) {
+    double points = (double)counts[FACE_P] / TOKENS_POINTS_THRESHOLD;
+    if (counts[FACE_ONE] > DICE_POINTS_THRESHOLD) {
+        points += counts[FACE_ONE] - ONES_DICE_POINT_PENALTY;
+    }
+    if (counts[FACE_TWO] > DICE_POINTS_THRESHOLD) {
+        points += counts[FACE_TWO] - TWOS_DICE_POINT_PENALTY;
+    }
+    if (counts[FACE_THREE] > DICE_POINTS_THRESHOLD) {
+        points += counts[FACE_THREE] - THREES_DICE_POINT_PENALTY;
+    }
+    return solver->pointsWeight * points +
+            solver->heartsWeight * counts[FACE_H] +
+            solver->attacksWeight * counts[FACE_A];
+}
+
+/**
+* Worker thread that computes keepValue for its range of sets: the expected
+* value of keeping the set and rolling the remaining dice.
+*   - argument, the Work range
+*/
+void* solve_keep_values(void* argument) {
+    Work* work = argument;
+    Solver* solver = work->solver;
+    for (int i = work->first; i < work->last; i++) {
+        DiceCounts* kept = &solver->sets[i];
+        int rolled = DICE_SET_SIZE - kept->size;
+        double expected = 0.0;
+        for (int j = 0; j < solver->numberOfSets; j++) {
+            DiceCounts* roll = &solver->sets[j];
+            if (roll->size != rolled) {
+                continue;
+            }
+            expected += roll->probability *
+                    solver->value[kept->key + roll->key];
+        }
+        solver->keepValue[kept->key] = expected;
+    }
+    return NULL;
+}
+
+/**
+* Returns the best value of keeping some of the dice in a full set, setting
+* best to the counts kept. Ties keep the most dice.
+*   - solver, the solver
+*   - counts, the full set
+*   - kept, the counts being considered, built up face by face
+*   - face, the face to choose the count of
+*   - best, set to the best counts kept
+*/
+double best_keep(Solver* solver, const int* counts, int* kept, int face,
+        int* best) {
+    if (face == NUMBER_OF_FACES) {
+        memcpy(best, kept, sizeof(int) * NUMBER_OF_FACES);
+        return solver->keepValue[dice_key(kept)];
+    }
+    double bestValue = -HUGE_VAL;
+    int candidate[NUMBER_OF_FACES];
+    for (int count = counts[face]; count >= 0; count--) {
+        kept[face] = count;
+        double value = best_keep(solver, counts, kept, face + 1, candidate);
+        if (value > bestValue) {
+            bestValue = value;
+            memcpy(best, candidate, sizeof(int) * NUMBER_OF_FACES);
+        }
+    }
+    return bestValue;
+}
+
+/**
+* Worker thread that chooses the best dice to keep for its range of full set
+* ranks, recording the dice to reroll in the policy and the value of holding
+* the set in the next stage back.
+*   - argument, the Work range
+*/
+void* solve_policy(void* argument) {
+    Work* work = argument;
+    Solver* solver = work->solver;
+    for (int rank = work->first; rank < work->last; rank++) {
+        int counts[NUMBER_OF_FACES];
+        int kept[NUMBER_OF_FACES];
+        int best[NUMBER_OF_FACES];
+        int rerolled[NUMBER_OF_FACES];
+        unrank_dice_counts(rank, counts);
+        solver->value[dice_key(counts)] = best_keep(solver, counts, kept, 0,
+                best);
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            rerolled[face] = counts[face] - best[face];
+        }
+        solver->policy[work->stage][rank] = pack_dice_counts(rerolled);
+    }
+    return NULL;
+}
+
+/**
+* Runs the worker on all available cores, splitting the range [0, count)
+* between them.
+*   - solver, the solver
+*   - worker, the worker thread function
+*   - count, the size of the range
+*   - stage, the policy stage being solved
+*/
+void run_workers(Solver* solver, void* (*worker)(void*), int count,
+        int stage) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int numberOfThreads = (cores < 1) ? 1 :
+            (cores > MAX_THREADS) ? MAX_THREADS : (int)cores;
+    pthread_t threads[MAX_THREADS];
+    Work work[MAX_THREADS];
+    for (int i = 0; i < numberOfThreads; i++) {
+        work[i].solver = solver;
+        work[i].first = count * i / numberOfThreads;
+        work[i].last = count * (i + 1) / numberOfThreads;
+        work[i].stage = stage;
+        if (pthread_create(&threads[i], NULL, worker, &work[i]) != 0) {
+            exit_program(THREAD_FAILURE);
+        }
+    }
+    for (int i = 0; i < numberOfThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+/**
+* Solves the policy backwards from the last roll of the turn, returning the
+* expected utility of a turn played by the policy.
+*   - solver, the solver
+*/
+double solve(Solver* solver) {
+    for (int i = 0; i < solver->numberOfSets; i++) {
+        DiceCounts* set = &solver->sets[i];
+        if (set->size == DICE_SET_SIZE) {
+            solver->value[set->key] = turn_utility(solver, set->counts);
+        }
+    }
+    for (int stage = POLICY_STAGES - 1; stage >= 0; stage--) {
+        run_workers(solver, solve_keep_values, solver->numberOfSets, stage);
+        run_workers(solver, solve_policy, POLICY_DICE_SETS, stage);
+    }
+    double expected = 0.0;
+    for (int i = 0; i < solver->numberOfSets; i++) {
+        DiceCounts* set = &solver->sets[i];
+        if (set->size == DICE_SET_SIZE) {
+            expected += set->probability * solver->value[set->key];
+        }
+    }
+    return expected;
+}
+
+/**
+* Parses a weight argument, exiting if it is not a number.
+*   - argument, the argument to parse
+*/
+double parse_weight(char* argument) {
+    char* end;
+    double weight = strtod(argument, &end);
+    if (end == argument || *end != '\0') {
+        exit_program(INVALID_WEIGHT);
+    }
+    return weight;
+}
+
+/**
+* Writes the policy to stdout as C source defining rerollPolicy.
+*   - solver, the solved solver
+*   - expected, the expected utility of a turn
+*/
+void print_policy(Solver* solver, double expected) {
+    printf("/*\n* Reroll policy generated by stlucia-policygen %g %g %g. "
+            "Do not edit.\n* Expected turn utility %.6f.\n*/\n",
+            solver->pointsWeight, solver->heartsWeight,
+            solver->attacksWeight, expected);
+    printf("#include \"policy.h\"\n\n");
+    printf("const unsigned int rerollPolicy[POLICY_STAGES]"
+            "[POLICY_DICE_SETS] = {\n");
+    for (int stage = 0; stage < POLICY_STAGES; stage++) {
+        printf("    {\n");
+        for (int rank = 0; rank < POLICY_DICE_SETS; rank++) {
+            if (rank % TABLE_ENTRIES_PER_LINE == 0) {
+                printf("        ");
+            }
+            printf("0x%05x,", solver->policy[stage][rank]);
+            if (rank % TABLE_ENTRIES_PER_LINE ==
+                    TABLE_ENTRIES_PER_LINE - 1 ||
+                    rank == POLICY_DICE_SETS - 1) {
+                printf("\n");
+            } else {
+                printf(" ");
+            }
+        }
+        printf("    },\n");
+    }
+    printf("};\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc != POLICYGEN_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    Solver* solver = calloc(1, sizeof(Solver));
+    solver->pointsWeight = parse_weight(argv[POINTS_WEIGHT_ARGUMENT_INDEX]);
+    solver->heartsWeight = parse_weight(argv[HEARTS_WEIGHT_ARGUMENT_INDEX]);
+    solver->attacksWeight =
+            parse_weight(argv[ATTACKS_WEIGHT_ARGUMENT_INDEX]);
+
+    int counts[NUMBER_OF_FACES] = {0};
+    enumerate_sets(solver, counts, 0, 0);
+    double expected = solve(solver);
+    print_policy(solver, expected);
+    free(solver);
+    exit_program(SUCCESS);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "queue.h"
+
+/**
+* Sleeps until the queue's events counter changes from the value seen,
+* having set the specified waiting flag, unless the condition to wait for
+* has already cleared.
+*   - queue, the queue
+*   - waiting, the caller's waiting flag
+*   - seen, the events counter read before the caller checked the queue
+*/
+void wait_for_event(ByteQueue* queue, int* waiting, unsigned int seen) {
+    __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&queue->events, __ATOMIC_SEQ_CST) == seen) {
+        syscall(SYS_futex, &queue->events, FUTEX_WAIT_PRIVATE, seen, NULL,
+                NULL, 0);
+    }
+    __atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+}
+
+/**
+* Records progress on the queue, waking the other side if it is asleep.
+*   - queue, the queue
+*   - waiting, the other side's waiting flag
+*/
+void signal_event(ByteQueue* queue, int* waiting) {
+    __atomic_fetch_add(&queue->events, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, &queue->events, FUTEX_WAKE_PRIVATE, INT_MAX,
+                NULL, NULL, 0);
+    }
+}
+
+/**
+* Reads at least one byte from the queue, sleeping while it is empty, as
+* read() does on a pipe. Returns the number of bytes read, or 0 once the
+* queue is empty and closed.
+*   - cookie, the ByteQueue
+*   - buffer, the buffer to read into
+*   - size, the size of the buffer
+*/
+ssize_t queue_read(void* cookie, char* buffer, size_t size) {
+    ByteQueue* queue = cookie;
+    unsigned int head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    while (true) {
+        unsigned int seen = __atomic_load_n(&queue->events, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST) != head) {
+            break;
+        }
+        if (__atomic_load_n(&queue->closed, __ATOMIC_SEQ_CST)) {
+            return 0;
+        }
+        wait_for_event(queue, &queue->readerWaiting, seen);
+    }
+    unsigned int tail = __atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST);
+    size_t count = 0;
+    while (count < size && head != tail) {
+        buffer[count++] = queue->data[head++ % QUEUE_CAPACITY];
+    }
+    __atomic_store_n(&queue->head, head, __ATOMIC_SEQ_CST);
+    signal_event(queue, &queue->writerWaiting);
+    return (ssize_t)count;
+}
+
+/**
+* Writes every byte to the queue, sleeping while it is full. Returns the
+* number of bytes written, or -1 with errno EPIPE if the queue is closed, as
+* write() does on a pipe with SIGPIPE ignored.
+*   - cookie, the ByteQueue
+*   - buffer, the bytes to write
+*   - size, the number of bytes
+*/
+ssize_t queue_write(void* cookie, const char* buffer, size_t size) {
+    ByteQueue* queue = cookie;
+    unsigned int tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    size_t count = 0;
+    while (count < size) {
+        unsigned int seen = __atomic_load_n(&queue->events, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&queue->closed, __ATOMIC_SEQ_CST)) {
+            errno = EPIPE;
+            return -1;
+        }
+        unsigned int head = __atomic_load_n(&queue->head, __ATOMIC_SEQ_CST);
+        if (tail - head == QUEUE_CAPACITY) {
+            wait_for_event(queue, &queue->writerWaiting, seen);
+            continue;
+        }
+        while (count < size && tail - head < QUEUE_CAPACITY) {
+            queue->data[tail++ % QUEUE_CAPACITY] = buffer[count++];
+        }
+        __atomic_store_n(&queue->tail, tail, __ATOMIC_SEQ_CST);
+        signal_event(queue, &queue->readerWaiting);
+    }
+    return (ssize_t)count;
+}
+
+/**
+* Closes the queue, waking both sides so a sleeping reader sees the end of
+* the data and a sleeping writer fails.
+*   - cookie, the ByteQueue
+*/
+int queue_close(void* cookie) {
+    ByteQueue* queue = cookie;
+    __atomic_store_n(&queue->closed, 1, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&queue->events, 1, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &queue->events, FUTEX_WAKE_PRIVATE,
+            INT_MAX, NULL, NULL, 0);
+    return 0;
+}
+
+/**
+* Opens a stream on one end of the queue, so it can be used with the stdio
+* functions in place of a pipe.
+*   - queue, the queue
+*   - mode, "r" for the reading end or "w" for the writing end
+*/
+FILE* open_queue(ByteQueue* queue, const char* mode) {
+    cookie_io_functions_t functions = {
+        .read = queue_read,
+        .write = queue_write,
+        .seek = NULL,
+        .close = queue_close
+    };
+    return fopencookie(queue, mode, functions);
+}
@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include <sys/types.h>
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+/* The number of bytes a queue holds, a power of two */
+#define QUEUE_CAPACITY 4096
+
+/**
+* A struct for a single producer, single consumer byte queue between two
+* threads, standing in for a pipe. The positions only ever increase and are
+* reduced modulo QUEUE_CAPACITY to index the data. Both sides sleep on the
+* events counter, which changes whenever either side makes progress. A side
+* about to sleep sets its waiting flag, so the other side only makes a wake
+* up system call when someone is asleep. Every field but data is accessed
+* with the __atomic builtins.
+*   - head, the position of the next byte to read, advanced by the reader
+*   - tail, the position of the next byte to write, advanced by the writer
+*   - events, counts reads, writes and closes
+*   - readerWaiting, writerWaiting, whether each side is about to sleep
+*   - closed, set once either end is closed
+*   - data, the bytes in the queue
+*/
+typedef struct {
+    unsigned int head;
+    unsigned int tail;
+    unsigned int events;
+    int readerWaiting;
+    int writerWaiting;
+    int closed;
+    char data[QUEUE_CAPACITY];
+} ByteQueue;
+
+/* Function prototypes */
+ssize_t queue_read(void* cookie, char* buffer, size_t size);
+ssize_t queue_write(void* cookie, const char* buffer, size_t size);
+int queue_close(void* cookie);
+FILE* open_queue(ByteQueue* queue, const char* mode);
+#endif
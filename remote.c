@@ -0,0 +1,162 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "shared.h"
+#include "tournament.h"
+#include "remote.h"
+
+/* The number of players a listening socket holds before they are accepted */
+#define REMOTE_BACKLOG 8
+
+/**
+* Returns true if the faculty names a player that connects to the hub.
+*   - faculty, the faculty as given on the command line
+*/
+bool is_remote_faculty(const char* faculty) {
+    return strncmp(faculty, REMOTE_TCP_PREFIX,
+            strlen(REMOTE_TCP_PREFIX)) == 0 ||
+            strncmp(faculty, REMOTE_UNIX_PREFIX,
+            strlen(REMOTE_UNIX_PREFIX)) == 0;
+}
+
+/**
+* Fills in the address of a Unix socket. Returns false if the path is too
+* long.
+*   - path, the path of the socket
+*   - address, the address to fill in
+*/
+bool unix_address(const char* path, struct sockaddr_un* address) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        return false;
+    }
+    strcpy(address->sun_path, path);
+    return true;
+}
+
+/**
+* Returns a non-blocking socket listening for the players of a remote
+* faculty, "tcp:port" or "unix:path", or -1 if it cannot be opened. A stale
+* Unix socket left at the path is replaced.
+*   - faculty, the remote faculty
+*/
+int listen_for_players(const char* faculty) {
+    int listener;
+    if (strncmp(faculty, REMOTE_TCP_PREFIX, strlen(REMOTE_TCP_PREFIX)) == 0) {
+        listener = listen_on(faculty + strlen(REMOTE_TCP_PREFIX));
+    } else {
+        const char* path = faculty + strlen(REMOTE_UNIX_PREFIX);
+        struct sockaddr_un address;
+        struct stat existing;
+        if (!unix_address(path, &address)) {
+            return -1;
+        }
+        if (stat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+            unlink(path);
+        }
+        listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listener >= 0 && (bind(listener, (struct sockaddr*)&address,
+                sizeof(address)) != 0 ||
+                listen(listener, REMOTE_BACKLOG) != 0)) {
+            close(listener);
+            listener = -1;
+        }
+    }
+    if (listener >= 0) {
+        fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    }
+    return listener;
+}
+
+/**
+* Closes a listening socket once its players have connected, removing the
+* socket file of a Unix socket.
+*   - listener, the listening socket
+*   - faculty, the remote faculty it listens for
+*/
+void stop_listening(int listener, const char* faculty) {
+    close(listener);
+    if (strncmp(faculty, REMOTE_UNIX_PREFIX,
+            strlen(REMOTE_UNIX_PREFIX)) == 0) {
+        unlink(faculty + strlen(REMOTE_UNIX_PREFIX));
+    }
+}
+
+/**
+* Accepts a remote player for the specified seat and tells it its player
+* count and label, so it can start like a player the hub runs. Returns false
+* if no player is waiting.
+*   - listener, the listening socket
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - playerNumber, the seat of the player
+*/
+bool accept_remote_player(int listener, Game* game, Player** players,
+        int playerNumber) {
+    int connection = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+    if (connection < 0) {
+        return false;
+    }
+    int enable = 1;
+    setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &enable,
+            sizeof(enable));
+    int reading = dup(connection);
+    players[playerNumber]->pid = 0;
+    players[playerNumber]->inbox = fdopen(connection, "w");
+    players[playerNumber]->outbox = reading < 0 ? NULL :
+            fdopen(reading, "r");
+    if (players[playerNumber]->inbox == NULL ||
+            players[playerNumber]->outbox == NULL) {
+        return false;
+    }
+    setvbuf(players[playerNumber]->inbox, NULL, _IONBF, 0);
+    fprintf(players[playerNumber]->inbox, "%s %d %c\n", SEAT_MESSAGE,
+            game->numberOfPlayers, players[playerNumber]->playerToken);
+    fflush(players[playerNumber]->inbox);
+    return true;
+}
+
+/**
+* Returns a socket connected to a hub's remote faculty, "tcp:host:port" or
+* "unix:path", or -1 if the hub cannot be reached.
+*   - address, the address of the hub
+*/
+int connect_to_hub(const char* address) {
+    if (strncmp(address, REMOTE_TCP_PREFIX, strlen(REMOTE_TCP_PREFIX)) == 0) {
+        const char* host = address + strlen(REMOTE_TCP_PREFIX);
+        const char* port = strrchr(host, ':');
+        char hostName[TOURNAMENT_LINE_LENGTH];
+        if (port == NULL || port - host >= TOURNAMENT_LINE_LENGTH) {
+            return -1;
+        }
+        snprintf(hostName, TOURNAMENT_LINE_LENGTH, "%.*s", (int)(port - host),
+                host);
+        return connect_to(hostName, port + 1);
+    } else if (strncmp(address, REMOTE_UNIX_PREFIX,
+            strlen(REMOTE_UNIX_PREFIX)) == 0) {
+        struct sockaddr_un unixAddress;
+        if (!unix_address(address + strlen(REMOTE_UNIX_PREFIX),
+                &unixAddress)) {
+            return -1;
+        }
+        int connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connection >= 0 && connect(connection,
+                (struct sockaddr*)&unixAddress, sizeof(unixAddress)) != 0) {
+            close(connection);
+            connection = -1;
+        }
+        return connection;
+    }
+    return -1;
+}
@@ -0,0 +1,28 @@
+#include <stdbool.h>
+#include "shared.h"
+
+#ifndef REMOTE_H
+#define REMOTE_H
+
+/* A faculty starting with one of these is a player that connects to the
+hub, "tcp:port" or "unix:path", rather than a program the hub runs */
+#define REMOTE_TCP_PREFIX "tcp:"
+#define REMOTE_UNIX_PREFIX "unix:"
+
+/* The first line sent to a remote player, its player count and label */
+#define SEAT_MESSAGE "seat"
+
+/* Remote players must connect within this many seconds, overridden by
+this variable up to a maximum */
+#define CONNECT_SECONDS_VARIABLE "STLUCIA_CONNECT_SECONDS"
+#define DEFAULT_CONNECT_SECONDS 60
+#define MAX_CONNECT_SECONDS 86400
+
+/* Function prototypes */
+bool is_remote_faculty(const char* faculty);
+int listen_for_players(const char* faculty);
+void stop_listening(int listener, const char* faculty);
+bool accept_remote_player(int listener, Game* game, Player** players,
+        int playerNumber);
+int connect_to_hub(const char* address);
+#endif
@@ -0,0 +1,652 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shared.h"
+#include "policy.h"
+
+/* Argument information for the roll file analyser */
+#define ROLLSTAT_ARGS 2
+#define ROLLSTAT_ROLL_FILE_ARGUMENT_INDEX 1
+
+/* Threads default to one per core, overridden by this variable. Files
+smaller than a chunk each are not split further. */
+#define ROLLSTAT_THREADS_VARIABLE "STLUCIA_ROLLSTAT_THREADS"
+#define ROLLSTAT_THREADS 0
+#define MAX_ROLLSTAT_THREADS 256
+#define MIN_CHUNK_BYTES 1048576
+
+/* Bytes are classified a block at a time */
+#define STAT_BLOCK_BYTES 4096
+#define CLASS_NEWLINE 6
+#define CLASS_INVALID 7
+#define NUMBER_OF_CLASSES 256
+
+/* The shape of the statistics */
+#define BIGRAMS (NUMBER_OF_FACES * NUMBER_OF_FACES)
+#define TRIGRAMS (BIGRAMS * NUMBER_OF_FACES)
+#define MAX_RUN_LENGTH 32
+#define SEAM_DICE (DICE_SET_SIZE - 1)
+#define WINDOW_CODES 117649
+#define WINDOW_BASE 7
+
+/* Limits of the numerical method for the chi-square distribution */
+#define GAMMA_ITERATIONS 1000
+#define GAMMA_EPSILON 3.0e-14
+#define GAMMA_TINY 1.0e-300
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, the report was printed
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - OPEN_ERROR, unable to open the roll file for reading
+*   - INVALID_FILE, the roll file is empty or holds a character that is not
+*       a die or a newline, or is a packed roll file that is invalid
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    OPEN_ERROR = 2,
+    INVALID_FILE = 3
+} ExitCodes;
+
+/**
+* A struct for the statistics of one chunk of the roll file, counted by one
+* thread. N-grams, windows and runs crossing into the next chunk are counted
+* when the chunks are joined, from the dice at each end of the chunks.
+*   - start, the first byte of the chunk
+*   - length, the number of bytes in the chunk
+*   - invalid, whether the chunk holds a character that is not a die
+*   - newlines, the number of newlines
+*   - dice, the number of dice
+*   - faces, the number of each face
+*   - bigrams, trigrams, the number of each sequence of two and three dice
+*   - windows, the number of each set of six consecutive dice, by the
+*       index of the first die in the chunk modulo six
+*   - runs, the number of runs of each length, lengths from MAX_RUN_LENGTH
+*       counted together, not counting the first and last run
+*   - longestRun, the longest run counted in runs
+*   - head, the first dice
+*   - tail, the last dice
+*   - leadingFace, leadingRun, the face and length of the first run
+*   - trailingFace, trailingRun, the face and length of the last run
+*   - singleRun, whether the first run is also the last
+*/
+typedef struct {
+    const unsigned char* start;
+    size_t length;
+    bool invalid;
+    unsigned long long newlines;
+    unsigned long long dice;
+    unsigned long long faces[NUMBER_OF_FACES];
+    unsigned long long bigrams[BIGRAMS];
+    unsigned long long trigrams[TRIGRAMS];
+    unsigned long long windows[DICE_SET_SIZE][POLICY_DICE_SETS];
+    unsigned long long runs[MAX_RUN_LENGTH + 1];
+    unsigned long long longestRun;
+    unsigned char head[SEAM_DICE];
+    unsigned char tail[SEAM_DICE];
+    int leadingFace;
+    unsigned long long leadingRun;
+    int trailingFace;
+    unsigned long long trailingRun;
+    bool singleRun;
+} Chunk;
+
+/* The class of each byte: its DiceFace, CLASS_NEWLINE or CLASS_INVALID */
+unsigned char byteClasses[NUMBER_OF_CLASSES];
+
+/* The rank of each set of six dice, indexed by the sum of WINDOW_BASE to the
+power of each die's face */
+short windowRanks[WINDOW_CODES];
+
+/* WINDOW_BASE to the power of each face */
+const int facePowers[NUMBER_OF_FACES] = {1, 7, 49, 343, 2401, 16807};
+
+/**
+* Exits the program with the specified exit status. Prints the corresponding
+* error message to stderr.
+*   - exitStatus, the exit status
+*/
+void exit_program(ExitCodes exitStatus) {
+    const char* errorString;
+    switch (exitStatus) {
+        case SUCCESS:
+            exit(SUCCESS);
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-rollstat rollfile";
+            break;
+        case OPEN_ERROR:
+            errorString = "Unable to access rollfile";
+            break;
+        case INVALID_FILE:
+            errorString = "Error reading rolls";
+            break;
+    }
+    fprintf(stderr, "%s\n", errorString);
+    exit(exitStatus);
+}
+
+/**
+* Decodes a packed roll file to one character per die, to be counted as a
+* text roll file of a single line. Exits if it is invalid.
+*   - path, the packed roll file
+*   - length, set to the number of dice
+*/
+unsigned char* decode_packed_roll_file(char* path, size_t* length) {
+    char* dice;
+    int numberOfDice = read_roll_file(path, &dice);
+    if (numberOfDice < 0) {
+        exit_program(OPEN_ERROR);
+    } else if (numberOfDice == 0) {
+        exit_program(INVALID_FILE);
+    }
+    *length = numberOfDice;
+    return (unsigned char*)dice;
+}
+
+/**
+* Fills the byte classes and window ranks.
+*/
+void build_tables(void) {
+    for (int i = 0; i < NUMBER_OF_CLASSES; i++) {
+        int face = get_face_index((char)i);
+        byteClasses[i] = face >= 0 ? face : (i == '\n' ? CLASS_NEWLINE :
+                CLASS_INVALID);
+    }
+    for (int rank = 0; rank < POLICY_DICE_SETS; rank++) {
+        int counts[NUMBER_OF_FACES];
+        unrank_dice_counts(rank, counts);
+        int code = 0;
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            code += counts[face] * facePowers[face];
+        }
+        windowRanks[code] = (short)rank;
+    }
+}
+
+/**
+* Counts a run of dice.
+*   - runs, the run histogram
+*   - longestRun, the longest run so far
+*   - length, the length of the run
+*/
+void count_run(unsigned long long* runs, unsigned long long* longestRun,
+        unsigned long long length) {
+    runs[length < MAX_RUN_LENGTH ? length : MAX_RUN_LENGTH]++;
+    if (length > *longestRun) {
+        *longestRun = length;
+    }
+}
+
+/**
+* Counts the faces of a block of classified bytes, each face in its own
+* branch-free pass so the passes vectorise.
+*   - chunk, the chunk to count in
+*   - classes, the classes of the block's bytes
+*   - length, the number of bytes
+*/
+void count_block_faces(Chunk* chunk, const unsigned char* classes,
+        int length) {
+    for (int face = 0; face < NUMBER_OF_FACES; face++) {
+        unsigned int count = 0;
+        for (int i = 0; i < length; i++) {
+            count += classes[i] == face;
+        }
+        chunk->faces[face] += count;
+    }
+    unsigned int newlines = 0;
+    unsigned int invalid = 0;
+    for (int i = 0; i < length; i++) {
+        newlines += classes[i] == CLASS_NEWLINE;
+        invalid += classes[i] == CLASS_INVALID;
+    }
+    chunk->newlines += newlines;
+    chunk->invalid |= invalid != 0;
+}
+
+/**
+* Counts the statistics of a chunk of the roll file.
+*   - argument, the chunk
+*/
+void* count_chunk(void* argument) {
+    Chunk* chunk = argument;
+    unsigned char classes[STAT_BLOCK_BYTES];
+    unsigned char dice[STAT_BLOCK_BYTES];
+    unsigned char recent[DICE_SET_SIZE];
+    unsigned long long index = 0;
+    int previous = 0;
+    int beforePrevious = 0;
+    int code = 0;
+    int runFace = 0;
+    unsigned long long runLength = 0;
+    bool leadingCounted = false;
+    for (size_t offset = 0; offset < chunk->length;
+            offset += STAT_BLOCK_BYTES) {
+        int length = chunk->length - offset < STAT_BLOCK_BYTES ?
+                (int)(chunk->length - offset) : STAT_BLOCK_BYTES;
+        const unsigned char* bytes = chunk->start + offset;
+        int numberOfDice = 0;
+        for (int i = 0; i < length; i++) {
+            classes[i] = byteClasses[bytes[i]];
+            dice[numberOfDice] = classes[i];
+            numberOfDice += classes[i] < NUMBER_OF_FACES;
+        }
+        count_block_faces(chunk, classes, length);
+        for (int i = 0; i < numberOfDice; i++, index++) {
+            int die = dice[i];
+            if (index < SEAM_DICE) {
+                chunk->head[index] = die;
+            }
+            if (index >= 1) {
+                chunk->bigrams[previous * NUMBER_OF_FACES + die]++;
+            }
+            if (index >= 2) {
+                chunk->trigrams[(beforePrevious * NUMBER_OF_FACES +
+                        previous) * NUMBER_OF_FACES + die]++;
+            }
+            int slot = index % DICE_SET_SIZE;
+            code += facePowers[die];
+            if (index >= DICE_SET_SIZE) {
+                code -= facePowers[recent[slot]];
+            }
+            recent[slot] = die;
+            if (index >= DICE_SET_SIZE - 1) {
+                chunk->windows[(index + 1) % DICE_SET_SIZE][
+                        windowRanks[code]]++;
+            }
+            if (index > 0 && die == runFace) {
+                runLength++;
+            } else {
+                if (index > 0 && !leadingCounted) {
+                    chunk->leadingFace = runFace;
+                    chunk->leadingRun = runLength;
+                    leadingCounted = true;
+                } else if (index > 0) {
+                    count_run(chunk->runs, &chunk->longestRun, runLength);
+                }
+                runFace = die;
+                runLength = 1;
+            }
+            beforePrevious = previous;
+            previous = die;
+        }
+    }
+    chunk->dice = index;
+    chunk->singleRun = !leadingCounted;
+    if (chunk->singleRun) {
+        chunk->leadingFace = runFace;
+        chunk->leadingRun = runLength;
+    }
+    chunk->trailingFace = runFace;
+    chunk->trailingRun = runLength;
+    for (int i = 0; i < SEAM_DICE && i < (int)index; i++) {
+        chunk->tail[SEAM_DICE - 1 - i] = recent[(index - 1 - i) %
+                DICE_SET_SIZE];
+    }
+    return NULL;
+}
+
+/**
+* Adds one chunk's statistics to the totals, rotating its windows to their
+* alignment in the whole file.
+*   - total, the totals
+*   - chunk, the chunk, which starts at die total->dice
+*/
+void add_chunk(Chunk* total, const Chunk* chunk) {
+    int alignment = total->dice % DICE_SET_SIZE;
+    total->newlines += chunk->newlines;
+    total->dice += chunk->dice;
+    for (int face = 0; face < NUMBER_OF_FACES; face++) {
+        total->faces[face] += chunk->faces[face];
+    }
+    for (int i = 0; i < BIGRAMS; i++) {
+        total->bigrams[i] += chunk->bigrams[i];
+    }
+    for (int i = 0; i < TRIGRAMS; i++) {
+        total->trigrams[i] += chunk->trigrams[i];
+    }
+    for (int i = 0; i < DICE_SET_SIZE; i++) {
+        for (int rank = 0; rank < POLICY_DICE_SETS; rank++) {
+            total->windows[(i + alignment) % DICE_SET_SIZE][rank] +=
+                    chunk->windows[i][rank];
+        }
+    }
+    for (int length = 0; length <= MAX_RUN_LENGTH; length++) {
+        total->runs[length] += chunk->runs[length];
+    }
+    if (chunk->longestRun > total->longestRun) {
+        total->longestRun = chunk->longestRun;
+    }
+}
+
+/**
+* Counts the n-grams and windows crossing from one chunk into the next.
+*   - total, the totals, whose dice end where the next chunk starts
+*   - before, the chunk before the seam, with at least SEAM_DICE dice
+*   - after, the chunk after the seam, with at least SEAM_DICE dice
+*/
+void add_seam(Chunk* total, const Chunk* before, const Chunk* after) {
+    unsigned char seam[2 * SEAM_DICE];
+    memcpy(seam, before->tail, SEAM_DICE);
+    memcpy(seam + SEAM_DICE, after->head, SEAM_DICE);
+    total->bigrams[seam[SEAM_DICE - 1] * NUMBER_OF_FACES +
+            seam[SEAM_DICE]]++;
+    for (int start = SEAM_DICE - 2; start < SEAM_DICE; start++) {
+        total->trigrams[(seam[start] * NUMBER_OF_FACES + seam[start + 1]) *
+                NUMBER_OF_FACES + seam[start + 2]]++;
+    }
+    for (int start = 0; start < SEAM_DICE; start++) {
+        int code = 0;
+        for (int i = 0; i < DICE_SET_SIZE; i++) {
+            code += facePowers[seam[start + i]];
+        }
+        unsigned long long first = total->dice - SEAM_DICE + start;
+        total->windows[first % DICE_SET_SIZE][windowRanks[code]]++;
+    }
+}
+
+/**
+* Returns the regularized upper incomplete gamma function Q(a, x), by its
+* series below a + 1 and Lentz's continued fraction above.
+*   - a, x, its arguments
+*/
+double upper_gamma(double a, double x) {
+    if (x <= 0.0) {
+        return 1.0;
+    }
+    double front = exp(-x + a * log(x) - lgamma(a));
+    if (x < a + 1.0) {
+        double term = 1.0 / a;
+        double sum = term;
+        for (int n = 1; n < GAMMA_ITERATIONS; n++) {
+            term *= x / (a + n);
+            sum += term;
+            if (fabs(term) < fabs(sum) * GAMMA_EPSILON) {
+                break;
+            }
+        }
+        return 1.0 - sum * front;
+    }
+    double b = x + 1.0 - a;
+    double c = 1.0 / GAMMA_TINY;
+    double d = 1.0 / b;
+    double fraction = d;
+    for (int n = 1; n < GAMMA_ITERATIONS; n++) {
+        double numerator = -n * (n - a);
+        b += 2.0;
+        d = numerator * d + b;
+        d = 1.0 / (fabs(d) < GAMMA_TINY ? GAMMA_TINY : d);
+        c = b + numerator / c;
+        c = fabs(c) < GAMMA_TINY ? GAMMA_TINY : c;
+        fraction *= d * c;
+        if (fabs(d * c - 1.0) < GAMMA_EPSILON) {
+            break;
+        }
+    }
+    return fraction * front;
+}
+
+/**
+* Prints the chi-square statistic of observed counts against expected
+* probabilities, with its degrees of freedom and p-value, as JSON fields.
+*   - observed, the counts
+*   - probabilities, the expected probability of each count
+*   - categories, the number of counts
+*/
+void print_chi_square(const unsigned long long* observed,
+        const double* probabilities, int categories) {
+    unsigned long long total = 0;
+    for (int i = 0; i < categories; i++) {
+        total += observed[i];
+    }
+    double chiSquare = 0.0;
+    for (int i = 0; i < categories; i++) {
+        double expected = total * probabilities[i];
+        chiSquare += (observed[i] - expected) * (observed[i] - expected) /
+                expected;
+    }
+    printf("\"chi_square\": %.4f, \"degrees_of_freedom\": %d, "
+            "\"p_value\": %.6g", total == 0 ? 0.0 : chiSquare,
+            categories - 1, total == 0 ? 1.0 :
+            upper_gamma((categories - 1) / 2.0, chiSquare / 2.0));
+}
+
+/**
+* Prints counts keyed by the dice they are of, as a JSON object.
+*   - counts, the counts
+*   - dice, the number of dice in each key
+*   - categories, the number of counts
+*/
+void print_keyed_counts(const unsigned long long* counts, int dice,
+        int categories) {
+    printf("{");
+    for (int i = 0; i < categories; i++) {
+        char key[DICE_SET_SIZE + 1];
+        int value = i;
+        for (int j = dice - 1; j >= 0; j--) {
+            key[j] = get_face_character(value % NUMBER_OF_FACES);
+            value /= NUMBER_OF_FACES;
+        }
+        key[dice] = '\0';
+        printf("%s\"%s\": %llu", i == 0 ? "" : ", ", key, counts[i]);
+    }
+    printf("}");
+}
+
+/**
+* Prints the report of the whole file as JSON.
+*   - total, the statistics of the whole file
+*   - bytes, the size of the file
+*   - threads, the number of threads counting
+*/
+void print_report(const Chunk* total, size_t bytes, int threads) {
+    static double uniform[TRIGRAMS];
+    for (int i = 0; i < TRIGRAMS; i++) {
+        uniform[i] = 1.0 / TRIGRAMS;
+    }
+    printf("{\n  \"bytes\": %zu, \"dice\": %llu, \"newlines\": %llu, "
+            "\"threads\": %d,\n", bytes, total->dice, total->newlines,
+            threads);
+    printf("  \"faces\": {\"counts\": ");
+    print_keyed_counts(total->faces, 1, NUMBER_OF_FACES);
+    for (int i = 0; i < NUMBER_OF_FACES; i++) {
+        uniform[i] = 1.0 / NUMBER_OF_FACES;
+    }
+    printf(", ");
+    print_chi_square(total->faces, uniform, NUMBER_OF_FACES);
+    for (int i = 0; i < BIGRAMS; i++) {
+        uniform[i] = 1.0 / BIGRAMS;
+    }
+    printf("},\n  \"bigrams\": {\"counts\": ");
+    print_keyed_counts(total->bigrams, 2, BIGRAMS);
+    printf(", ");
+    print_chi_square(total->bigrams, uniform, BIGRAMS);
+    for (int i = 0; i < TRIGRAMS; i++) {
+        uniform[i] = 1.0 / TRIGRAMS;
+    }
+    printf("},\n  \"trigrams\": {\"counts\": ");
+    print_keyed_counts(total->trigrams, 3, TRIGRAMS);
+    printf(", ");
+    print_chi_square(total->trigrams, uniform, TRIGRAMS);
+    printf("},\n  \"runs\": {\"longest\": %llu, \"counts\": {",
+            total->longestRun);
+    for (int length = 1; length <= MAX_RUN_LENGTH; length++) {
+        printf("%s\"%d%s\": %llu", length == 1 ? "" : ", ", length,
+                length == MAX_RUN_LENGTH ? "+" : "", total->runs[length]);
+    }
+    printf("}},\n  \"dice_sets\": [\n");
+    static double setProbabilities[POLICY_DICE_SETS];
+    const int factorials[DICE_SET_SIZE + 1] = {1, 1, 2, 6, 24, 120, 720};
+    double outcomes = pow(NUMBER_OF_FACES, DICE_SET_SIZE);
+    for (int rank = 0; rank < POLICY_DICE_SETS; rank++) {
+        int counts[NUMBER_OF_FACES];
+        unrank_dice_counts(rank, counts);
+        double arrangements = factorials[DICE_SET_SIZE];
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            arrangements /= factorials[counts[face]];
+        }
+        setProbabilities[rank] = arrangements / outcomes;
+    }
+    for (int alignment = 0; alignment < DICE_SET_SIZE; alignment++) {
+        unsigned long long windows = 0;
+        int seen = 0;
+        for (int rank = 0; rank < POLICY_DICE_SETS; rank++) {
+            windows += total->windows[alignment][rank];
+            seen += total->windows[alignment][rank] > 0;
+        }
+        printf("    {\"alignment\": %d, \"windows\": %llu, \"distinct\": %d, ",
+                alignment, windows, seen);
+        print_chi_square(total->windows[alignment], setProbabilities,
+                POLICY_DICE_SETS);
+        printf("}%s\n", alignment == DICE_SET_SIZE - 1 ? "" : ",");
+    }
+    printf("  ]\n}\n");
+}
+
+/**
+* Joins the chunks in file order into the totals, counting the runs that
+* span chunks as they are joined.
+*   - chunks, the chunks, each with at least SEAM_DICE dice if there are
+*       several
+*   - numberOfChunks, the number of chunks
+*   - total, the zeroed totals
+*/
+void join_chunks(const Chunk* chunks, int numberOfChunks, Chunk* total) {
+    int runFace = chunks[0].leadingFace;
+    unsigned long long runLength = 0;
+    for (int i = 0; i < numberOfChunks; i++) {
+        const Chunk* chunk = &chunks[i];
+        if (i > 0) {
+            add_seam(total, &chunks[i - 1], chunk);
+        }
+        add_chunk(total, chunk);
+        if (chunk->dice == 0) {
+            continue;
+        }
+        if (runLength > 0 && chunk->leadingFace == runFace) {
+            runLength += chunk->leadingRun;
+        } else {
+            if (runLength > 0) {
+                count_run(total->runs, &total->longestRun, runLength);
+            }
+            runFace = chunk->leadingFace;
+            runLength = chunk->leadingRun;
+        }
+        if (!chunk->singleRun) {
+            count_run(total->runs, &total->longestRun, runLength);
+            runFace = chunk->trailingFace;
+            runLength = chunk->trailingRun;
+        }
+    }
+    if (runLength > 0) {
+        count_run(total->runs, &total->longestRun, runLength);
+    }
+}
+
+/**
+* Splits the file into chunks and counts them on their own threads. Returns
+* the number of chunks.
+*   - bytes, the file
+*   - length, the size of the file
+*   - threads, the number of chunks to split it into
+*   - chunks, the chunks, zeroed, MAX_ROLLSTAT_THREADS in size
+*/
+int count_chunks(const unsigned char* bytes, size_t length, int threads,
+        Chunk* chunks) {
+    pthread_t workers[MAX_ROLLSTAT_THREADS];
+    size_t chunkLength = length / threads;
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        chunks[i].start = bytes + i * chunkLength;
+        chunks[i].length = i == threads - 1 ? length - i * chunkLength :
+                chunkLength;
+        if (threads > 1 && pthread_create(&workers[i], NULL, count_chunk,
+                &chunks[i]) == 0) {
+            started++;
+        } else {
+            count_chunk(&chunks[i]);
+            workers[i] = 0;
+        }
+    }
+    for (int i = 0; i < threads && started > 0; i++) {
+        if (workers[i] != 0) {
+            pthread_join(workers[i], NULL);
+        }
+    }
+    return threads;
+}
+
+int main(int argc, char** argv) {
+    if (argc != ROLLSTAT_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    int fd = open(argv[ROLLSTAT_ROLL_FILE_ARGUMENT_INDEX], O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        exit_program(OPEN_ERROR);
+    }
+    size_t length = status.st_size;
+    if (length == 0) {
+        exit_program(INVALID_FILE);
+    }
+    size_t fileLength = length;
+    const unsigned char* bytes = mmap(NULL, length, PROT_READ, MAP_PRIVATE,
+            fd, 0);
+    if (bytes == MAP_FAILED) {
+        exit_program(OPEN_ERROR);
+    }
+    if (length >= PACKED_ROLL_HEADER_LENGTH && memcmp(bytes,
+            PACKED_ROLL_MAGIC, PACKED_ROLL_MAGIC_LENGTH) == 0) {
+        munmap((void*)bytes, length);
+        bytes = decode_packed_roll_file(
+                argv[ROLLSTAT_ROLL_FILE_ARGUMENT_INDEX], &length);
+    } else {
+        madvise((void*)bytes, length, MADV_SEQUENTIAL);
+    }
+    build_tables();
+
+    int threads = integer_setting(ROLLSTAT_THREADS_VARIABLE, ROLLSTAT_THREADS,
+            0, INT_MAX);
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if ((size_t)threads > length / MIN_CHUNK_BYTES) {
+        threads = (int)(length / MIN_CHUNK_BYTES);
+    }
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > MAX_ROLLSTAT_THREADS) {
+        threads = MAX_ROLLSTAT_THREADS;
+    }
+    static Chunk chunks[MAX_ROLLSTAT_THREADS];
+    int numberOfChunks = count_chunks(bytes, length, threads, chunks);
+    for (int i = 0; i < numberOfChunks; i++) {
+        if (chunks[i].dice < SEAM_DICE && numberOfChunks > 1) {
+            /* A chunk too short to join is all newlines; count it whole */
+            memset(chunks, 0, sizeof(Chunk) * numberOfChunks);
+            numberOfChunks = count_chunks(bytes, length, 1, chunks);
+            break;
+        }
+    }
+    static Chunk total;
+    for (int i = 0; i < numberOfChunks; i++) {
+        if (chunks[i].invalid) {
+            exit_program(INVALID_FILE);
+        }
+    }
+    join_chunks(chunks, numberOfChunks, &total);
+    if (total.dice == 0) {
+        exit_program(INVALID_FILE);
+    }
+    print_report(&total, fileLength, numberOfChunks);
+    exit_program(SUCCESS);
+    return 0;
+}
@@ -0,0 +1,398 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <pthread.h>
+#include "shared.h"
+#include "rollstream.h"
+
+/* The dice decoded ahead of the game in each of the two buffers, and the
+bytes read from the file at once */
+#define STREAM_BUFFER_DICE 65536
+#define STREAM_READ_BYTES 65536
+#define STREAM_BUFFERS 2
+
+/**
+* A struct for a buffer of decoded dice. A buffer never runs past the end of
+* the file, so the game learns where the file wraps at the end of a buffer.
+*   - dice, the decoded dice
+*   - length, the number of dice
+*   - endsFile, whether the last die is the last of the file
+*   - invalid, whether the file is invalid after these dice
+*   - ready, whether the reader has filled the buffer for the game
+*/
+typedef struct {
+    char dice[STREAM_BUFFER_DICE];
+    int length;
+    bool endsFile;
+    bool invalid;
+    bool ready;
+} StreamBuffer;
+
+/**
+* A struct for a roll file read by a helper thread into two buffers, one
+* filled while the game plays from the other.
+*   - fd, the roll file
+*   - packed, whether the file is packed
+*   - dataStart, the offset of the first die, after any header
+*   - packedDice, the number of dice in a packed file
+*   - packedBytes, the number of bytes of dice in a packed file
+*   - checksum, the checksum in a packed file's header
+*   - hash, the running checksum of the packed bytes read in this pass
+*   - bytesRead, the number of packed bytes read in this pass
+*   - firstPass, whether the reader has not reached the end of the file yet
+*   - diceRead, the number of dice read in this pass
+*   - bits, packed bits read but not decoded
+*   - bitCount, the number of bits in bits
+*   - raw, the bytes last read from the file
+*   - rawLength, the number of bytes in raw
+*   - rawOffset, the next byte of raw to decode
+*   - buffers, the decoded dice
+*   - playing, the buffer the game is playing from
+*   - offset, the next die of that buffer
+*   - reader, the helper thread
+*   - lock, guards the buffers' ready flags
+*   - changed, signalled when a buffer is filled or played
+*   - invalid, called when the game reaches an invalid part of the file
+*/
+typedef struct {
+    int fd;
+    bool packed;
+    off_t dataStart;
+    unsigned long long packedDice;
+    unsigned long long packedBytes;
+    unsigned long long checksum;
+    unsigned long long hash;
+    unsigned long long bytesRead;
+    bool firstPass;
+    unsigned long long diceRead;
+    unsigned int bits;
+    int bitCount;
+    unsigned char raw[STREAM_READ_BYTES];
+    int rawLength;
+    int rawOffset;
+    StreamBuffer buffers[STREAM_BUFFERS];
+    int playing;
+    int offset;
+    pthread_t reader;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    void (*invalid)(void);
+} RollStream;
+
+/**
+* Returns the next byte of the file without reading past it, or -1 at its
+* end or on an error.
+*   - stream, the stream
+*/
+int peek_byte(RollStream* stream) {
+    if (stream->rawOffset == stream->rawLength) {
+        ssize_t got;
+        do {
+            got = read(stream->fd, stream->raw, STREAM_READ_BYTES);
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0) {
+            return -1;
+        }
+        stream->rawLength = (int)got;
+        stream->rawOffset = 0;
+    }
+    return stream->raw[stream->rawOffset];
+}
+
+/**
+* Returns the next byte of the file, or -1 at its end or on an error.
+*   - stream, the stream
+*/
+int next_byte(RollStream* stream) {
+    int byte = peek_byte(stream);
+    if (byte >= 0) {
+        stream->rawOffset++;
+    }
+    return byte;
+}
+
+/**
+* Starts the next pass over the file from its first die.
+*   - stream, the stream
+*/
+void rewind_stream(RollStream* stream) {
+    lseek(stream->fd, stream->dataStart, SEEK_SET);
+    stream->rawLength = 0;
+    stream->rawOffset = 0;
+    stream->diceRead = 0;
+    stream->bytesRead = 0;
+    stream->hash = HASH_SEED;
+    stream->bits = 0;
+    stream->bitCount = 0;
+    stream->firstPass = false;
+}
+
+/**
+* Returns the DiceFace of the next die of a text file, -1 at its end or -2
+* at an invalid character.
+*   - stream, the stream
+*/
+int next_text_face(RollStream* stream) {
+    int character;
+    do {
+        character = next_byte(stream);
+    } while (character == '\n');
+    if (character < 0) {
+        return -1;
+    }
+    int face = get_face_index((char)character);
+    return face < 0 ? -2 : face;
+}
+
+/**
+* Returns the DiceFace of the next die of a packed file, -1 at its end or -2
+* if the file is truncated, holds a value that is not a face or, at the end
+* of the first pass, its checksum does not match.
+*   - stream, the stream
+*/
+int next_packed_face(RollStream* stream) {
+    if (stream->diceRead == stream->packedDice) {
+        while (stream->bytesRead < stream->packedBytes) {
+            int byte = next_byte(stream);
+            if (byte < 0) {
+                return -2;
+            }
+            unsigned char value = (unsigned char)byte;
+            stream->hash = hash_bytes(stream->hash, &value, 1);
+            stream->bytesRead++;
+        }
+        if (stream->firstPass && stream->hash != stream->checksum) {
+            return -2;
+        }
+        return -1;
+    }
+    if (stream->bitCount < BITS_PER_PACKED_DIE) {
+        int byte = next_byte(stream);
+        if (byte < 0) {
+            return -2;
+        }
+        unsigned char value = (unsigned char)byte;
+        stream->hash = hash_bytes(stream->hash, &value, 1);
+        stream->bytesRead++;
+        stream->bits |= value << stream->bitCount;
+        stream->bitCount += BITS_PER_BYTE;
+    }
+    int face = stream->bits & PACKED_DIE_MASK;
+    stream->bits >>= BITS_PER_PACKED_DIE;
+    stream->bitCount -= BITS_PER_PACKED_DIE;
+    return face < NUMBER_OF_FACES ? face : -2;
+}
+
+/**
+* Returns true if no dice are left in this pass over the file, reading no
+* further than the newlines before the next die.
+*   - stream, the stream
+*/
+bool no_dice_left(RollStream* stream) {
+    if (stream->packed) {
+        return stream->diceRead == stream->packedDice;
+    }
+    while (peek_byte(stream) == '\n') {
+        stream->rawOffset++;
+    }
+    return peek_byte(stream) < 0;
+}
+
+/**
+* Ends a buffer with the last die of the file, or marks the file invalid
+* after it if a packed file's trailing bits or checksum are wrong.
+*   - stream, the stream
+*   - buffer, the buffer
+*/
+void end_buffer(RollStream* stream, StreamBuffer* buffer) {
+    if (stream->packed && next_packed_face(stream) != -1) {
+        buffer->invalid = true;
+        return;
+    }
+    buffer->endsFile = true;
+    rewind_stream(stream);
+}
+
+/**
+* Fills a buffer with the next dice of the file, stopping at its end. A
+* file ending exactly at the end of a full buffer ends with that buffer, so
+* no buffer is ever empty.
+*   - stream, the stream
+*   - buffer, the buffer to fill
+*/
+void fill_buffer(RollStream* stream, StreamBuffer* buffer) {
+    buffer->length = 0;
+    buffer->endsFile = false;
+    buffer->invalid = false;
+    while (buffer->length < STREAM_BUFFER_DICE) {
+        int face = stream->packed ? next_packed_face(stream) :
+                next_text_face(stream);
+        if (face == -1 && stream->diceRead > 0) {
+            buffer->endsFile = true;
+            rewind_stream(stream);
+            return;
+        } else if (face < 0) {
+            buffer->invalid = true;
+            return;
+        }
+        buffer->dice[buffer->length++] = get_face_character(face);
+        stream->diceRead++;
+    }
+    if (no_dice_left(stream)) {
+        end_buffer(stream, buffer);
+    }
+}
+
+/**
+* Fills each buffer in turn once the game has played it, until the file
+* turns out to be invalid.
+*   - argument, the stream
+*/
+void* read_stream(void* argument) {
+    RollStream* stream = argument;
+    int filling = 0;
+    while (true) {
+        pthread_mutex_lock(&stream->lock);
+        while (stream->buffers[filling].ready) {
+            pthread_cond_wait(&stream->changed, &stream->lock);
+        }
+        pthread_mutex_unlock(&stream->lock);
+        fill_buffer(stream, &stream->buffers[filling]);
+        pthread_mutex_lock(&stream->lock);
+        stream->buffers[filling].ready = true;
+        pthread_cond_broadcast(&stream->changed);
+        pthread_mutex_unlock(&stream->lock);
+        if (stream->buffers[filling].invalid) {
+            return NULL;
+        }
+        filling = (filling + 1) % STREAM_BUFFERS;
+    }
+}
+
+/**
+* Waits for the reader to fill the buffer the game plays next.
+*   - stream, the stream
+*/
+void wait_for_buffer(RollStream* stream) {
+    pthread_mutex_lock(&stream->lock);
+    while (!stream->buffers[stream->playing].ready) {
+        pthread_cond_wait(&stream->changed, &stream->lock);
+    }
+    pthread_mutex_unlock(&stream->lock);
+}
+
+/**
+* Fills the roll file's window with the dice from its index, handing each
+* buffer back to the reader once it has been played. The size of the roll
+* file is learned from the window holding its last die, so from then on
+* get_next_die() wraps the index. Every window but the last of the file is
+* whole, so the stream's invalid function is called once fewer than a
+* window of dice are left before an invalid part of the file.
+*   - rollFile, the roll file
+*/
+void refill_streamed_window(RollFile* rollFile) {
+    RollStream* stream = rollFile->stream;
+    StreamBuffer* buffer = &stream->buffers[stream->playing];
+    while (stream->offset == buffer->length || (buffer->invalid &&
+            buffer->length - stream->offset < ROLL_WINDOW_SIZE)) {
+        if (buffer->invalid) {
+            stream->invalid();
+        }
+        pthread_mutex_lock(&stream->lock);
+        buffer->ready = false;
+        pthread_cond_broadcast(&stream->changed);
+        pthread_mutex_unlock(&stream->lock);
+        stream->playing = (stream->playing + 1) % STREAM_BUFFERS;
+        stream->offset = 0;
+        wait_for_buffer(stream);
+        buffer = &stream->buffers[stream->playing];
+    }
+    int count = buffer->length - stream->offset;
+    if (count > ROLL_WINDOW_SIZE) {
+        count = ROLL_WINDOW_SIZE;
+    }
+    memcpy(rollFile->window, buffer->dice + stream->offset, count);
+    stream->offset += count;
+    rollFile->windowStart = rollFile->index;
+    if (stream->offset == buffer->length && buffer->endsFile) {
+        rollFile->size = rollFile->index + count;
+    }
+}
+
+/**
+* Opens a roll file, text or packed, to be read by a helper thread as the
+* game plays, so the game starts without reading the whole file. The file's
+* size is unknown until the game first reaches its end. Returns 1 if the
+* file starts with a die, 0 if it is empty or invalid, or -1 if it cannot be
+* opened.
+*   - filePath, the file path of the roll file
+*   - rollFile, the roll file to stream into
+*   - invalid, called, and expected to exit, if the game reaches an invalid
+*       part of the file
+*/
+int open_roll_stream(char* filePath, RollFile* rollFile,
+        void (*invalid)(void)) {
+    int fd = open(filePath, O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    RollStream* stream = calloc(1, sizeof(RollStream));
+    stream->fd = fd;
+    stream->invalid = invalid;
+    unsigned char header[PACKED_ROLL_HEADER_LENGTH];
+    if (read(fd, header, PACKED_ROLL_HEADER_LENGTH) ==
+            PACKED_ROLL_HEADER_LENGTH && memcmp(header, PACKED_ROLL_MAGIC,
+            PACKED_ROLL_MAGIC_LENGTH) == 0) {
+        stream->packed = true;
+        stream->dataStart = PACKED_ROLL_HEADER_LENGTH;
+        stream->packedDice = load_packed_field(header + 
+                PACKED_ROLL_MAGIC_LENGTH);
+        stream->checksum = load_packed_field(header + 
+                PACKED_ROLL_MAGIC_LENGTH + PACKED_ROLL_FIELD_LENGTH);
+        stream->packedBytes = packed_roll_bytes(
+                stream->packedDice > INT_MAX ? INT_MAX :
+                (int)stream->packedDice);
+        /* The checksum is only known at the end of the first pass, but a
+        truncated or padded file is rejected before the game starts */
+        if (stream->packedDice == 0 ||
+                stream->packedDice > INT_MAX - ROLL_WINDOW_SIZE ||
+                (unsigned long long)status.st_size !=
+                PACKED_ROLL_HEADER_LENGTH + stream->packedBytes) {
+            close(fd);
+            free(stream);
+            return 0;
+        }
+    }
+    rewind_stream(stream);
+    stream->firstPass = true;
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->changed, NULL);
+    if (pthread_create(&stream->reader, NULL, read_stream, stream) != 0) {
+        close(fd);
+        free(stream);
+        return -1;
+    }
+    pthread_detach(stream->reader);
+    wait_for_buffer(stream);
+    if (stream->buffers[0].length == 0) {
+        return 0;
+    }
+    rollFile->stream = stream;
+    rollFile->refillWindow = refill_streamed_window;
+    rollFile->size = INT_MAX;
+    rollFile->index = 0;
+    rollFile->windowStart = -1;
+    return 1;
+}
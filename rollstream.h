@@ -0,0 +1,15 @@
+#include <stdbool.h>
+#include "shared.h"
+
+#ifndef ROLLSTREAM_H
+#define ROLLSTREAM_H
+
+/* Roll files at least this many bytes are streamed rather than read whole,
+overridden by this variable */
+#define STREAM_THRESHOLD_VARIABLE "STLUCIA_STREAM_THRESHOLD"
+#define DEFAULT_STREAM_THRESHOLD 1048576
+
+/* Function prototypes */
+int open_roll_stream(char* filePath, RollFile* rollFile,
+        void (*invalid)(void));
+#endif
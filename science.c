@@ -9,7 +9,8 @@
 */
 void reroll(Game* game, Player** players, RollFile* rollFile) {
     if (players[game->currentPlayerNumber]->health < 
-            REROLL_HEALTH_THRESHOLD) {
+            strategy_threshold("SCIENCE_REROLL_HEALTH_THRESHOLD",
+            REROLL_HEALTH_THRESHOLD)) {
         rollFile->rerollDice->numberOfAs = rollFile->latestDice->numberOfAs;
     } else {
         rollFile->rerollDice->numberOfHs = rollFile->latestDice->numberOfHs;
@@ -38,3 +39,18 @@ void reroll(Game* game, Player** players, RollFile* rollFile) {
 bool retreat(Game* game, Player** players) {
     return true;
 }
+
+/**
+* Writes the policy the hub can play for this player and returns true. Rows
+* are "123HAP" for low and high health, outside then inside St Lucia.
+*   - game, a struct of the game state
+*   - players, an array of players
+*   - policy, the policy message to write
+*/
+bool describe_policy(Game* game, Player** players, char* policy) {
+    sprintf(policy, "policy %02d 777077777707 777077777707 %02d",
+            policy_value(strategy_threshold("SCIENCE_REROLL_HEALTH_THRESHOLD",
+            REROLL_HEALTH_THRESHOLD), POLICY_MAX_THRESHOLD),
+            POLICY_MAX_THRESHOLD);
+    return true;
+}
@@ -3,17 +3,39 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include "shared.h"
 
+/* The trace file spans are written to, or -1 when tracing is off */
+int traceFile = -1;
+
+/* The character of each packed die value, in DiceFace order */
+const char packedDieCharacters[BITS_PER_BYTE] = {DICE_CHARACTER_1,
+        DICE_CHARACTER_2, DICE_CHARACTER_3, DICE_CHARACTER_4,
+        DICE_CHARACTER_5, DICE_CHARACTER_6, DICE_CHARACTER_1,
+        DICE_CHARACTER_1};
+
 /**
 * Initialises the game struct.
 *   - game, a struct of the game state
 */
 void initialise_game(Game* game) {
     game->playerInStLucia = EMPTY_STLUCIA; 
+    game->stateHash = zobrist_key(ZOBRIST_STLUCIA, 0, EMPTY_STLUCIA);
     game->numberOfRerolls = 0;
+    game->rollingPlayerNumber = 0;
 
     game->rollFile = malloc(sizeof(RollFile));
+    game->rollFile->packedRolls = NULL;
+    game->rollFile->windowStart = -1;
+    game->rollFile->refillWindow = NULL;
+    game->rollFile->stream = NULL;
 
     game->rollFile->latestDice = malloc(sizeof(DiceSet));
     game->rollFile->latestDice->rollString = 
@@ -68,7 +90,10 @@ void initialise_players(Game* game, Player** players) {
         players[i]->points = 0;
         players[i]->status = UNCONNECTED;
         players[i]->inbox = NULL;
+        players[i]->policy.rerolls = false;
+        players[i]->policy.retreats = false;
     }
+    game->stateHash = hash_game_state(game, players);
 }
 
 /**
@@ -89,11 +114,56 @@ char get_player_label(int playerNumber) {
 }
 
 /**
-* Returns the next die roll from the roll file.
+* Returns the DiceFace index of the specified die character, or -1 if it is 
+* not a valid die.
+*   - die, the die character
+*/
+int get_face_index(char die) {
+    switch (die) {
+        case DICE_CHARACTER_1:
+            return FACE_ONE;
+        case DICE_CHARACTER_2:
+            return FACE_TWO;
+        case DICE_CHARACTER_3:
+            return FACE_THREE;
+        case DICE_CHARACTER_4:
+            return FACE_H;
+        case DICE_CHARACTER_5:
+            return FACE_A;
+        case DICE_CHARACTER_6:
+            return FACE_P;
+    }
+    return -1;
+}
+
+/**
+* Returns the die character of the specified DiceFace index.
+*   - face, the DiceFace index
+*/
+char get_face_character(int face) {
+    return packedDieCharacters[face];
+}
+
+/**
+* Returns the next die roll from the roll file, wrapping to the first die
+* after the last.
 *   - rollFile, the roll file 
 */
 char get_next_die(RollFile* rollFile) {
-    char nextDie = rollFile->diceRolls[rollFile->index];
+    int offset = rollFile->index - rollFile->windowStart;
+    if (rollFile->windowStart < 0 || offset < 0 || 
+            offset >= ROLL_WINDOW_SIZE) {
+        if (rollFile->refillWindow != NULL) {
+            rollFile->refillWindow(rollFile);
+        } else {
+            rollFile->windowStart = rollFile->index - 
+                    rollFile->index % ROLL_WINDOW_SIZE;
+            decode_packed_dice(rollFile->packedRolls, rollFile->windowStart,
+                    ROLL_WINDOW_SIZE, rollFile->window);
+        }
+        offset = rollFile->index - rollFile->windowStart;
+    }
+    char nextDie = rollFile->window[offset];
     rollFile->index = (rollFile->index + 1) % rollFile->size;
     return nextDie;
 }
@@ -156,7 +226,7 @@ void remove_die_from_dice_set(DiceSet* diceSet, char die) {
 */
 void add_dice_to_dice_set(RollFile* rollFile, int numberOfDice, 
         DiceSet* diceSet) {
-    for (int i; i < numberOfDice; i++) {
+    for (int i = 0; i < numberOfDice; i++) {
         add_die_to_dice_set(diceSet, get_next_die(rollFile));
     }
 }
@@ -253,6 +323,9 @@ void heal(int player, Game* game, Player** players,
         } else {
             recover = healAmount;
         }
+        game->stateHash ^= zobrist_key(ZOBRIST_HEALTH, player, 
+                players[player]->health) ^ zobrist_key(ZOBRIST_HEALTH, player,
+                players[player]->health + recover);
         players[player]->health += recover;
     } else {
         return;
@@ -281,6 +354,9 @@ void damage_player(int player, int damage, Game* game, Player** players,
     } else {
         healthReduction = damage;
     }
+    game->stateHash ^= zobrist_key(ZOBRIST_HEALTH, player, 
+            players[player]->health) ^ zobrist_key(ZOBRIST_HEALTH, player,
+            players[player]->health - healthReduction);
     players[player]->health -= healthReduction;
 
     if (isHub) {
@@ -290,6 +366,96 @@ void damage_player(int player, int damage, Game* game, Player** players,
     }
 }
 
+/**
+* Returns the Zobrist key of a feature of the game state having the specified
+* value. Keys are computed rather than looked up, so values are unbounded.
+*   - feature, the feature
+*   - player, the player the feature belongs to
+*   - value, the value of the feature
+*/
+unsigned long long zobrist_key(ZobristFeature feature, int player, 
+        int value) {
+    unsigned long long key = ZOBRIST_SEED ^ 
+            ((unsigned long long)feature << ZOBRIST_FEATURE_SHIFT) ^
+            ((unsigned long long)player << ZOBRIST_PLAYER_SHIFT) ^
+            ((unsigned long long)value & ZOBRIST_VALUE_MASK);
+    key = (key ^ (key >> ZOBRIST_SHIFT_1)) * ZOBRIST_MIX_1;
+    key = (key ^ (key >> ZOBRIST_SHIFT_2)) * ZOBRIST_MIX_2;
+    return key ^ (key >> ZOBRIST_SHIFT_3);
+}
+
+/**
+* Returns the Zobrist hash of the game state from scratch. game->stateHash is
+* kept equal to this as the state changes.
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+unsigned long long hash_game_state(Game* game, Player** players) {
+    unsigned long long hash = zobrist_key(ZOBRIST_STLUCIA, 0, 
+            game->playerInStLucia);
+    for (int i = 0; i < game->numberOfPlayers; i++) {
+        hash ^= zobrist_key(ZOBRIST_HEALTH, i, players[i]->health) ^
+                zobrist_key(ZOBRIST_POINTS, i, players[i]->points) ^
+                zobrist_key(ZOBRIST_TOKENS, i, players[i]->tokens) ^
+                zobrist_key(ZOBRIST_STATUS, i, (int)players[i]->status);
+    }
+    return hash;
+}
+
+/**
+* Adds points to the specified player.
+*   - player, the player gaining points
+*   - points, the number of points
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+void add_points(int player, int points, Game* game, Player** players) {
+    game->stateHash ^= zobrist_key(ZOBRIST_POINTS, player, 
+            players[player]->points) ^ zobrist_key(ZOBRIST_POINTS, player,
+            players[player]->points + points);
+    players[player]->points += points;
+}
+
+/**
+* Sets the specified player's tokens.
+*   - player, the player
+*   - tokens, the player's new number of tokens
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+void set_tokens(int player, int tokens, Game* game, Player** players) {
+    game->stateHash ^= zobrist_key(ZOBRIST_TOKENS, player, 
+            players[player]->tokens) ^ zobrist_key(ZOBRIST_TOKENS, player,
+            tokens);
+    players[player]->tokens = tokens;
+}
+
+/**
+* Sets the specified player's status.
+*   - player, the player
+*   - status, the player's new status
+*   - game, a struct of the game state
+*   - players, an array of players
+*/
+void set_player_status(int player, PlayerStatus status, Game* game, 
+        Player** players) {
+    game->stateHash ^= zobrist_key(ZOBRIST_STATUS, player, 
+            (int)players[player]->status) ^ zobrist_key(ZOBRIST_STATUS, 
+            player, (int)status);
+    players[player]->status = status;
+}
+
+/**
+* Sets the player in St Lucia.
+*   - player, the player now in St Lucia, or EMPTY_STLUCIA
+*   - game, a struct of the game state
+*/
+void set_player_in_stlucia(int player, Game* game) {
+    game->stateHash ^= zobrist_key(ZOBRIST_STLUCIA, 0, 
+            game->playerInStLucia) ^ zobrist_key(ZOBRIST_STLUCIA, 0, player);
+    game->playerInStLucia = player;
+}
+
 /**
 * Returns the number of players not eliminated
 *   - game, a struct of the game state
@@ -322,6 +488,509 @@ bool invalid_roll(char* message) {
     return false;
 }
 
+/**
+* Returns the number of bytes holding the specified number of packed dice.
+* Packed dice are allocated for a whole number of windows, so the decoder can
+* always decode a whole window.
+*   - numberOfDice, the number of dice
+*/
+size_t packed_roll_bytes(int numberOfDice) {
+    return ((size_t)numberOfDice * BITS_PER_PACKED_DIE + BITS_PER_BYTE - 1) /
+            BITS_PER_BYTE;
+}
+
+/**
+* Allocates zeroed packed dice with room for the specified number of dice,
+* rounded up to a whole number of windows.
+*   - numberOfDice, the number of dice
+*/
+unsigned char* allocate_packed_rolls(int numberOfDice) {
+    int windows = numberOfDice / ROLL_WINDOW_SIZE + 1;
+    return calloc(packed_roll_bytes(windows * ROLL_WINDOW_SIZE), 1);
+}
+
+/**
+* Decodes packed dice to characters. Every 8 dice are 3 whole bytes, which
+* are loaded at once and split with shifts and a table lookup, with no 
+* branches, so the loop vectorises.
+*   - packedRolls, the packed dice, allocated by allocate_packed_rolls()
+*   - first, the index of the first die to decode, a multiple of 8
+*   - numberOfDice, the number of dice to decode, a multiple of 8
+*   - dice, where to store the characters
+*/
+void decode_packed_dice(const unsigned char* packedRolls, int first,
+        int numberOfDice, char* dice) {
+    const unsigned char* group = packedRolls + 
+            (size_t)first / BITS_PER_BYTE * BITS_PER_PACKED_DIE;
+    for (int i = 0; i < numberOfDice; i += BITS_PER_BYTE) {
+        unsigned int bits = group[0] | group[1] << BITS_PER_BYTE |
+                group[2] << (2 * BITS_PER_BYTE);
+        for (int die = 0; die < BITS_PER_BYTE; die++) {
+            dice[i + die] = packedDieCharacters[(bits >> 
+                    (die * BITS_PER_PACKED_DIE)) & PACKED_DIE_MASK];
+        }
+        group += BITS_PER_PACKED_DIE;
+    }
+}
+
+/**
+* Stores the face of the die at the specified index of packed dice.
+*   - packedRolls, the packed dice, zeroed where the die goes
+*   - index, the index of the die
+*   - face, the DiceFace of the die
+*/
+void pack_die(unsigned char* packedRolls, int index, int face) {
+    size_t bit = (size_t)index * BITS_PER_PACKED_DIE;
+    unsigned int value = (unsigned int)face << (bit % BITS_PER_BYTE);
+    packedRolls[bit / BITS_PER_BYTE] |= value & 0xff;
+    packedRolls[bit / BITS_PER_BYTE + 1] |= value >> BITS_PER_BYTE;
+}
+
+/**
+* Stores a header field little endian.
+*   - field, where to store it, PACKED_ROLL_FIELD_LENGTH in size
+*   - value, the value of the field
+*/
+void store_packed_field(unsigned char* field, unsigned long long value) {
+    for (int i = 0; i < PACKED_ROLL_FIELD_LENGTH; i++) {
+        field[i] = (unsigned char)(value >> (i * BITS_PER_BYTE));
+    }
+}
+
+/**
+* Returns a little endian header field.
+*   - field, the field, PACKED_ROLL_FIELD_LENGTH in size
+*/
+unsigned long long load_packed_field(const unsigned char* field) {
+    unsigned long long value = 0;
+    for (int i = 0; i < PACKED_ROLL_FIELD_LENGTH; i++) {
+        value |= (unsigned long long)field[i] << (i * BITS_PER_BYTE);
+    }
+    return value;
+}
+
+/**
+* Reads the dice of a packed roll file, whose header has been read. Returns
+* the number of dice, or 0 if the file is truncated or longer than its dice,
+* its checksum does not match or it holds a value that is not a face.
+*   - loadFile, the roll file, positioned after the header
+*   - header, the header
+*   - packedRolls, set to the packed dice
+*/
+int read_packed_dice(FILE* loadFile, const unsigned char* header,
+        unsigned char** packedRolls) {
+    unsigned long long size = load_packed_field(header + 
+            PACKED_ROLL_MAGIC_LENGTH);
+    unsigned long long checksum = load_packed_field(header + 
+            PACKED_ROLL_MAGIC_LENGTH + PACKED_ROLL_FIELD_LENGTH);
+    if (size == 0 || size > INT_MAX - ROLL_WINDOW_SIZE) {
+        return 0;
+    }
+    unsigned char* rolls = allocate_packed_rolls((int)size);
+    size_t length = packed_roll_bytes((int)size);
+    if (rolls == NULL || fread(rolls, 1, length, loadFile) != length ||
+            fgetc(loadFile) != EOF ||
+            hash_bytes(HASH_SEED, rolls, length) != checksum) {
+        free(rolls);
+        return 0;
+    }
+    for (unsigned long long i = 0; i < size; i++) {
+        size_t bit = i * BITS_PER_PACKED_DIE;
+        unsigned int value = (rolls[bit / BITS_PER_BYTE] | 
+                rolls[bit / BITS_PER_BYTE + 1] << BITS_PER_BYTE) >> 
+                (bit % BITS_PER_BYTE);
+        if ((value & PACKED_DIE_MASK) >= NUMBER_OF_FACES) {
+            free(rolls);
+            return 0;
+        }
+    }
+    *packedRolls = rolls;
+    return (int)size;
+}
+
+/**
+* Reads a roll file, text or packed, into newly allocated packed dice. Text
+* roll files are one character per die, ignoring newlines. Returns the 
+* number of dice read, 0 if the file is empty or invalid, or -1 if it cannot
+* be opened. The dice are only allocated if some were read.
+*   - filePath, the file path of the roll file
+*   - packedRolls, set to the packed dice
+*/
+int read_packed_roll_file(char* filePath, unsigned char** packedRolls) {
+    FILE* loadFile = fopen(filePath, "r");
+    if (loadFile == NULL) {
+        return -1;
+    }
+    unsigned char header[PACKED_ROLL_HEADER_LENGTH];
+    size_t headerLength = fread(header, 1, PACKED_ROLL_HEADER_LENGTH, 
+            loadFile);
+    if (headerLength == PACKED_ROLL_HEADER_LENGTH && memcmp(header, 
+            PACKED_ROLL_MAGIC, PACKED_ROLL_MAGIC_LENGTH) == 0) {
+        int size = read_packed_dice(loadFile, header, packedRolls);
+        fclose(loadFile);
+        return size;
+    }
+    rewind(loadFile);
+    /* Capacity will dynamically adjust, starting at one window */
+    int capacity = ROLL_WINDOW_SIZE;
+    int index = 0;
+    unsigned char* rolls = allocate_packed_rolls(capacity);
+    int currentCharacter;
+    while ((currentCharacter = fgetc(loadFile)) != EOF) {
+        if (currentCharacter == '\n') {
+            continue;
+        }
+        int face = get_face_index((char)currentCharacter);
+        if (face < 0) {
+            index = 0;
+            break;
+        }
+        pack_die(rolls, index, face);
+        index++;
+        if (index == capacity) {
+            unsigned char* grown = allocate_packed_rolls(capacity * 2);
+            memcpy(grown, rolls, packed_roll_bytes(capacity));
+            free(rolls);
+            rolls = grown;
+            capacity *= 2;
+        }
+    }
+    fclose(loadFile);
+    if (index == 0) {
+        free(rolls);
+        return 0;
+    }
+    *packedRolls = rolls;
+    return index;
+}
+
+/**
+* Writes packed dice as a packed roll file. Returns false if it cannot be
+* written.
+*   - filePath, the file path of the packed roll file
+*   - packedRolls, the packed dice
+*   - numberOfDice, the number of dice
+*/
+bool write_packed_roll_file(char* filePath, const unsigned char* packedRolls,
+        int numberOfDice) {
+    FILE* saveFile = fopen(filePath, "w");
+    if (saveFile == NULL) {
+        return false;
+    }
+    size_t length = packed_roll_bytes(numberOfDice);
+    unsigned char header[PACKED_ROLL_HEADER_LENGTH];
+    memcpy(header, PACKED_ROLL_MAGIC, PACKED_ROLL_MAGIC_LENGTH);
+    store_packed_field(header + PACKED_ROLL_MAGIC_LENGTH, numberOfDice);
+    store_packed_field(header + PACKED_ROLL_MAGIC_LENGTH + 
+            PACKED_ROLL_FIELD_LENGTH, hash_bytes(HASH_SEED, packedRolls, 
+            length));
+    bool written = fwrite(header, 1, PACKED_ROLL_HEADER_LENGTH, saveFile) ==
+            PACKED_ROLL_HEADER_LENGTH &&
+            fwrite(packedRolls, 1, length, saveFile) == length;
+    return fclose(saveFile) == 0 && written;
+}
+
+/**
+* Reads the dice in a roll file, text or packed, into a newly allocated
+* array of characters. Returns the number of dice read, 0 if the file is 
+* empty or invalid, or -1 if it cannot be opened. The array is only 
+* allocated if dice were read.
+*   - filePath, the file path of the roll file
+*   - diceRolls, set to the array of dice read
+*/
+int read_roll_file(char* filePath, char** diceRolls) {
+    unsigned char* packedRolls;
+    int size = read_packed_roll_file(filePath, &packedRolls);
+    if (size <= 0) {
+        return size;
+    }
+    int windows = size / ROLL_WINDOW_SIZE + 1;
+    char* rolls = malloc(windows * ROLL_WINDOW_SIZE);
+    decode_packed_dice(packedRolls, 0, windows * ROLL_WINDOW_SIZE, rolls);
+    free(packedRolls);
+    *diceRolls = rolls;
+    return size;
+}
+
+/**
+* Returns the value of the named strategy threshold. The compiled-in default
+* can be overridden at run time by setting the environment variable
+* STLUCIA_<name> to an integer.
+*   - name, the name of the threshold, eg "EAIT_REROLL_HEALTH_THRESHOLD"
+*   - defaultValue, the value to use if it is not overridden
+*/
+int strategy_threshold(char* name, int defaultValue) {
+    char variable[MAX_MESSAGE_LENGTH];
+    snprintf(variable, MAX_MESSAGE_LENGTH, "%s%s", THRESHOLD_VARIABLE_PREFIX,
+            name);
+    return integer_setting(variable, defaultValue, INT_MIN, INT_MAX);
+}
+
+/**
+* Returns the value of an integer setting from the environment, or the
+* default if the variable is unset, not an integer or out of range.
+*   - variable, the full name of the variable, eg "STLUCIA_OPEN_TABLES"
+*   - defaultValue, the value to use if it is not set or invalid
+*   - minimum, maximum, the range of valid values
+*/
+long long long_integer_setting(char* variable, long long defaultValue,
+        long long minimum, long long maximum) {
+    char* value = getenv(variable);
+    if (value == NULL || *value == '\0') {
+        return defaultValue;
+    }
+    char* end;
+    errno = 0;
+    long long setting = strtoll(value, &end, 10);
+    if (*end != '\0' || errno == ERANGE || setting < minimum ||
+            setting > maximum) {
+        return defaultValue;
+    }
+    return setting;
+}
+
+/**
+* Returns the value of an integer setting from the environment that fits an
+* int, or the default if it is unset, not an integer or out of range.
+*   - variable, the full name of the variable, eg "STLUCIA_OPEN_TABLES"
+*   - defaultValue, the value to use if it is not set or invalid
+*   - minimum, maximum, the range of valid values
+*/
+int integer_setting(char* variable, int defaultValue, int minimum,
+        int maximum) {
+    return (int)long_integer_setting(variable, defaultValue, minimum,
+            maximum);
+}
+
+/**
+* Returns the specified threshold clamped to the range a policy can express.
+* Healths and dice counts never leave that range, so decisions are unchanged.
+*   - value, the threshold to clamp
+*   - maximum, the largest value the policy can express
+*/
+int policy_value(int value, int maximum) {
+    if (value < 0) {
+        return 0;
+    }
+    if (value > maximum) {
+        return maximum;
+    }
+    return value;
+}
+
+/**
+* Reads a two digit policy threshold. Returns true if it is valid, otherwise
+* returns false.
+*   - text, the threshold sent
+*   - threshold, where to store the threshold
+*/
+bool parse_policy_threshold(char* text, int* threshold) {
+    if (strlen(text) != POLICY_THRESHOLD_LENGTH || !isdigit(text[0]) ||
+            !isdigit(text[1])) {
+        return false;
+    }
+    *threshold = atoi(text);
+    return true;
+}
+
+/**
+* Reads the low and high health rows of a policy. Returns true if they are 
+* valid, otherwise returns false.
+*   - text, the rows sent, a rule for each face of each row
+*   - rows, where to store the two rows
+*/
+bool parse_policy_rows(char* text, char rows[][NUMBER_OF_FACES]) {
+    if (strlen(text) != POLICY_ROW_LENGTH) {
+        return false;
+    }
+    for (int i = 0; i < POLICY_ROW_LENGTH; i++) {
+        if ((text[i] < POLICY_NEVER || text[i] > POLICY_ALWAYS) &&
+                text[i] != POLICY_UNLESS_FATAL) {
+            return false;
+        }
+        rows[i / NUMBER_OF_FACES][i % NUMBER_OF_FACES] = text[i];
+    }
+    return true;
+}
+
+/**
+* Reads a "policy health outside inside retreat" message into the policy 
+* specified. Either both reroll fields or the retreat field may be "-", 
+* leaving those decisions to the player. Returns true if the message is 
+* valid, otherwise returns false and leaves the policy unchanged.
+*   - commands, an array representation of the message sent
+*   - numberCommands, the number of commands sent
+*   - policy, the policy to update
+*/
+bool parse_policy(char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH], 
+        int numberCommands, Policy* policy) {
+    Policy parsed;
+    if (numberCommands != POLICY_MESSAGE_SIZE || 
+            strcmp(commands[0], "policy") != 0 ||
+            !parse_policy_threshold(commands[POLICY_HEALTH_INDEX], 
+            &parsed.healthThreshold)) {
+        return false;
+    }
+    if (strcmp(commands[POLICY_OUTSIDE_INDEX], POLICY_INTERACTIVE) == 0 &&
+            strcmp(commands[POLICY_INSIDE_INDEX], POLICY_INTERACTIVE) == 0) {
+        parsed.rerolls = false;
+    } else if (parse_policy_rows(commands[POLICY_OUTSIDE_INDEX], 
+            parsed.faces) && parse_policy_rows(
+            commands[POLICY_INSIDE_INDEX], 
+            &parsed.faces[POLICY_INSIDE_ROW])) {
+        parsed.rerolls = true;
+    } else {
+        return false;
+    }
+    if (strcmp(commands[POLICY_RETREAT_INDEX], POLICY_INTERACTIVE) == 0) {
+        parsed.retreats = false;
+    } else if (parse_policy_threshold(commands[POLICY_RETREAT_INDEX],
+            &parsed.retreatHealthThreshold)) {
+        parsed.retreats = true;
+    } else {
+        return false;
+    }
+    *policy = parsed;
+    return true;
+}
+
+/**
+* Decides which dice a policy rerolls, writing the count of each face to
+* reroll. Returns the number of dice to reroll.
+*   - policy, the policy to play
+*   - health, the health of the player rolling
+*   - inStLucia, whether the player rolling is in St Lucia
+*   - holderHealth, the health of the player in St Lucia, or more than 
+*       DICE_SET_SIZE if it is empty or the player rolling holds it
+*   - dice, the count of each face rolled
+*   - reroll, where to write the count of each face to reroll
+*/
+int policy_reroll(Policy* policy, int health, bool inStLucia, 
+        int holderHealth, const int* dice, int* reroll) {
+    int row = inStLucia * POLICY_INSIDE_ROW + 
+            (health >= policy->healthThreshold);
+    int total = 0;
+    for (int face = 0; face < NUMBER_OF_FACES; face++) {
+        char rule = policy->faces[row][face];
+        reroll[face] = 0;
+        if (rule == POLICY_UNLESS_FATAL) {
+            if (dice[face] < holderHealth) {
+                reroll[face] = dice[face];
+            }
+        } else if (dice[face] < rule - POLICY_NEVER) {
+            reroll[face] = dice[face];
+        }
+        total += reroll[face];
+    }
+    return total;
+}
+
+/**
+* Folds the specified bytes into a running 64-bit FNV-1a hash and returns the
+* result. Start with HASH_SEED.
+*   - hash, the hash so far
+*   - data, the bytes to hash
+*   - length, the number of bytes to hash
+*/
+unsigned long long hash_bytes(unsigned long long hash, const void* data,
+        size_t length) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+/**
+* Returns the monotonic clock in nanoseconds, which every process on the 
+* machine shares, so spans from the hub and players line up.
+*/
+long long trace_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * TRACE_NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+/**
+* Writes one trace event to the trace file. Each event is a single write to 
+* a file opened for appending, so events from many processes never mix.
+*   - event, the event, ending in ",\n"
+*/
+void write_trace_event(const char* event) {
+    size_t length = strlen(event);
+    if (write(traceFile, event, length) != (ssize_t)length) {
+        close(traceFile);
+        traceFile = -1;
+    }
+}
+
+/**
+* Starts tracing if STLUCIA_TRACE names a file, appending to it and starting
+* the JSON array if it is empty. Names the calling thread, and its process
+* if it is the main thread, in the trace. Returns false if tracing is off.
+*   - threadName, the name of the thread in the trace
+*/
+bool open_trace(const char* threadName) {
+    char* path = getenv(TRACE_VARIABLE);
+    if (path == NULL || *path == '\0') {
+        return false;
+    }
+    traceFile = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 
+            TRACE_FILE_MODE);
+    if (traceFile < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(traceFile, &status) == 0 && status.st_size == 0) {
+        write_trace_event("[\n");
+    }
+    int pid = (int)getpid();
+    int tid = (int)syscall(SYS_gettid);
+    char event[MAX_TRACE_EVENT_LENGTH];
+    if (pid == tid) {
+        snprintf(event, MAX_TRACE_EVENT_LENGTH, "{\"name\":\"process_name\","
+                "\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                "\"args\":{\"name\":\"%s\"}},\n", pid, tid, threadName);
+        write_trace_event(event);
+    }
+    snprintf(event, MAX_TRACE_EVENT_LENGTH, "{\"name\":\"thread_name\","
+            "\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\"}},\n", pid, tid, threadName);
+    write_trace_event(event);
+    return traceFile >= 0;
+}
+
+/**
+* Returns the start of a span to pass to trace_end(), or 0 if tracing is off.
+*/
+long long trace_begin(void) {
+    return traceFile < 0 ? 0 : trace_clock();
+}
+
+/**
+* Writes a complete span from the specified start until now, if tracing is 
+* on.
+*   - name, the name of the span
+*   - start, the value trace_begin() returned when the span started
+*/
+void trace_end(const char* name, long long start) {
+    if (traceFile < 0) {
+        return;
+    }
+    long long end = trace_clock();
+    char event[MAX_TRACE_EVENT_LENGTH];
+    snprintf(event, MAX_TRACE_EVENT_LENGTH, "{\"name\":\"%s\","
+            "\"ph\":\"X\",\"ts\":%lld.%03lld,\"dur\":%lld.%03lld,"
+            "\"pid\":%d,\"tid\":%d},\n",
+            name, start / NANOSECONDS_PER_MICROSECOND, 
+            start % NANOSECONDS_PER_MICROSECOND, 
+            (end - start) / NANOSECONDS_PER_MICROSECOND,
+            (end - start) % NANOSECONDS_PER_MICROSECOND, (int)getpid(), 
+            (int)syscall(SYS_gettid));
+    write_trace_event(event);
+}
+
 /**
 * Frees the memory allocated previously with malloc.
 *   - game, a struct of the game state
@@ -331,7 +1000,7 @@ void free_allocated_memory(Game* game, Player** players) {
 
     switch (game->mallocProgress) {
         case ROLL_FILE:
-            free(game->rollFile->diceRolls);
+            free(game->rollFile->packedRolls);
         case PLAYERS:
             for (int i = 0; i < game->numberOfPlayers; ++i) {
                 free(players[i]);
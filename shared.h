@@ -15,10 +15,84 @@
 #define STARTING_HEALTH 10
 #define EMPTY_STLUCIA -1
 
+/* Constants used in calculating points */
+#define STARTING_IN_STLUCIA_POINTS 2
+#define TOKENS_POINTS_THRESHOLD 10
+#define DICE_POINTS_THRESHOLD 2
+#define ONES_DICE_POINT_PENALTY 2
+#define TWOS_DICE_POINT_PENALTY 1
+#define THREES_DICE_POINT_PENALTY 0
+
 /* Messages sent to the player */
 #define MAX_MESSAGE_LENGTH 40
 #define MAX_COMMANDS 5
 
+/* Properties of the reroll and retreat policies players may send the hub.
+Each face of a policy row is a digit, rerolling every die showing that face
+when fewer than that many do, or POLICY_UNLESS_FATAL. */
+#define POLICY_ROWS 4
+#define POLICY_ROW_LENGTH (2 * NUMBER_OF_FACES)
+#define POLICY_NEVER '0'
+#define POLICY_ALWAYS '7'
+#define POLICY_UNLESS_FATAL 'K'
+#define POLICY_INTERACTIVE "-"
+#define POLICY_MAX_THRESHOLD 99
+#define POLICY_HANDSHAKE '#'
+#define POLICY_MESSAGE_SIZE 5
+#define POLICY_HEALTH_INDEX 1
+#define POLICY_OUTSIDE_INDEX 2
+#define POLICY_INSIDE_INDEX 3
+#define POLICY_RETREAT_INDEX 4
+#define POLICY_THRESHOLD_LENGTH 2
+#define POLICY_INSIDE_ROW 2
+#define POLICY_ALLOWED_REROLLS 2
+
+/* Strategy thresholds are overridden by variables named with this prefix */
+#define THRESHOLD_VARIABLE_PREFIX "STLUCIA_"
+
+/* stlucia-tables numbers its games from the one in this variable, so a
+worker can play a later part of a tournament */
+#define FIRST_GAME_VARIABLE "STLUCIA_FIRST_GAME"
+
+/* Spans of the hub and players are appended, as Chrome trace event JSON, to
+the file named by this variable */
+#define TRACE_VARIABLE "STLUCIA_TRACE"
+#define TRACE_FILE_MODE 0644
+#define MAX_TRACE_EVENT_LENGTH 256
+#define NANOSECONDS_PER_MICROSECOND 1000
+#define TRACE_NANOSECONDS_PER_SECOND 1000000000LL
+
+/* Parameters of the 64-bit FNV-1a hash used for cache keys */
+#define HASH_SEED 14695981039346656037ULL
+#define HASH_PRIME 1099511628211ULL
+
+/* Zobrist keys are mixed from the feature, player and value by the splitmix64
+finaliser rather than drawn at random, so state hashes are the same in every
+process and build and can be stored. */
+#define ZOBRIST_SEED 0x53544c5543494121ULL
+#define ZOBRIST_FEATURE_SHIFT 48
+#define ZOBRIST_PLAYER_SHIFT 32
+#define ZOBRIST_VALUE_MASK 0xffffffffULL
+#define ZOBRIST_MIX_1 0xbf58476d1ce4e5b9ULL
+#define ZOBRIST_MIX_2 0x94d049bb133111ebULL
+#define ZOBRIST_SHIFT_1 30
+#define ZOBRIST_SHIFT_2 27
+#define ZOBRIST_SHIFT_3 31
+
+/* Packed roll files hold each die in 3 bits after a header of the magic, the
+number of dice and a checksum of the packed dice, stored little endian. */
+#define PACKED_ROLL_MAGIC "STLROLL3"
+#define PACKED_ROLL_MAGIC_LENGTH 8
+#define PACKED_ROLL_HEADER_LENGTH 24
+#define PACKED_ROLL_FIELD_LENGTH 8
+#define BITS_PER_PACKED_DIE 3
+#define PACKED_DIE_MASK 7
+#define BITS_PER_BYTE 8
+
+/* Packed dice are decoded a window at a time, a multiple of 8 dice so every
+window starts on a byte */
+#define ROLL_WINDOW_SIZE 64
+
 /* The valid characters that comprise the dice rolls */
 #define DICE_CHARACTER_1 '1'
 #define DICE_CHARACTER_2 '2'
@@ -27,6 +101,20 @@
 #define DICE_CHARACTER_5 'A'
 #define DICE_CHARACTER_6 'P'
 
+/**
+* An enum for indexing the six dice faces, in the same order as the dice 
+* characters.
+*/
+typedef enum {
+    FACE_ONE = 0,
+    FACE_TWO = 1,
+    FACE_THREE = 2,
+    FACE_H = 3,
+    FACE_A = 4,
+    FACE_P = 5,
+    NUMBER_OF_FACES = 6
+} DiceFace;
+
 /**
 * A struct for representing dice rolls internally. Six dice rolls is referred
 * to as a dice 'set'.
@@ -52,15 +140,24 @@ typedef struct {
 * three dice sets.
 *   - size, the number of rolls in the roll file
 *   - index, the index of the next dice to be rolled 
-*   - diceRolls, an array containing the dice rolls
+*   - packedRolls, the dice rolls, packed 3 bits to a die
+*   - windowStart, the index of the first die decoded into window, or -1
+*   - window, the dice rolls from windowStart decoded to characters
+*   - refillWindow, fills the window from index when the dice are not held
+*       in packedRolls, or NULL
+*   - stream, the state of refillWindow
 *   - latestDice, a DiceSet of the latest dice rolled 
 *   - rerollDice, a DiceSet of the dice being rerolled
 *   - oppositionDice, a DiceSet for the oppositions dice rolls
 */
-typedef struct {
+typedef struct RollFile {
     int size;
     int index;
-    char* diceRolls;
+    unsigned char* packedRolls;
+    int windowStart;
+    char window[ROLL_WINDOW_SIZE];
+    void (*refillWindow)(struct RollFile* rollFile);
+    void* stream;
     DiceSet* latestDice;
     DiceSet* rerollDice;
     DiceSet* oppositionDice;
@@ -78,6 +175,24 @@ typedef enum {
     UNCONNECTED,
 } PlayerStatus;
 
+/**
+* An enum for the features of the game state that are hashed, each with a
+* Zobrist key for every player and value.
+*   - ZOBRIST_HEALTH, ZOBRIST_POINTS, ZOBRIST_TOKENS, ZOBRIST_STATUS, a
+*       player's health, points, tokens and PlayerStatus
+*   - ZOBRIST_STLUCIA, the player in St Lucia, keyed as player 0
+*   - ZOBRIST_TURN, the player about to take a turn and the roll file index,
+*       not part of the game's hash but mixed in by callers that need it
+*/
+typedef enum {
+    ZOBRIST_HEALTH,
+    ZOBRIST_POINTS,
+    ZOBRIST_TOKENS,
+    ZOBRIST_STATUS,
+    ZOBRIST_STLUCIA,
+    ZOBRIST_TURN
+} ZobristFeature;
+
 /**
 * An enum for recording malloc progress
 *   - NONE, no memory has been malloc'd
@@ -92,6 +207,25 @@ typedef enum {
     ROLL_FILE = 3,
 } MallocProgress;
 
+/**
+* A struct for the reroll and retreat policy a player has sent the hub, which
+* the hub evaluates itself instead of asking the player. Rows are indexed by
+* whether the player is in St Lucia, then whether its health is at least the
+* health threshold.
+*   - rerolls, whether the hub decides the player's rerolls
+*   - retreats, whether the hub decides the player's retreats
+*   - healthThreshold, the health from which the second row of a pair is used
+*   - retreatHealthThreshold, the player retreats below this health
+*   - faces, the reroll rule for each face in each row
+*/
+typedef struct {
+    bool rerolls;
+    bool retreats;
+    int healthThreshold;
+    int retreatHealthThreshold;
+    char faces[POLICY_ROWS][NUMBER_OF_FACES];
+} Policy;
+
 /**
 * A struct for storing player information.
 *   - inbox, the file stream of incoming messages
@@ -103,6 +237,7 @@ typedef enum {
 *   - points, the player points
 *   - tokens, the player token count
 *   - status, the player status
+*   - policy, the policy the hub plays for the player
 */
 typedef struct {
     FILE* inbox;
@@ -114,6 +249,7 @@ typedef struct {
     int points;
     int tokens;
     PlayerStatus status;
+    Policy policy;
 } Player;
 
 /**
@@ -122,19 +258,25 @@ typedef struct {
 *   - playerInStLucia, the number of the player in St Lucia 
 *   - numberOfPlayers, the number of players in the game 
 *   - currentPlayerNumber,  the current player number 
+*   - rollingPlayerNumber, the player whose dice were most recently rolled
 *   - rollFile, a link to the roll file
 *   - numberOfRerolls, the number of times the player has rerolled this 
 *       turn
 *   -mallocProgress, represents which memory has been allocated with malloc
+*   - stateHash, the Zobrist hash of the players' health, points, tokens and
+*       statuses and the player in St Lucia, kept current by the functions
+*       that change them
 *   */
 typedef struct {
     int scoreLimit;
     int playerInStLucia;
     int numberOfPlayers;
     int currentPlayerNumber;
+    int rollingPlayerNumber;
     RollFile* rollFile;
     int numberOfRerolls;
     MallocProgress mallocProgress;
+    unsigned long long stateHash;
 } Game;
 
 /* Function prototypes */
@@ -143,6 +285,8 @@ void initialise_players(Game*, Player** players);
 void intialise_roll_file(RollFile* rollFile);
 void reset_dice_set(DiceSet* latestDice);
 int get_player_number(char playerToken);
+int get_face_index(char die);
+char get_face_character(int face);
 char get_player_label(int playerNumber);
 void update_dice_set(DiceSet* latestDice, char die, int update);
 void add_die_to_dice_set(DiceSet* latestDice, char die);
@@ -160,11 +304,44 @@ void heal(int activePlayer, Game* game, Player** players, bool isHub,
         int healing);
 void damage_player(int player, int damage, Game* game, Player** players, 
         bool isHub);
+unsigned long long zobrist_key(ZobristFeature feature, int player, int value);
+unsigned long long hash_game_state(Game* game, Player** players);
+void add_points(int player, int points, Game* game, Player** players);
+void set_tokens(int player, int tokens, Game* game, Player** players);
+void set_player_status(int player, PlayerStatus status, Game* game, 
+        Player** players);
+void set_player_in_stlucia(int player, Game* game);
 void reroll(Game* game, Player** players, RollFile* rollFile);
 void act_on_dice(Game* game, Player** players);
 bool retreat(Game* game, Player** players);
+bool describe_policy(Game* game, Player** players, char* policy);
+int policy_value(int value, int maximum);
+bool parse_policy_threshold(char* text, int* threshold);
+bool parse_policy_rows(char* text, char rows[][NUMBER_OF_FACES]);
+bool parse_policy(char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH], 
+        int numberCommands, Policy* policy);
+int policy_reroll(Policy* policy, int health, bool inStLucia, 
+        int holderHealth, const int* dice, int* reroll);
 int players_remaining(Game* game, Player** players);
 bool invalid_roll(char* message);
+int read_roll_file(char* filePath, char** diceRolls);
+size_t packed_roll_bytes(int numberOfDice);
+unsigned long long load_packed_field(const unsigned char* field);
+void decode_packed_dice(const unsigned char* packedRolls, int first,
+        int numberOfDice, char* dice);
+int read_packed_roll_file(char* filePath, unsigned char** packedRolls);
+bool write_packed_roll_file(char* filePath, const unsigned char* packedRolls,
+        int numberOfDice);
+int strategy_threshold(char* name, int defaultValue);
+int integer_setting(char* variable, int defaultValue, int minimum,
+        int maximum);
+long long long_integer_setting(char* variable, long long defaultValue,
+        long long minimum, long long maximum);
+unsigned long long hash_bytes(unsigned long long hash, const void* data,
+        size_t length);
+bool open_trace(const char* threadName);
+long long trace_begin(void);
+void trace_end(const char* name, long long start);
 void free_allocated_memory(Game* game, Player** players);
 #endif
 
@@ -0,0 +1,1050 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "shared.h"
+#include "lockstep.h"
+#include "policy.h"
+
+/* Argument information for the solver */
+#define SOLVER_MIN_ARGS 3
+#define SOLVER_MAX_ARGS 16
+#define SOLVER_ROLL_FILE_ARGUMENT_INDEX 1
+#define SOLVER_SCORE_LIMIT_ARGUMENT_INDEX 2
+#define SOLVER_ARGUMENTS_NOT_FACULTIES 3
+
+/* The name of the seat that may play any move */
+#define BEST_RESPONSE_NAME "best"
+
+/* Properties of the games the solver handles */
+#define SOLVER_PLAYERS 2
+#define SOLVER_ALLOWED_REROLLS 2
+#define SOLVER_MAX_STATES (1 << 26)
+
+/* Widths of the fields packed into a state key, and the largest values they
+hold */
+#define TYPE_BITS 1
+#define ACTIVE_BITS 1
+#define HOLDER_BITS 2
+#define HEALTH_BITS 4
+#define TOKENS_BITS 4
+#define POINTS_BITS 7
+#define DICE_RANK_BITS 9
+#define ROLL_INDEX_BITS 20
+#define SOLVER_MAX_SCORE 100
+#define SOLVER_MAX_ROLL_FILE_SIZE (1 << ROLL_INDEX_BITS)
+
+/* Keys of finished games have this bit set, with the winner below it */
+#define TERMINAL_KEY (1ULL << 63)
+
+/* Node indices. The first two nodes are the games won by each player */
+#define ROOT_NODE SOLVER_PLAYERS
+#define EMPTY_TABLE_SLOT -1
+#define KEY_HASH_MULTIPLIER 11400714819323198485ULL
+#define KEY_HASH_SHIFT 32
+#define INITIAL_NODE_CAPACITY 1024
+#define INITIAL_EDGE_CAPACITY 4096
+
+/* Values of a node other than the winning player */
+#define UNSOLVED -1
+#define SOLVER_DRAWN -2
+
+/* The most distinct rerolls of a dice set, and the most moves in a turn */
+#define MAX_REROLLS 64
+#define MAX_MOVES (1 + MAX_REROLLS + MAX_REROLLS * MAX_REROLLS)
+#define CHILD_SET_SIZE 8192
+
+/* The most turns of optimal play printed */
+#define PRINCIPAL_VARIATION_TURNS 200
+#define MAX_THREADS 64
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, normal exit after solving every pairing
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - INVALID_SCORE, winscore is not a positive integer
+*   - OPEN_ERROR, unable to open rolls file for reading
+*   - INVALID_FILE, contents of the rolls file are invalid
+*   - INVALID_FACULTY, a faculty is not one the engine can play
+*   - TOO_LARGE, the game has too many states to solve
+*   - MEMORY_FAILURE, the state graph could not be allocated
+*   - THREAD_FAILURE, a worker thread could not be started
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    INVALID_SCORE = 2,
+    OPEN_ERROR = 3,
+    INVALID_FILE = 4,
+    INVALID_FACULTY = 5,
+    TOO_LARGE = 6,
+    MEMORY_FAILURE = 7,
+    THREAD_FAILURE = 8
+} ExitCodes;
+
+/**
+* An enum for the two kinds of decision in a game.
+*   - TURN_NODE, a player starts their turn and chooses their rerolls
+*   - STAY_NODE, the player in St Lucia was attacked and chooses to stay or go
+*/
+typedef enum {
+    TURN_NODE = 0,
+    STAY_NODE = 1
+} NodeType;
+
+/**
+* A struct for an unpacked game state. A STAY_NODE state is taken after the
+* attack, with the attacker's dice still to be scored.
+*   - type, the decision to be made
+*   - active, the player whose turn it is
+*   - holder, the player in St Lucia or EMPTY_STLUCIA
+*   - health, points, tokens, per player state
+*   - diceRank, the rank of the attacker's dice, for a STAY_NODE
+*   - rollIndex, the index of the next die in the roll file
+*/
+typedef struct {
+    NodeType type;
+    int active;
+    int holder;
+    int health[SOLVER_PLAYERS];
+    int points[SOLVER_PLAYERS];
+    int tokens[SOLVER_PLAYERS];
+    int diceRank;
+    int rollIndex;
+} Position;
+
+/**
+* A struct for one move from a state, with what is needed to describe it.
+*   - key, the key of the state the move leads to
+*   - rolls, the rank of the dice held after each roll, for a TURN_NODE
+*   - rerolls, the packed dice rerolled after each roll, for a TURN_NODE
+*   - rerollsMade, the number of rerolls made, for a TURN_NODE
+*   - retreats, whether the player leaves St Lucia, for a STAY_NODE
+*/
+typedef struct {
+    unsigned long long key;
+    int rolls[SOLVER_ALLOWED_REROLLS + 1];
+    unsigned int rerolls[SOLVER_ALLOWED_REROLLS];
+    int rerollsMade;
+    bool retreats;
+} Move;
+
+/**
+* A struct for the state graph of one pairing, and its solution.
+*   - scoreLimit, the score limit of the game
+*   - rollFileSize, the number of dice in the roll file
+*   - faces, the roll file as DiceFace indices
+*   - strategies, the strategy of each seat
+*   - best, whether each seat may play any move instead of its strategy
+*   - keys, the key of each node
+*   - numberOfNodes, nodeCapacity, the nodes found and allocated
+*   - table, tableSize, the open addressing table of node indices by key
+*   - edgeStart, the first edge of each node, with one extra entry
+*   - edges, the node each edge leads to
+*   - numberOfEdges, edgeCapacity, the edges found and allocated
+*   - value, the winner of each node under optimal play, or SOLVER_DRAWN
+*   - depth, the turns until the game ends under optimal play
+*/
+typedef struct {
+    int scoreLimit;
+    int rollFileSize;
+    unsigned char* faces;
+    Strategy strategies[SOLVER_PLAYERS];
+    bool best[SOLVER_PLAYERS];
+    unsigned long long* keys;
+    int numberOfNodes;
+    int nodeCapacity;
+    int* table;
+    int tableSize;
+    long long* edgeStart;
+    int* edges;
+    long long numberOfEdges;
+    long long edgeCapacity;
+    int* value;
+    int* depth;
+} Solver;
+
+/**
+* A struct for a worker thread expanding part of a level of the graph.
+*   - solver, the solver
+*   - first, last, the nodes to expand
+*   - moves, space for the moves of one node
+*   - children, the distinct child keys of every node, in order
+*   - numberOfChildren, the child keys of each node
+*   - count, capacity, the child keys found and allocated
+*   - seen, seenStamps, stamp, a set of the current node's children, whose
+*       slots are in use when their stamp is the current one
+*/
+typedef struct {
+    Solver* solver;
+    int first;
+    int last;
+    Move* moves;
+    unsigned long long* children;
+    int* numberOfChildren;
+    long long count;
+    long long capacity;
+    unsigned long long seen[CHILD_SET_SIZE];
+    int seenStamps[CHILD_SET_SIZE];
+    int stamp;
+} Expander;
+
+/* The characters of the dice faces, indexed by DiceFace */
+const char faceCharacters[NUMBER_OF_FACES] = {
+    DICE_CHARACTER_1, DICE_CHARACTER_2, DICE_CHARACTER_3,
+    DICE_CHARACTER_4, DICE_CHARACTER_5, DICE_CHARACTER_6
+};
+
+/**
+* Exits the program, with the specified exit status and a message.
+*   - exitStatus, the status to exit with
+*/
+void exit_program(ExitCodes exitStatus) {
+    char* errorString = "";
+    switch (exitStatus) {
+        case SUCCESS:
+            errorString = "";
+            break;
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-solver rollfile winscore "
+                    "[faculty ...]\n";
+            break;
+        case INVALID_SCORE:
+            errorString = "Invalid score\n";
+            break;
+        case OPEN_ERROR:
+            errorString = "Unable to access rollfile\n";
+            break;
+        case INVALID_FILE:
+            errorString = "Error reading rolls\n";
+            break;
+        case INVALID_FACULTY:
+            errorString = "Unknown faculty\n";
+            break;
+        case TOO_LARGE:
+            errorString = "Game too large to solve\n";
+            break;
+        case MEMORY_FAILURE:
+            errorString = "Unable to allocate states\n";
+            break;
+        case THREAD_FAILURE:
+            errorString = "Unable to start solver threads\n";
+            break;
+    }
+    fprintf(stderr, "%s", errorString);
+    exit((int)exitStatus);
+}
+
+/**
+* Packs a position into a state key.
+*   - position, the position to pack
+*/
+unsigned long long pack_position(Position* position) {
+    unsigned long long key = position->type;
+    key = (key << ACTIVE_BITS) | position->active;
+    key = (key << HOLDER_BITS) | (position->holder + 1);
+    for (int i = 0; i < SOLVER_PLAYERS; i++) {
+        key = (key << HEALTH_BITS) | position->health[i];
+        key = (key << TOKENS_BITS) | position->tokens[i];
+        key = (key << POINTS_BITS) | position->points[i];
+    }
+    key = (key << DICE_RANK_BITS) | position->diceRank;
+    return (key << ROLL_INDEX_BITS) | position->rollIndex;
+}
+
+/**
+* Returns the lowest bits of a key and shifts them out.
+*   - key, the key to take bits from
+*   - bits, the number of bits to take
+*/
+int take_bits(unsigned long long* key, int bits) {
+    int value = (int)(*key & ((1ULL << bits) - 1));
+    *key >>= bits;
+    return value;
+}
+
+/**
+* Unpacks a state key into a position. The inverse of pack_position().
+*   - key, the key to unpack
+*   - position, the position to fill
+*/
+void unpack_position(unsigned long long key, Position* position) {
+    position->rollIndex = take_bits(&key, ROLL_INDEX_BITS);
+    position->diceRank = take_bits(&key, DICE_RANK_BITS);
+    for (int i = SOLVER_PLAYERS - 1; i >= 0; i--) {
+        position->points[i] = take_bits(&key, POINTS_BITS);
+        position->tokens[i] = take_bits(&key, TOKENS_BITS);
+        position->health[i] = take_bits(&key, HEALTH_BITS);
+    }
+    position->holder = take_bits(&key, HOLDER_BITS) - 1;
+    position->active = take_bits(&key, ACTIVE_BITS);
+    position->type = (NodeType)take_bits(&key, TYPE_BITS);
+}
+
+/**
+* Adds the specified number of dice from the roll file to the dice, wrapping
+* at its end as the hub does.
+*   - solver, the solver
+*   - dice, the dice, indexed by DiceFace
+*   - count, the number of dice to draw
+*   - rollIndex, the index of the next die, advanced past the dice drawn
+*/
+void draw_rolls(Solver* solver, int* dice, int count, int* rollIndex) {
+    for (int i = 0; i < count; i++) {
+        dice[solver->faces[*rollIndex]]++;
+        *rollIndex = (*rollIndex + 1) % solver->rollFileSize;
+    }
+}
+
+/**
+* Moves the active player into St Lucia, as claim_stlucia() does.
+*   - position, the position
+*/
+void claim(Position* position) {
+    position->holder = position->active;
+    position->points[position->active]++;
+}
+
+/**
+* Scores the active player's dice, checks for a winner and passes the turn
+* on, as the end of run_game()'s turn does. Returns the key of the next turn,
+* or the terminal key of the winner.
+*   - solver, the solver
+*   - position, the position after the attack
+*   - dice, the active player's dice, indexed by DiceFace
+*/
+unsigned long long end_turn(Solver* solver, Position* position,
+        const int* dice) {
+    int active = position->active;
+    int other = SOLVER_PLAYERS - 1 - active;
+    position->tokens[active] += dice[FACE_P];
+    position->points[active] +=
+            position->tokens[active] / TOKENS_POINTS_THRESHOLD;
+    position->tokens[active] %= TOKENS_POINTS_THRESHOLD;
+    if (dice[FACE_ONE] > DICE_POINTS_THRESHOLD) {
+        position->points[active] += dice[FACE_ONE] - ONES_DICE_POINT_PENALTY;
+    }
+    if (dice[FACE_TWO] > DICE_POINTS_THRESHOLD) {
+        position->points[active] += dice[FACE_TWO] - TWOS_DICE_POINT_PENALTY;
+    }
+    if (dice[FACE_THREE] > DICE_POINTS_THRESHOLD) {
+        position->points[active] +=
+                dice[FACE_THREE] - THREES_DICE_POINT_PENALTY;
+    }
+    if (position->health[other] == 0 ||
+            position->points[active] >= solver->scoreLimit) {
+        return TERMINAL_KEY | active;
+    }
+    position->type = TURN_NODE;
+    position->active = other;
+    position->diceRank = 0;
+    return pack_position(position);
+}
+
+/**
+* Heals the active player and resolves their attack, as heal() and attack()
+* do. Returns the key of the holder's stay or go decision if they were
+* attacked and survived, otherwise of the state after the turn.
+*   - solver, the solver
+*   - position, the position at the start of the turn, copied
+*   - dice, the active player's dice, indexed by DiceFace
+*   - rollIndex, the index of the next die after the turn's rolls
+*/
+unsigned long long resolve_roll(Solver* solver, Position position,
+        const int* dice, int rollIndex) {
+    int active = position.active;
+    int holder = position.holder;
+    position.rollIndex = rollIndex;
+    if (holder != active) {
+        position.health[active] += dice[FACE_H];
+        if (position.health[active] > STARTING_HEALTH) {
+            position.health[active] = STARTING_HEALTH;
+        }
+    }
+    int damage = dice[FACE_A];
+    if (damage > 0 && holder == EMPTY_STLUCIA) {
+        claim(&position);
+    } else if (damage > 0) {
+        int target = (holder == active) ? SOLVER_PLAYERS - 1 - active :
+                holder;
+        position.health[target] = (position.health[target] < damage) ? 0 :
+                position.health[target] - damage;
+        if (target == holder && position.health[holder] == 0) {
+            claim(&position);
+        } else if (target == holder) {
+            position.type = STAY_NODE;
+            position.diceRank = rank_dice_counts(dice);
+            return pack_position(&position);
+        }
+    }
+    return end_turn(solver, &position, dice);
+}
+
+/**
+* Advances the counts to the next sub-multiset of the dice, in odometer
+* order. Returns false once every sub-multiset has been visited.
+*   - reroll, the counts, indexed by DiceFace
+*   - dice, the dice, indexed by DiceFace
+*/
+bool next_reroll(int* reroll, const int* dice) {
+    for (int face = 0; face < NUMBER_OF_FACES; face++) {
+        if (reroll[face] < dice[face]) {
+            reroll[face]++;
+            return true;
+        }
+        reroll[face] = 0;
+    }
+    return false;
+}
+
+/**
+* Adds the moves that follow the active player holding the dice after the
+* specified number of rerolls, recursing into every reroll the seat may make.
+*   - solver, the solver
+*   - start, the position at the start of the turn
+*   - dice, the dice held, indexed by DiceFace
+*   - rollIndex, the index of the next die
+*   - move, the move so far
+*   - moves, the moves found
+*   - numberOfMoves, the number of moves found
+*/
+void add_turn_moves(Solver* solver, Position* start, const int* dice,
+        int rollIndex, Move* move, Move* moves, int* numberOfMoves) {
+    int stage = move->rerollsMade;
+    int active = start->active;
+    move->rolls[stage] = rank_dice_counts(dice);
+    int reroll[NUMBER_OF_FACES] = {0};
+    if (!solver->best[active]) {
+        int holder = start->holder;
+        int holderHealth = (holder == EMPTY_STLUCIA) ? STARTING_HEALTH + 1 :
+                start->health[holder];
+        if (stage == SOLVER_ALLOWED_REROLLS ||
+                strategy_reroll(&solver->strategies[active],
+                start->health[active], holder == active, holderHealth, dice,
+                reroll) == 0) {
+            move->key = resolve_roll(solver, *start, dice, rollIndex);
+            moves[(*numberOfMoves)++] = *move;
+            return;
+        }
+    } else {
+        move->key = resolve_roll(solver, *start, dice, rollIndex);
+        moves[(*numberOfMoves)++] = *move;
+        if (stage == SOLVER_ALLOWED_REROLLS || !next_reroll(reroll, dice)) {
+            return;
+        }
+    }
+    do {
+        int held[NUMBER_OF_FACES];
+        int count = 0;
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            held[face] = dice[face] - reroll[face];
+            count += reroll[face];
+        }
+        int index = rollIndex;
+        draw_rolls(solver, held, count, &index);
+        move->rerolls[stage] = pack_dice_counts(reroll);
+        move->rerollsMade = stage + 1;
+        add_turn_moves(solver, start, held, index, move, moves,
+                numberOfMoves);
+        move->rerollsMade = stage;
+    } while (solver->best[active] && next_reroll(reroll, dice));
+}
+
+/**
+* Fills the moves available from a state and returns how many there are.
+* Seats playing a faculty have the one move their strategy makes.
+*   - solver, the solver
+*   - key, the key of the state
+*   - moves, the moves found
+*/
+int expand_node(Solver* solver, unsigned long long key, Move* moves) {
+    Position position;
+    unpack_position(key, &position);
+    int numberOfMoves = 0;
+    if (position.type == TURN_NODE) {
+        if (position.holder == position.active) {
+            position.points[position.active] += STARTING_IN_STLUCIA_POINTS;
+        }
+        int dice[NUMBER_OF_FACES] = {0};
+        int rollIndex = position.rollIndex;
+        draw_rolls(solver, dice, DICE_SET_SIZE, &rollIndex);
+        Move move = {0};
+        add_turn_moves(solver, &position, dice, rollIndex, &move, moves,
+                &numberOfMoves);
+        return numberOfMoves;
+    }
+
+    int dice[NUMBER_OF_FACES];
+    unrank_dice_counts(position.diceRank, dice);
+    int holder = position.holder;
+    for (int retreats = 0; retreats <= 1; retreats++) {
+        if (!solver->best[holder] && retreats !=
+                strategy_retreats(&solver->strategies[holder],
+                position.health[holder], SOLVER_PLAYERS)) {
+            continue;
+        }
+        Position next = position;
+        if (retreats) {
+            claim(&next);
+        }
+        Move move = {0};
+        move.retreats = retreats;
+        move.key = end_turn(solver, &next, dice);
+        moves[numberOfMoves++] = move;
+    }
+    return numberOfMoves;
+}
+
+/**
+* Returns the owner of the decision at a node.
+*   - solver, the solver
+*   - node, the node
+*/
+int node_owner(Solver* solver, int node) {
+    Position position;
+    unpack_position(solver->keys[node], &position);
+    return (position.type == TURN_NODE) ? position.active : position.holder;
+}
+
+/**
+* Returns a hash of a state key. Keys differ mostly in their low bits, so
+* they are mixed by a multiply and the high bits kept.
+*   - key, the key to hash
+*/
+unsigned long long hash_key(unsigned long long key) {
+    return (key * KEY_HASH_MULTIPLIER) >> KEY_HASH_SHIFT;
+}
+
+/**
+* Returns the index of the node with the specified key, or EMPTY_TABLE_SLOT.
+*   - solver, the solver
+*   - key, the key to find
+*/
+int find_node(Solver* solver, unsigned long long key) {
+    if (key & TERMINAL_KEY) {
+        return (int)(key & ~TERMINAL_KEY);
+    }
+    int mask = solver->tableSize - 1;
+    int slot = (int)(hash_key(key) & mask);
+    while (solver->table[slot] != EMPTY_TABLE_SLOT) {
+        if (solver->keys[solver->table[slot]] == key) {
+            return solver->table[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return EMPTY_TABLE_SLOT;
+}
+
+/**
+* Places a node in the table.
+*   - solver, the solver
+*   - node, the node to place
+*/
+void place_node(Solver* solver, int node) {
+    int mask = solver->tableSize - 1;
+    int slot = (int)(hash_key(solver->keys[node]) & mask);
+    while (solver->table[slot] != EMPTY_TABLE_SLOT) {
+        slot = (slot + 1) & mask;
+    }
+    solver->table[slot] = node;
+}
+
+/**
+* Returns the index of the node with the specified key, adding it if it is
+* new. Exits if the graph grows too large.
+*   - solver, the solver
+*   - key, the key of the node
+*/
+int add_node(Solver* solver, unsigned long long key) {
+    int node = find_node(solver, key);
+    if (node != EMPTY_TABLE_SLOT) {
+        return node;
+    }
+    if (solver->numberOfNodes == SOLVER_MAX_STATES) {
+        exit_program(TOO_LARGE);
+    }
+    if (solver->numberOfNodes == solver->nodeCapacity) {
+        solver->nodeCapacity *= 2;
+        solver->keys = realloc(solver->keys,
+                sizeof(unsigned long long) * solver->nodeCapacity);
+        solver->edgeStart = realloc(solver->edgeStart,
+                sizeof(long long) * (solver->nodeCapacity + 1));
+        if (solver->keys == NULL || solver->edgeStart == NULL) {
+            exit_program(MEMORY_FAILURE);
+        }
+    }
+    node = solver->numberOfNodes++;
+    solver->keys[node] = key;
+    if (solver->numberOfNodes * 2 > solver->tableSize) {
+        free(solver->table);
+        solver->tableSize *= 2;
+        solver->table = malloc(sizeof(int) * solver->tableSize);
+        if (solver->table == NULL) {
+            exit_program(MEMORY_FAILURE);
+        }
+        memset(solver->table, EMPTY_TABLE_SLOT,
+                sizeof(int) * solver->tableSize);
+        for (int i = ROOT_NODE; i < solver->numberOfNodes; i++) {
+            place_node(solver, i);
+        }
+    } else {
+        place_node(solver, node);
+    }
+    return node;
+}
+
+/**
+* Adds a key to the expander's set of the current node's children. Returns
+* false if it was already there.
+*   - expander, the expander
+*   - key, the key to add
+*/
+bool add_child(Expander* expander, unsigned long long key) {
+    int slot = (int)(hash_key(key) & (CHILD_SET_SIZE - 1));
+    while (expander->seenStamps[slot] == expander->stamp) {
+        if (expander->seen[slot] == key) {
+            return false;
+        }
+        slot = (slot + 1) & (CHILD_SET_SIZE - 1);
+    }
+    expander->seenStamps[slot] = expander->stamp;
+    expander->seen[slot] = key;
+    return true;
+}
+
+/**
+* Expands the expander's nodes, recording the distinct children of each.
+*   - argument, the thread's Expander
+*/
+void* expand_nodes(void* argument) {
+    Expander* expander = argument;
+    Solver* solver = expander->solver;
+    for (int node = expander->first; node < expander->last; node++) {
+        int numberOfMoves = expand_node(solver, solver->keys[node],
+                expander->moves);
+        if (expander->count + numberOfMoves > expander->capacity) {
+            expander->capacity = (expander->count + numberOfMoves) * 2;
+            expander->children = realloc(expander->children,
+                    sizeof(unsigned long long) * expander->capacity);
+            if (expander->children == NULL) {
+                return expander;
+            }
+        }
+        unsigned long long* children = &expander->children[expander->count];
+        int distinct = 0;
+        expander->stamp++;
+        for (int i = 0; i < numberOfMoves; i++) {
+            if (add_child(expander, expander->moves[i].key)) {
+                children[distinct++] = expander->moves[i].key;
+            }
+        }
+        expander->numberOfChildren[node - expander->first] = distinct;
+        expander->count += distinct;
+    }
+    return NULL;
+}
+
+/**
+* Enumerates every state reachable from the start of the game, a level at a
+* time, splitting each level between the threads.
+*   - solver, the solver
+*   - expanders, a work area for each thread
+*   - threads, the number of threads
+*/
+void build_graph(Solver* solver, Expander* expanders, int threads) {
+    Position start = {TURN_NODE, 0, EMPTY_STLUCIA,
+            {STARTING_HEALTH, STARTING_HEALTH}, {0, 0}, {0, 0}, 0, 0};
+    solver->edgeStart[0] = 0;
+    solver->edgeStart[1] = 0;
+    solver->edgeStart[ROOT_NODE] = 0;
+    add_node(solver, pack_position(&start));
+
+    int levelStart = ROOT_NODE;
+    while (levelStart < solver->numberOfNodes) {
+        int levelEnd = solver->numberOfNodes;
+        int size = levelEnd - levelStart;
+        int workers = (size < threads) ? size : threads;
+        pthread_t ids[MAX_THREADS];
+        for (int i = 0; i < workers; i++) {
+            expanders[i].first = levelStart + (int)((long long)size * i /
+                    workers);
+            expanders[i].last = levelStart + (int)((long long)size *
+                    (i + 1) / workers);
+            expanders[i].count = 0;
+            expanders[i].numberOfChildren = malloc(sizeof(int) *
+                    (expanders[i].last - expanders[i].first));
+            if (expanders[i].numberOfChildren == NULL) {
+                exit_program(MEMORY_FAILURE);
+            }
+            if (i > 0 && pthread_create(&ids[i], NULL, expand_nodes,
+                    &expanders[i]) != 0) {
+                exit_program(THREAD_FAILURE);
+            }
+        }
+        bool failed = expand_nodes(&expanders[0]) != NULL;
+        for (int i = 1; i < workers; i++) {
+            void* result;
+            pthread_join(ids[i], &result);
+            failed |= result != NULL;
+        }
+        if (failed) {
+            exit_program(MEMORY_FAILURE);
+        }
+
+        for (int i = 0; i < workers; i++) {
+            long long child = 0;
+            for (int node = expanders[i].first; node < expanders[i].last;
+                    node++) {
+                int distinct = expanders[i].numberOfChildren[
+                        node - expanders[i].first];
+                if (solver->numberOfEdges + distinct >
+                        solver->edgeCapacity) {
+                    solver->edgeCapacity *= 2;
+                    solver->edges = realloc(solver->edges,
+                            sizeof(int) * solver->edgeCapacity);
+                    if (solver->edges == NULL) {
+                        exit_program(MEMORY_FAILURE);
+                    }
+                }
+                for (int j = 0; j < distinct; j++) {
+                    solver->edges[solver->numberOfEdges++] = add_node(solver,
+                            expanders[i].children[child++]);
+                }
+                solver->edgeStart[node + 1] = solver->numberOfEdges;
+            }
+            free(expanders[i].numberOfChildren);
+        }
+        levelStart = levelEnd;
+    }
+}
+
+/**
+* Labels every node with its winner under optimal play by retrograde
+* analysis from the finished games. A player wins a node they decide if any
+* move wins, and loses it once every move loses. Nodes never labelled can be
+* held forever by either player, and are drawn.
+*   - solver, the solver
+*/
+void solve_graph(Solver* solver) {
+    int nodes = solver->numberOfNodes;
+    long long* predecessorStart = calloc(nodes + 1, sizeof(long long));
+    int* predecessors = malloc(sizeof(int) * (solver->numberOfEdges + 1));
+    int* remaining = malloc(sizeof(int) * nodes);
+    int* queue = malloc(sizeof(int) * nodes);
+    solver->value = malloc(sizeof(int) * nodes);
+    solver->depth = malloc(sizeof(int) * nodes);
+    if (predecessorStart == NULL || predecessors == NULL ||
+            remaining == NULL || queue == NULL || solver->value == NULL ||
+            solver->depth == NULL) {
+        exit_program(MEMORY_FAILURE);
+    }
+    for (long long i = 0; i < solver->numberOfEdges; i++) {
+        predecessorStart[solver->edges[i] + 1]++;
+    }
+    for (int i = 0; i < nodes; i++) {
+        predecessorStart[i + 1] += predecessorStart[i];
+        remaining[i] = (int)(solver->edgeStart[i + 1] - solver->edgeStart[i]);
+        solver->value[i] = UNSOLVED;
+    }
+    for (int node = 0; node < nodes; node++) {
+        for (long long i = solver->edgeStart[node];
+                i < solver->edgeStart[node + 1]; i++) {
+            predecessors[predecessorStart[solver->edges[i]]++] = node;
+        }
+    }
+    for (int i = nodes; i > 0; i--) {
+        predecessorStart[i] = predecessorStart[i - 1];
+    }
+    predecessorStart[0] = 0;
+
+    int head = 0;
+    int tail = 0;
+    for (int player = 0; player < SOLVER_PLAYERS; player++) {
+        solver->value[player] = player;
+        solver->depth[player] = 0;
+        queue[tail++] = player;
+    }
+    while (head < tail) {
+        int node = queue[head++];
+        int winner = solver->value[node];
+        for (long long i = predecessorStart[node];
+                i < predecessorStart[node + 1]; i++) {
+            int parent = predecessors[i];
+            if (solver->value[parent] != UNSOLVED) {
+                continue;
+            }
+            remaining[parent]--;
+            if (node_owner(solver, parent) == winner ||
+                    remaining[parent] == 0) {
+                Position position;
+                unpack_position(solver->keys[parent], &position);
+                solver->value[parent] = winner;
+                solver->depth[parent] = solver->depth[node] +
+                        (position.type == TURN_NODE);
+                queue[tail++] = parent;
+            }
+        }
+    }
+    for (int i = 0; i < nodes; i++) {
+        if (solver->value[i] == UNSOLVED) {
+            solver->value[i] = SOLVER_DRAWN;
+        }
+    }
+    free(predecessorStart);
+    free(predecessors);
+    free(remaining);
+    free(queue);
+}
+
+/**
+* Writes the dice as a roll string.
+*   - dice, the dice, indexed by DiceFace
+*   - string, the string to write, of at least DICE_SET_SIZE + 1 characters
+*/
+void format_dice(const int* dice, char* string) {
+    int length = 0;
+    for (int face = 0; face < NUMBER_OF_FACES; face++) {
+        for (int i = 0; i < dice[face]; i++) {
+            string[length++] = faceCharacters[face];
+        }
+    }
+    string[length] = '\0';
+}
+
+/**
+* Prints a move of the principal variation.
+*   - position, the position the move is made from
+*   - move, the move
+*/
+void print_move(Position* position, Move* move) {
+    char roll[DICE_SET_SIZE + 1];
+    int dice[NUMBER_OF_FACES];
+    if (position->type == STAY_NODE) {
+        printf("  Player %c %s\n", get_player_label(position->holder),
+                move->retreats ? "goes" : "stays");
+        return;
+    }
+    unrank_dice_counts(move->rolls[0], dice);
+    format_dice(dice, roll);
+    printf("  Player %c rolls %s", get_player_label(position->active), roll);
+    for (int i = 0; i < move->rerollsMade; i++) {
+        unpack_dice_counts(move->rerolls[i], dice);
+        format_dice(dice, roll);
+        printf(", rerolls %s", roll);
+        unrank_dice_counts(move->rolls[i + 1], dice);
+        format_dice(dice, roll);
+        printf(" for %s", roll);
+    }
+    printf("\n");
+}
+
+/**
+* Returns how good a node is for the specified player: quick wins above slow
+* wins above draws above slow losses above quick losses.
+*   - solver, the solved solver
+*   - node, the node
+*   - player, the player choosing
+*/
+long long node_score(Solver* solver, int node, int player) {
+    if (solver->value[node] == player) {
+        return 2LL * SOLVER_MAX_STATES - solver->depth[node];
+    } else if (solver->value[node] == SOLVER_DRAWN) {
+        return SOLVER_MAX_STATES;
+    }
+    return solver->depth[node];
+}
+
+/**
+* Prints the moves of optimal play from the start of the game: the winner
+* takes the quickest win, the loser the slowest loss.
+*   - solver, the solved solver
+*   - moves, space for the moves of one node
+*/
+void print_principal_variation(Solver* solver, Move* moves) {
+    int node = ROOT_NODE;
+    int turn = 0;
+    while (turn < PRINCIPAL_VARIATION_TURNS && node >= ROOT_NODE) {
+        Position position;
+        unpack_position(solver->keys[node], &position);
+        int owner = node_owner(solver, node);
+        int numberOfMoves = expand_node(solver, solver->keys[node], moves);
+        int chosen = 0;
+        int chosenNode = find_node(solver, moves[0].key);
+        for (int i = 1; i < numberOfMoves; i++) {
+            int child = find_node(solver, moves[i].key);
+            if (node_score(solver, child, owner) >
+                    node_score(solver, chosenNode, owner)) {
+                chosen = i;
+                chosenNode = child;
+            }
+        }
+        print_move(&position, &moves[chosen]);
+        turn += position.type == TURN_NODE;
+        node = chosenNode;
+    }
+}
+
+/**
+* Describes the value of the start of the game.
+*   - solver, the solved solver
+*/
+void print_value(Solver* solver) {
+    int value = solver->value[ROOT_NODE];
+    if (value == SOLVER_DRAWN) {
+        printf("drawn");
+    } else {
+        printf("%c wins in %d turns", get_player_label(value),
+                solver->depth[ROOT_NODE]);
+    }
+    printf(" (%d states)\n", solver->numberOfNodes - ROOT_NODE);
+}
+
+/**
+* Frees the graph and solution of the solver, ready for the next pairing.
+*   - solver, the solver
+*/
+void free_graph(Solver* solver) {
+    free(solver->keys);
+    free(solver->table);
+    free(solver->edgeStart);
+    free(solver->edges);
+    free(solver->value);
+    free(solver->depth);
+}
+
+/**
+* Allocates an empty graph for the next pairing.
+*   - solver, the solver
+*/
+void initialise_graph(Solver* solver) {
+    solver->numberOfNodes = ROOT_NODE;
+    solver->nodeCapacity = INITIAL_NODE_CAPACITY;
+    solver->tableSize = INITIAL_NODE_CAPACITY * 2;
+    solver->numberOfEdges = 0;
+    solver->edgeCapacity = INITIAL_EDGE_CAPACITY;
+    solver->keys = malloc(sizeof(unsigned long long) * solver->nodeCapacity);
+    solver->edgeStart = malloc(sizeof(long long) *
+            (solver->nodeCapacity + 1));
+    solver->table = malloc(sizeof(int) * solver->tableSize);
+    solver->edges = malloc(sizeof(int) * solver->edgeCapacity);
+    solver->value = NULL;
+    solver->depth = NULL;
+    if (solver->keys == NULL || solver->edgeStart == NULL ||
+            solver->table == NULL || solver->edges == NULL) {
+        exit_program(MEMORY_FAILURE);
+    }
+    memset(solver->table, EMPTY_TABLE_SLOT, sizeof(int) * solver->tableSize);
+    for (int player = 0; player < SOLVER_PLAYERS; player++) {
+        solver->keys[player] = TERMINAL_KEY | player;
+    }
+}
+
+/**
+* Sets up a seat from a faculty argument. Returns false if the name is
+* neither BEST_RESPONSE_NAME nor a faculty the engine can play.
+*   - name, the argument
+*   - strategy, the strategy of the seat
+*   - best, set to whether the seat may play any move
+*/
+bool lookup_seat(char* name, Strategy* strategy, bool* best) {
+    Faculty faculty = EAIT_FACULTY;
+    *best = strcasecmp(name, BEST_RESPONSE_NAME) == 0;
+    if (!*best && !lookup_faculty(name, &faculty)) {
+        return false;
+    }
+    default_strategy(faculty, strategy);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    char* defaultSeats[] = {BEST_RESPONSE_NAME, "eait", "science", "mabs",
+            "habs", "hass"};
+    if (argc < SOLVER_MIN_ARGS || argc > SOLVER_MAX_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    int scoreLimit = atoi(argv[SOLVER_SCORE_LIMIT_ARGUMENT_INDEX]);
+    if (scoreLimit <= 0) {
+        exit_program(INVALID_SCORE);
+    }
+    char** seats = &argv[SOLVER_ARGUMENTS_NOT_FACULTIES];
+    int numberOfSeats = argc - SOLVER_ARGUMENTS_NOT_FACULTIES;
+    if (numberOfSeats == 0) {
+        seats = defaultSeats;
+        numberOfSeats = sizeof(defaultSeats) / sizeof(char*);
+    }
+    Strategy strategies[SOLVER_MAX_ARGS];
+    bool best[SOLVER_MAX_ARGS];
+    for (int i = 0; i < numberOfSeats; i++) {
+        if (!lookup_seat(seats[i], &strategies[i], &best[i])) {
+            exit_program(INVALID_FACULTY);
+        }
+    }
+
+    char* diceRolls;
+    int size = read_roll_file(argv[SOLVER_ROLL_FILE_ARGUMENT_INDEX],
+            &diceRolls);
+    if (size < 0) {
+        exit_program(OPEN_ERROR);
+    } else if (size == 0) {
+        exit_program(INVALID_FILE);
+    }
+    if (size > SOLVER_MAX_ROLL_FILE_SIZE || scoreLimit > SOLVER_MAX_SCORE) {
+        exit_program(TOO_LARGE);
+    }
+    Solver solver;
+    solver.scoreLimit = scoreLimit;
+    solver.rollFileSize = size;
+    solver.faces = malloc(size);
+    if (solver.faces == NULL) {
+        exit_program(MEMORY_FAILURE);
+    }
+    for (int i = 0; i < size; i++) {
+        solver.faces[i] = (unsigned char)get_face_index(diceRolls[i]);
+    }
+    free(diceRolls);
+
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (threads < 1) ? 1 : (threads > MAX_THREADS) ? MAX_THREADS :
+            threads;
+    Expander* expanders = calloc(threads, sizeof(Expander));
+    if (expanders == NULL) {
+        exit_program(MEMORY_FAILURE);
+    }
+    for (int i = 0; i < threads; i++) {
+        expanders[i].solver = &solver;
+        expanders[i].moves = malloc(sizeof(Move) * MAX_MOVES);
+        if (expanders[i].moves == NULL) {
+            exit_program(MEMORY_FAILURE);
+        }
+    }
+
+    for (int a = 0; a < numberOfSeats; a++) {
+        for (int b = 0; b < numberOfSeats; b++) {
+            solver.strategies[0] = strategies[a];
+            solver.strategies[1] = strategies[b];
+            solver.best[0] = best[a];
+            solver.best[1] = best[b];
+            initialise_graph(&solver);
+            build_graph(&solver, expanders, threads);
+            solve_graph(&solver);
+            printf("A %-8s B %-8s ", seats[a], seats[b]);
+            print_value(&solver);
+            if (best[a] && best[b]) {
+                print_principal_variation(&solver, expanders[0].moves);
+            }
+            fflush(stdout);
+            free_graph(&solver);
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        free(expanders[i].moves);
+        free(expanders[i].children);
+    }
+    free(expanders);
+    free(solver.faces);
+    exit_program(SUCCESS);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shared.h"
+#include "spectate.h"
+
+/* The ring the hub publishes to, or NULL if no one can spectate */
+SpectatorRing* spectatorRing = NULL;
+
+/**
+* Stores the shared memory name of a ring, which must start with '/'.
+* Returns false if the name is too long.
+*   - name, the ring name as given, with or without the '/'
+*   - objectName, where to store the shared memory name
+*/
+bool ring_object_name(const char* name, char* objectName) {
+    return snprintf(objectName, MAX_RING_NAME_LENGTH, "%s%s",
+            name[0] == '/' ? "" : "/", name) < MAX_RING_NAME_LENGTH;
+}
+
+/**
+* Creates the named ring, or carries on from the last event of an existing
+* one, and publishes the hub's events to it from now on. Returns false if
+* the ring cannot be opened.
+*   - name, the name of the ring
+*/
+bool open_spectator_ring(const char* name) {
+    char objectName[MAX_RING_NAME_LENGTH];
+    if (!ring_object_name(name, objectName)) {
+        return false;
+    }
+    int fd = shm_open(objectName, O_RDWR | O_CREAT, SPECTATOR_MODE);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (status.st_size <
+            (off_t)sizeof(SpectatorRing) &&
+            ftruncate(fd, sizeof(SpectatorRing)) != 0)) {
+        close(fd);
+        return false;
+    }
+    SpectatorRing* ring = mmap(NULL, sizeof(SpectatorRing),
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring == MAP_FAILED) {
+        return false;
+    }
+    if (ring->magic != SPECTATOR_MAGIC || ring->slots != SPECTATOR_SLOTS) {
+        ring->magic = 0;
+        __atomic_store_n(&ring->head, 0, __ATOMIC_SEQ_CST);
+        for (int i = 0; i < SPECTATOR_SLOTS; i++) {
+            __atomic_store_n(&ring->slot[i].sequence, 0, __ATOMIC_SEQ_CST);
+        }
+        ring->slots = SPECTATOR_SLOTS;
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        ring->magic = SPECTATOR_MAGIC;
+    }
+    spectatorRing = ring;
+    return true;
+}
+
+/**
+* Publishes an event to the ring, if there is one. Never waits: a reader
+* still copying the slot being overwritten sees its sequence change.
+*   - event, the event, shorter than MAX_MESSAGE_LENGTH
+*/
+void publish_event(const char* event) {
+    if (spectatorRing == NULL) {
+        return;
+    }
+    unsigned long long position = __atomic_load_n(&spectatorRing->head,
+            __ATOMIC_RELAXED);
+    SpectatorSlot* slot = &spectatorRing->slot[position % SPECTATOR_SLOTS];
+    __atomic_store_n(&slot->sequence, 2 * position + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    strncpy(slot->event, event, MAX_MESSAGE_LENGTH - 1);
+    slot->event[MAX_MESSAGE_LENGTH - 1] = '\0';
+    __atomic_store_n(&slot->sequence, 2 * position + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&spectatorRing->head, position + 1,
+            __ATOMIC_RELEASE);
+}
+
+/**
+* Maps the named ring read only, so the watcher cannot disturb the hub.
+* Returns NULL if there is no such ring.
+*   - name, the name of the ring
+*/
+const SpectatorRing* watch_spectator_ring(const char* name) {
+    char objectName[MAX_RING_NAME_LENGTH];
+    if (!ring_object_name(name, objectName)) {
+        return NULL;
+    }
+    int fd = shm_open(objectName, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 ||
+            status.st_size < (off_t)sizeof(SpectatorRing)) {
+        close(fd);
+        return NULL;
+    }
+    const SpectatorRing* ring = mmap(NULL, sizeof(SpectatorRing), PROT_READ,
+            MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring == MAP_FAILED) {
+        return NULL;
+    }
+    if (ring->magic != SPECTATOR_MAGIC || ring->slots != SPECTATOR_SLOTS) {
+        munmap((void*)ring, sizeof(SpectatorRing));
+        return NULL;
+    }
+    return ring;
+}
+
+/**
+* Copies the event at the specified position of the ring.
+*   - ring, the ring
+*   - position, the number of the event
+*   - event, where to store the event, MAX_MESSAGE_LENGTH in size
+*/
+EventStatus read_event(const SpectatorRing* ring,
+        unsigned long long position, char* event) {
+    const SpectatorSlot* slot = &ring->slot[position % SPECTATOR_SLOTS];
+    unsigned long long complete = 2 * position + 2;
+    unsigned long long before = __atomic_load_n(&slot->sequence,
+            __ATOMIC_ACQUIRE);
+    if (before < complete) {
+        return EVENT_PENDING;
+    } else if (before > complete) {
+        return EVENT_LAPPED;
+    }
+    memcpy(event, slot->event, MAX_MESSAGE_LENGTH);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    unsigned long long after = __atomic_load_n(&slot->sequence,
+            __ATOMIC_RELAXED);
+    if (after != before) {
+        return EVENT_LAPPED;
+    }
+    event[MAX_MESSAGE_LENGTH - 1] = '\0';
+    return EVENT_READ;
+}
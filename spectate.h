@@ -0,0 +1,64 @@
+#include <stdbool.h>
+#include "shared.h"
+
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+/* The hub publishes its events to the shared memory ring named by this */
+#define SPECTATE_VARIABLE "STLUCIA_SPECTATE"
+
+/* The number of events a ring holds, a power of two */
+#define SPECTATOR_SLOTS 1024
+#define SPECTATOR_MAGIC 0x53544c5543494131ULL
+#define SPECTATOR_MODE 0644
+#define MAX_RING_NAME_LENGTH 256
+
+/**
+* An enum for the outcome of reading an event from the ring.
+*   - EVENT_LAPPED, the event has been overwritten by a later one
+*   - EVENT_PENDING, the event has not been published yet
+*   - EVENT_READ, the event was read
+*/
+typedef enum {
+    EVENT_LAPPED,
+    EVENT_PENDING,
+    EVENT_READ
+} EventStatus;
+
+/**
+* A struct for one event in the ring. The writer makes the sequence odd while
+* it writes the event and 2n + 2 once event n is complete, so a reader that
+* sees the same even sequence before and after copying has a whole event.
+* The sequence is accessed with the __atomic builtins.
+*   - sequence, 2n + 1 while event n is written, then 2n + 2
+*   - event, the message the hub alerted the players with
+*/
+typedef struct {
+    unsigned long long sequence;
+    char event[MAX_MESSAGE_LENGTH];
+} SpectatorSlot;
+
+/**
+* A struct for the shared memory broadcast ring. Only the hub writes, and it
+* never waits for readers; a reader more than SPECTATOR_SLOTS events behind
+* has been lapped and skips ahead.
+*   - magic, SPECTATOR_MAGIC once the ring is set up
+*   - slots, the number of slots, SPECTATOR_SLOTS
+*   - head, the number of events published, accessed with the __atomic
+*       builtins
+*   - slot, the events, event n in slot n modulo slots
+*/
+typedef struct {
+    unsigned long long magic;
+    unsigned int slots;
+    unsigned long long head;
+    SpectatorSlot slot[SPECTATOR_SLOTS];
+} SpectatorRing;
+
+/* Function prototypes */
+bool open_spectator_ring(const char* name);
+void publish_event(const char* event);
+const SpectatorRing* watch_spectator_ring(const char* name);
+EventStatus read_event(const SpectatorRing* ring,
+        unsigned long long position, char* event);
+#endif
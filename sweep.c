@@ -0,0 +1,422 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#include "shared.h"
+#include "lockstep.h"
+
+/* Argument information for the parameter sweep */
+#define SWEEP_MIN_ARGS 6
+#define SWEEP_MAX_ARGS 30
+#define SWEEP_ROLL_FILE_ARGUMENT_INDEX 1
+#define SWEEP_SCORE_LIMIT_ARGUMENT_INDEX 2
+#define SWEEP_GAMES_ARGUMENT_INDEX 3
+#define SWEEP_FACULTY_ARGUMENT_INDEX 4
+#define SWEEP_ARGUMENTS_NOT_OPPONENTS 5
+
+/* Properties of the search */
+#define SWEEP_MAX_ROUNDS 16
+#define SWEEP_MAX_TURNS 100000
+#define SWEEP_CONFIDENCE_Z 2.576
+#define SWEEP_RESULTS_SHOWN 10
+#define MAX_THREADS 64
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, normal exit after the sweep
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - INVALID_SCORE, winscore is not a positive integer
+*   - OPEN_ERROR, unable to open rolls file for reading
+*   - INVALID_FILE, contents of the rolls file are invalid
+*   - INVALID_GAMES, the number of games is not a positive integer
+*   - INVALID_FACULTY, a faculty is not one the engine can play
+*   - NO_THRESHOLDS, the swept faculty has no thresholds
+*   - THREAD_FAILURE, a worker thread could not be started
+*   - MEMORY_FAILURE, a worker's games could not be allocated
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    INVALID_SCORE = 2,
+    OPEN_ERROR = 3,
+    INVALID_FILE = 4,
+    INVALID_GAMES = 5,
+    INVALID_FACULTY = 6,
+    NO_THRESHOLDS = 7,
+    THREAD_FAILURE = 8,
+    MEMORY_FAILURE = 9
+} ExitCodes;
+
+/**
+* A struct for one setting of the swept faculty's thresholds.
+*   - strategy, the faculty and thresholds
+*   - games, the number of games played so far
+*   - wins, the number of those games won
+*   - dropped, true once the setting is clearly worse than another
+*/
+typedef struct {
+    Strategy strategy;
+    long long games;
+    long long wins;
+    bool dropped;
+} Candidate;
+
+/**
+* A struct for the state shared by the sweep's worker threads.
+*   - candidates, every setting of the thresholds
+*   - numberOfCandidates, the number of settings
+*   - nextCandidate, the next setting to be played this round
+*   - lock, protects nextCandidate
+*   - opponents, the strategies of the other players
+*   - numberOfPlayers, the number of players in each game
+*   - scoreLimit, the score limit of each game
+*   - lanes, the number of games played with the setting in each seat
+*   - round, the round being played
+*   - diceRolls, the roll file
+*   - rollFileSize, the number of dice in the roll file
+*/
+typedef struct {
+    Candidate* candidates;
+    int numberOfCandidates;
+    int nextCandidate;
+    pthread_mutex_t lock;
+    Strategy opponents[MAX_PLAYERS];
+    int numberOfPlayers;
+    int scoreLimit;
+    int lanes;
+    int round;
+    char* diceRolls;
+    int rollFileSize;
+} Sweep;
+
+/**
+* Exits the program, with the specified exit status and a message.
+*   - exitStatus, the status to exit with
+*/
+void exit_program(ExitCodes exitStatus) {
+    char* errorString = "";
+    switch (exitStatus) {
+        case SUCCESS:
+            errorString = "";
+            break;
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-sweep rollfile winscore games "
+                    "faculty opponent1 [opponent2 ...]\n";
+            break;
+        case INVALID_SCORE:
+            errorString = "Invalid score\n";
+            break;
+        case OPEN_ERROR:
+            errorString = "Unable to access rollfile\n";
+            break;
+        case INVALID_FILE:
+            errorString = "Error reading rolls\n";
+            break;
+        case INVALID_GAMES:
+            errorString = "Invalid number of games\n";
+            break;
+        case INVALID_FACULTY:
+            errorString = "Unknown faculty\n";
+            break;
+        case NO_THRESHOLDS:
+            errorString = "Faculty has no thresholds to sweep\n";
+            break;
+        case THREAD_FAILURE:
+            errorString = "Unable to start thread\n";
+            break;
+        case MEMORY_FAILURE:
+            errorString = "Unable to allocate games\n";
+            break;
+    }
+    fprintf(stderr, "%s", errorString);
+    exit((int)exitStatus);
+}
+
+/**
+* Adds every setting of the thresholds the faculty uses to the sweep. Each
+* threshold ranges over every value that changes the faculty's decisions.
+*   - sweep, the sweep
+*   - faculty, the faculty being swept
+*/
+void enumerate_candidates(Sweep* sweep, Faculty faculty) {
+    Strategy base;
+    default_strategy(faculty, &base);
+    int diceMax = (faculty == EAIT_FACULTY) ? DICE_SET_SIZE + 1 : -1;
+    int rerollMax = (faculty != MABS_FACULTY && faculty != HASS_FACULTY) ?
+            STARTING_HEALTH + 1 : -1;
+    int retreatMax = (faculty == EAIT_FACULTY || faculty == HABS_FACULTY) ?
+            STARTING_HEALTH + 1 : -1;
+    int remainingMax = (faculty == HABS_FACULTY) ?
+            sweep->numberOfPlayers : -1;
+    if (rerollMax < 0) {
+        exit_program(NO_THRESHOLDS);
+    }
+    int count = (diceMax + 2) * (rerollMax + 2) * (retreatMax + 2) *
+            (remainingMax + 2);
+    sweep->candidates = calloc(count, sizeof(Candidate));
+    sweep->numberOfCandidates = 0;
+    for (int dice = (diceMax < 0 ? -1 : 0); dice <= diceMax; dice++) {
+        for (int reroll = 0; reroll <= rerollMax; reroll++) {
+            for (int retreat = (retreatMax < 0 ? -1 : 0);
+                    retreat <= retreatMax; retreat++) {
+                for (int remaining = (remainingMax < 0 ? -1 : 0);
+                        remaining <= remainingMax; remaining++) {
+                    Strategy* strategy = &sweep->candidates[
+                            sweep->numberOfCandidates++].strategy;
+                    *strategy = base;
+                    strategy->rerollHealthThreshold = reroll;
+                    if (dice >= 0) {
+                        strategy->rerollNumberDiceThreshold = dice;
+                    }
+                    if (retreat >= 0) {
+                        strategy->retreatHealthThreshold = retreat;
+                    }
+                    if (remaining >= 0) {
+                        strategy->retreatRemainingPlayersThreshold =
+                                remaining;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+* Plays one round of games with a setting, once from each seat against the
+* opponents in order, and adds the results to the setting.
+*   - sweep, the sweep
+*   - lockstep, the worker's engine
+*   - candidate, the setting to play
+*/
+void play_candidate(Sweep* sweep, Lockstep* lockstep, Candidate* candidate) {
+    for (int seat = 0; seat < sweep->numberOfPlayers; seat++) {
+        int opponent = 0;
+        for (int i = 0; i < sweep->numberOfPlayers; i++) {
+            lockstep->strategies[i] = (i == seat) ? candidate->strategy :
+                    sweep->opponents[opponent++];
+        }
+        long long first = ((long long)sweep->round * sweep->numberOfPlayers +
+                seat) * sweep->lanes;
+        reset_lockstep(lockstep, (int)(first % sweep->rollFileSize));
+        run_lockstep(lockstep);
+        for (int lane = 0; lane < sweep->lanes; lane++) {
+            candidate->wins += lockstep->winner[lane] == seat;
+        }
+        candidate->games += sweep->lanes;
+    }
+}
+
+/**
+* Worker thread that plays a round for settings taken from the sweep until
+* every remaining setting has been played.
+*   - argument, the Sweep
+*/
+void* sweep_worker(void* argument) {
+    Sweep* sweep = argument;
+    Lockstep lockstep;
+    if (!initialise_lockstep(&lockstep, sweep->lanes, sweep->numberOfPlayers,
+            sweep->scoreLimit, SWEEP_MAX_TURNS) ||
+            !load_lockstep_rolls(&lockstep, sweep->diceRolls,
+            sweep->rollFileSize)) {
+        exit_program(MEMORY_FAILURE);
+    }
+    while (true) {
+        pthread_mutex_lock(&sweep->lock);
+        int next = sweep->nextCandidate++;
+        pthread_mutex_unlock(&sweep->lock);
+        if (next >= sweep->numberOfCandidates) {
+            break;
+        }
+        if (!sweep->candidates[next].dropped) {
+            play_candidate(sweep, &lockstep, &sweep->candidates[next]);
+        }
+    }
+    free_lockstep(&lockstep);
+    return NULL;
+}
+
+/**
+* Returns the fraction of games the setting has won, offset by the specified
+* multiple of its standard error.
+*   - candidate, the setting
+*   - deviations, the number of standard errors to add
+*/
+double win_rate_bound(Candidate* candidate, double deviations) {
+    double rate = (double)candidate->wins / candidate->games;
+    return rate + deviations * sqrt(rate * (1.0 - rate) / candidate->games);
+}
+
+/**
+* Drops every setting whose win rate is confidently below that of the best
+* setting. Returns the number of settings remaining.
+*   - sweep, the sweep
+*/
+int drop_dominated(Sweep* sweep) {
+    double bestLower = 0.0;
+    for (int i = 0; i < sweep->numberOfCandidates; i++) {
+        Candidate* candidate = &sweep->candidates[i];
+        double lower = win_rate_bound(candidate, -SWEEP_CONFIDENCE_Z);
+        if (!candidate->dropped && lower > bestLower) {
+            bestLower = lower;
+        }
+    }
+    int remaining = 0;
+    for (int i = 0; i < sweep->numberOfCandidates; i++) {
+        Candidate* candidate = &sweep->candidates[i];
+        if (candidate->dropped) {
+            continue;
+        }
+        if (win_rate_bound(candidate, SWEEP_CONFIDENCE_Z) < bestLower) {
+            candidate->dropped = true;
+        } else {
+            remaining++;
+        }
+    }
+    return remaining;
+}
+
+/**
+* Plays one round for every remaining setting on all available cores.
+*   - sweep, the sweep
+*/
+void play_round(Sweep* sweep) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int numberOfThreads = (cores < 1) ? 1 :
+            (cores > MAX_THREADS) ? MAX_THREADS : (int)cores;
+    pthread_t threads[MAX_THREADS];
+    sweep->nextCandidate = 0;
+    for (int i = 0; i < numberOfThreads; i++) {
+        if (pthread_create(&threads[i], NULL, sweep_worker, sweep) != 0) {
+            exit_program(THREAD_FAILURE);
+        }
+    }
+    for (int i = 0; i < numberOfThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+/**
+* Orders settings by decreasing win rate, with dropped settings last.
+*   - first, the first setting
+*   - second, the second setting
+*/
+int compare_candidates(const void* first, const void* second) {
+    const Candidate* a = first;
+    const Candidate* b = second;
+    if (a->dropped != b->dropped) {
+        return a->dropped ? 1 : -1;
+    }
+    double rateA = (double)a->wins / a->games;
+    double rateB = (double)b->wins / b->games;
+    return (rateA < rateB) - (rateA > rateB);
+}
+
+/**
+* Prints a threshold as the environment variable that sets it for the
+* faculty's player alone, such as STLUCIA_EAIT_REROLL_HEALTH_THRESHOLD=5.
+*   - faculty, the faculty
+*   - name, the name of the threshold
+*   - value, the value of the threshold
+*/
+void print_threshold(Faculty faculty, char* name, int value) {
+    printf("%s", THRESHOLD_VARIABLE_PREFIX);
+    for (const char* letter = facultyNames[faculty]; *letter != '\0';
+            letter++) {
+        putchar(toupper((unsigned char)*letter));
+    }
+    printf("_%s=%d ", name, value);
+}
+
+/**
+* Prints a setting as the environment variables that make the faculty's
+* player use it, followed by its results.
+*   - candidate, the setting
+*/
+void print_candidate(Candidate* candidate) {
+    Strategy* strategy = &candidate->strategy;
+    Faculty faculty = strategy->faculty;
+    if (faculty == EAIT_FACULTY) {
+        print_threshold(faculty, "REROLL_NUMBER_DICE_THRESHOLD",
+                strategy->rerollNumberDiceThreshold);
+    }
+    print_threshold(faculty, "REROLL_HEALTH_THRESHOLD",
+            strategy->rerollHealthThreshold);
+    if (faculty == EAIT_FACULTY || faculty == HABS_FACULTY) {
+        print_threshold(faculty, "RETREAT_HEALTH_THRESHOLD",
+                strategy->retreatHealthThreshold);
+    }
+    if (faculty == HABS_FACULTY) {
+        print_threshold(faculty, "RETREAT_REMAINING_PLAYERS_THRESHOLD",
+                strategy->retreatRemainingPlayersThreshold);
+    }
+    double rate = (double)candidate->wins / candidate->games;
+    printf("won %.2f%% +/- %.2f%% of %lld games%s\n", 100.0 * rate,
+            100.0 * (win_rate_bound(candidate, SWEEP_CONFIDENCE_Z) - rate),
+            candidate->games, candidate->dropped ? " (dropped)" : "");
+}
+
+int main(int argc, char** argv) {
+    if (argc < SWEEP_MIN_ARGS || argc > SWEEP_MAX_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    Sweep sweep;
+    memset(&sweep, 0, sizeof(Sweep));
+    pthread_mutex_init(&sweep.lock, NULL);
+    sweep.scoreLimit = atoi(argv[SWEEP_SCORE_LIMIT_ARGUMENT_INDEX]);
+    if (sweep.scoreLimit <= 0) {
+        exit_program(INVALID_SCORE);
+    }
+    int games = atoi(argv[SWEEP_GAMES_ARGUMENT_INDEX]);
+    if (games <= 0) {
+        exit_program(INVALID_GAMES);
+    }
+    sweep.numberOfPlayers = argc - SWEEP_ARGUMENTS_NOT_OPPONENTS + 1;
+    sweep.lanes = (games + sweep.numberOfPlayers - 1) /
+            sweep.numberOfPlayers;
+
+    sweep.rollFileSize = read_roll_file(argv[SWEEP_ROLL_FILE_ARGUMENT_INDEX],
+            &sweep.diceRolls);
+    if (sweep.rollFileSize < 0) {
+        exit_program(OPEN_ERROR);
+    } else if (sweep.rollFileSize == 0) {
+        exit_program(INVALID_FILE);
+    }
+
+    Faculty faculty;
+    if (!lookup_faculty(argv[SWEEP_FACULTY_ARGUMENT_INDEX], &faculty)) {
+        exit_program(INVALID_FACULTY);
+    }
+    for (int i = 0; i < sweep.numberOfPlayers - 1; i++) {
+        Faculty opponent;
+        if (!lookup_faculty(argv[i + SWEEP_ARGUMENTS_NOT_OPPONENTS],
+                &opponent)) {
+            exit_program(INVALID_FACULTY);
+        }
+        default_strategy(opponent, &sweep.opponents[i]);
+    }
+    enumerate_candidates(&sweep, faculty);
+
+    int remaining = sweep.numberOfCandidates;
+    for (sweep.round = 0; sweep.round < SWEEP_MAX_ROUNDS && remaining > 1;
+            sweep.round++) {
+        play_round(&sweep);
+        remaining = drop_dominated(&sweep);
+        fprintf(stderr, "Round %d: %d of %d settings remain\n",
+                sweep.round + 1, remaining, sweep.numberOfCandidates);
+    }
+
+    qsort(sweep.candidates, sweep.numberOfCandidates, sizeof(Candidate),
+            compare_candidates);
+    for (int i = 0; i < sweep.numberOfCandidates &&
+            i < SWEEP_RESULTS_SHOWN; i++) {
+        print_candidate(&sweep.candidates[i]);
+    }
+    free(sweep.candidates);
+    free(sweep.diceRolls);
+    exit_program(SUCCESS);
+    return 0;
+}
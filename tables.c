@@ -0,0 +1,1180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include "shared.h"
+#include "affinity.h"
+#include "history.h"
+
+/* Argument information for the multi-table hub */
+#define TABLES_MIN_ARGS 6
+#define TABLES_MAX_ARGS 30
+#define TABLES_ARGUMENTS_NOT_PLAYERS 4
+#define TABLES_ROLL_FILE_ARGUMENT_INDEX 1
+#define TABLES_SCORE_LIMIT_ARGUMENT_INDEX 2
+#define TABLES_GAMES_ARGUMENT_INDEX 3
+#define MAX_PLAYER_COUNT_STRING_SIZE 3
+
+/* The number of tables open at once, overridden by this variable */
+#define OPEN_TABLES_VARIABLE "STLUCIA_OPEN_TABLES"
+#define DEFAULT_OPEN_TABLES 64
+#define MAX_OPEN_TABLES 4096
+
+/* Each seat's faculty is played by a pool of this many processes per core,
+overridden by this variable. With 0 every game starts its own. */
+#define POOL_PROCESSES_VARIABLE "STLUCIA_POOL_PROCESSES"
+#define DEFAULT_POOL_PROCESSES_PER_CORE 1
+#define MAX_TABLES_STRING_SIZE 8
+
+/* Messages to pooled players start with this and the game's table */
+#define TABLE_TAG '@'
+
+/* Constants used in generating pipes */
+#define PIPE_SIZE 2
+#define PIPE_INPUT 1
+#define PIPE_OUTPUT 0
+
+#define REROLLED_DICE_ROLL_INDEX 1
+#define BASE_FOR_INTEGER_CONVERSION 10
+#define NO_PLAYER -1
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, normal exit after all games are played
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - INVALID_SCORE, winscore is not a positive integer
+*   - OPEN_ERROR, unable to open rolls file for reading
+*   - INVALID_FILE, contents of the rolls file are invalid
+*   - INVALID_GAMES, the number of games is not a positive integer
+*   - MEMORY_FAILURE, the tables could not be allocated
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    INVALID_SCORE = 2,
+    OPEN_ERROR = 3,
+    INVALID_FILE = 4,
+    INVALID_GAMES = 5,
+    MEMORY_FAILURE = 6
+} ExitCodes;
+
+/**
+* An enum for what a table is waiting for.
+*   - TABLE_CLOSED, the table has no game
+*   - TABLE_STARTING, waiting for the players' handshakes
+*   - TABLE_ROLLING, waiting for the active player to keep or reroll
+*   - TABLE_STAYING, waiting for the player in St Lucia to stay or go
+*/
+typedef enum {
+    TABLE_CLOSED,
+    TABLE_STARTING,
+    TABLE_ROLLING,
+    TABLE_STAYING
+} TableState;
+
+/**
+* An enum for how a game at a table ended.
+*   - GAME_WON, a player won
+*   - GAME_DRAWN, the game reached a state it had already been in, so would
+*       never end
+*   - GAME_ABANDONED, a player quit or broke the protocol
+*/
+typedef enum {
+    GAME_WON,
+    GAME_DRAWN,
+    GAME_ABANDONED
+} GameResult;
+
+/**
+* A struct for a player process, which plays one seat of one game or, when
+* pooled, the same seat of many games.
+*   - inbox, the pipe the hub writes messages to, or -1 if not running
+*   - outbox, the pipe the hub reads replies from, without blocking, or -1
+*       if not running
+*   - pid, the pid of the player
+*   - playerNumber, the seat the process plays
+*   - connected, whether the player has shaken hands
+*   - awaitingPolicy, whether the player has shaken hands with '#', so its
+*       policy follows
+*   - policy, the policy the hub plays for the player
+*   - length, the number of bytes of an incomplete reply buffered
+*   - reply, the buffered reply
+*   - restarts, the number of times the process was started again after it
+*       was lost
+*   - abandoned, the number of games abandoned because of the process
+*/
+typedef struct {
+    int inbox;
+    int outbox;
+    pid_t pid;
+    int playerNumber;
+    bool connected;
+    bool awaitingPolicy;
+    Policy policy;
+    int length;
+    char reply[MAX_MESSAGE_LENGTH];
+    int restarts;
+    int abandoned;
+} Process;
+
+/**
+* A struct for a table playing one game. Each table keeps the game state the
+* hub keeps for its one game, changed by the same shared functions, and its
+* own place in the shared roll file. Tables and their players are allocated
+* once, so no memory is allocated as games start and end, other than to grow
+* a table's state history.
+*   - number, the number of the table, which tags its messages when pooled
+*   - state, what the table is waiting for
+*   - gameNumber, the game being played, which is also its first roll
+*   - turns, the number of turns started
+*   - startingPoints, the active player's points at the start of the turn
+*   - game, the game state, whose currentPlayerNumber is the active player
+*   - rollFile, the table's place in the roll file
+*   - dice, the dice the active player has rolled
+*   - rollString, the string of dice
+*   - players, the players of the table, numberOfPlayers in size
+*   - processes, the process playing each player
+*   - history, the states the game has been in, to draw it once it repeats
+*/
+typedef struct {
+    int number;
+    TableState state;
+    int gameNumber;
+    int turns;
+    int startingPoints;
+    Game game;
+    RollFile rollFile;
+    DiceSet dice;
+    char rollString[DICE_SET_SIZE + 1];
+    Player** players;
+    Process** processes;
+    StateHistory history;
+} Table;
+
+/**
+* A struct for the tables of the hub and the games they play.
+*   - numberOfPlayers, the number of players at each table
+*   - scoreLimit, the score limit of each game
+*   - rollFileSize, the number of dice in the roll file
+*   - packedRolls, the roll file, shared by every table
+*   - faculties, the faculty played in each seat
+*   - openTables, the number of tables
+*   - tables, the tables
+*   - players, the players of every table
+*   - tablePlayers, the pointers to each table's players
+*   - tableProcesses, the process playing each player of every table
+*   - pooled, whether each seat's processes are shared between tables
+*   - shookHands, whether each seat has had a pooled process shake hands,
+*       so its faculty plays tables
+*   - processesPerSeat, the number of processes playing each pooled seat
+*   - processes, openTables processes for each seat in turn, of which a
+*       pooled seat uses the first processesPerSeat
+*   - polls, the poll entry of every process
+*   - firstGame, the number of the first game
+*   - games, the number of games to play
+*   - nextGame, the next game to start, counted from firstGame
+*   - finished, the number of games ended
+*   - wins, the games won by each seat
+*   - draws, abandoned, the games drawn and abandoned
+*   - turns, the number of turns played
+*/
+typedef struct {
+    int numberOfPlayers;
+    int scoreLimit;
+    int rollFileSize;
+    unsigned char* packedRolls;
+    char** faculties;
+    int openTables;
+    Table* tables;
+    Player* players;
+    Player** tablePlayers;
+    Process** tableProcesses;
+    bool pooled[MAX_PLAYERS];
+    bool shookHands[MAX_PLAYERS];
+    int processesPerSeat;
+    Process* processes;
+    struct pollfd* polls;
+    int firstGame;
+    int games;
+    int nextGame;
+    int finished;
+    int wins[MAX_PLAYERS];
+    int draws;
+    int abandoned;
+    long long turns;
+} Hall;
+
+void start_turn(Hall* hall, Table* table);
+
+/**
+* Exits the program, with the specified exit status and a message.
+*   - exitStatus, the status to exit with
+*/
+void exit_program(ExitCodes exitStatus) {
+    char* errorString = "";
+    switch (exitStatus) {
+        case SUCCESS:
+            errorString = "";
+            break;
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-tables rollfile winscore games "
+                    "prog1 prog2 [prog3 ...]\n";
+            break;
+        case INVALID_SCORE:
+            errorString = "Invalid score\n";
+            break;
+        case OPEN_ERROR:
+            errorString = "Unable to access rollfile\n";
+            break;
+        case INVALID_FILE:
+            errorString = "Error reading rolls\n";
+            break;
+        case INVALID_GAMES:
+            errorString = "Invalid number of games\n";
+            break;
+        case MEMORY_FAILURE:
+            errorString = "Unable to allocate tables\n";
+            break;
+    }
+    fprintf(stderr, "%s", errorString);
+    exit((int)exitStatus);
+}
+
+/**
+* Returns the current monotonic time in seconds.
+*/
+double current_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+* Writes a message to a process. A player that has gone is noticed when it is
+* next read from, so write errors are ignored.
+*   - process, the process to send to
+*   - message, the message to send
+*/
+void send_process(Process* process, char* message) {
+    size_t length = strlen(message);
+    size_t written = 0;
+    while (process->inbox >= 0 && written < length) {
+        ssize_t result = write(process->inbox, message + written,
+                length - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return;
+        }
+        written += (size_t)result;
+    }
+}
+
+/**
+* Writes a message to the process playing a seat, tagged with the table when
+* the process is pooled.
+*   - hall, the tables of the hub
+*   - table, the table of the seat
+*   - playerNumber, the seat's player
+*   - message, the message to send
+*/
+void send_seat(Hall* hall, Table* table, int playerNumber, char* message) {
+    if (!hall->pooled[playerNumber]) {
+        send_process(table->processes[playerNumber], message);
+        return;
+    }
+    char tagged[MAX_MESSAGE_LENGTH + MAX_TABLES_STRING_SIZE];
+    snprintf(tagged, sizeof(tagged), "%c%d %s", TABLE_TAG, table->number,
+            message);
+    send_process(table->processes[playerNumber], tagged);
+}
+
+/**
+* Sends the message specified to every remaining player at the table.
+*   - hall, the tables of the hub
+*   - table, the table to send to
+*   - message, the message to send
+*   - skipPlayer, a player not to send the message to, or NO_PLAYER
+*/
+void alert_table(Hall* hall, Table* table, char* message, int skipPlayer) {
+    for (int i = 0; i < hall->numberOfPlayers; i++) {
+        if (i != skipPlayer && table->players[i]->status == REMAINING) {
+            send_seat(hall, table, i, message);
+        }
+    }
+}
+
+/**
+* Writes the count of each face of the table's dice, in DiceFace order.
+*   - table, the table
+*   - counts, where to write the counts, NUMBER_OF_FACES in size
+*/
+void count_table_dice(Table* table, int* counts) {
+    counts[FACE_ONE] = table->dice.numberOfOnes;
+    counts[FACE_TWO] = table->dice.numberOfTwos;
+    counts[FACE_THREE] = table->dice.numberOfThrees;
+    counts[FACE_H] = table->dice.numberOfHs;
+    counts[FACE_A] = table->dice.numberOfAs;
+    counts[FACE_P] = table->dice.numberOfPs;
+}
+
+/**
+* Closes the pipes of a process, which the player takes as the end of its
+* games.
+*   - process, the process to stop
+*   - killPlayer, whether to kill the player rather than let it exit
+*/
+void stop_process(Process* process, bool killPlayer) {
+    if (process->inbox >= 0) {
+        close(process->inbox);
+    }
+    if (process->outbox >= 0) {
+        close(process->outbox);
+    }
+    if (killPlayer && process->pid > 0) {
+        kill(process->pid, SIGKILL);
+    }
+    process->inbox = process->outbox = -1;
+    process->pid = 0;
+    process->connected = false;
+}
+
+/**
+* Ends the game at a table and records its result. Players that are not
+* pooled are stopped.
+*   - hall, the tables of the hub
+*   - table, the table to close
+*   - result, how the game ended
+*/
+void close_table(Hall* hall, Table* table, GameResult result) {
+    if (result == GAME_WON) {
+        printf("Game %d: Player %c wins\n", table->gameNumber,
+                get_player_label(table->game.currentPlayerNumber));
+        hall->wins[table->game.currentPlayerNumber]++;
+    } else if (result == GAME_DRAWN) {
+        printf("Game %d: drawn\n", table->gameNumber);
+        hall->draws++;
+    } else {
+        printf("Game %d: abandoned\n", table->gameNumber);
+        hall->abandoned++;
+    }
+    if (result != GAME_WON) {
+        alert_table(hall, table, "shutdown\n", NO_PLAYER);
+    }
+    hall->turns += table->turns;
+    hall->finished++;
+    table->state = TABLE_CLOSED;
+    for (int i = 0; i < hall->numberOfPlayers; i++) {
+        if (!hall->pooled[i]) {
+            stop_process(table->processes[i], result == GAME_ABANDONED);
+        }
+    }
+}
+
+/**
+* Abandons the game at a table because of one of its processes.
+*   - hall, the tables of the hub
+*   - table, the table
+*   - process, the process to blame
+*/
+void abandon_table(Hall* hall, Table* table, Process* process) {
+    process->abandoned++;
+    close_table(hall, table, GAME_ABANDONED);
+}
+
+/**
+* Creates a pipe whose ends are closed in the players started later, so 
+* each player only holds its own pipes. Returns false if it fails.
+*   - ends, where to store the two ends of the pipe
+*/
+bool open_private_pipe(int* ends) {
+    if (pipe(ends) != 0) {
+        return false;
+    }
+    fcntl(ends[PIPE_INPUT], F_SETFD, FD_CLOEXEC);
+    fcntl(ends[PIPE_OUTPUT], F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+/**
+* Starts a player process, piped to the hub. Pooled players are told how many
+* tables they play. Replies are read without blocking, so a process lost and
+* started again between a poll() and its read is not waited on. Returns false
+* if the pipes or process cannot be created.
+*   - hall, the tables of the hub
+*   - process, the process to start
+*/
+bool start_process(Hall* hall, Process* process) {
+    int playerNumber = process->playerNumber;
+    process->connected = false;
+    process->awaitingPolicy = false;
+    process->policy.rerolls = false;
+    process->policy.retreats = false;
+    process->length = 0;
+    int hubPipe[PIPE_SIZE];
+    int playerPipe[PIPE_SIZE];
+    if (!open_private_pipe(hubPipe)) {
+        return false;
+    }
+    if (!open_private_pipe(playerPipe)) {
+        close(hubPipe[PIPE_INPUT]);
+        close(hubPipe[PIPE_OUTPUT]);
+        return false;
+    }
+    process->pid = fork();
+    if (process->pid == 0) {
+        dup2(hubPipe[PIPE_OUTPUT], STDIN_FILENO);
+        dup2(playerPipe[PIPE_INPUT], STDOUT_FILENO);
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDERR_FILENO);
+
+        char numberPlayers[MAX_PLAYER_COUNT_STRING_SIZE];
+        sprintf(numberPlayers, "%d", hall->numberOfPlayers);
+        char playerTokenString[LABEL_LENGTH + 1] =
+                {get_player_label(playerNumber), '\0'};
+        char tables[MAX_TABLES_STRING_SIZE];
+        sprintf(tables, "%d", hall->openTables);
+        execlp(hall->faculties[playerNumber], hall->faculties[playerNumber],
+                numberPlayers, playerTokenString, 
+                hall->pooled[playerNumber] ? tables : NULL, NULL);
+        _exit(1);
+    }
+    close(hubPipe[PIPE_OUTPUT]);
+    close(playerPipe[PIPE_INPUT]);
+    process->inbox = hubPipe[PIPE_INPUT];
+    process->outbox = playerPipe[PIPE_OUTPUT];
+    fcntl(process->outbox, F_SETFL, O_NONBLOCK);
+    if (process->pid < 0) {
+        stop_process(process, false);
+        return false;
+    }
+    return true;
+}
+
+/**
+* Returns true if every player at the table has shaken hands.
+*   - hall, the tables of the hub
+*   - table, the table
+*/
+bool table_connected(Hall* hall, Table* table) {
+    for (int i = 0; i < hall->numberOfPlayers; i++) {
+        if (!table->processes[i]->connected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+* Starts the game at a table once every player has shaken hands.
+*   - hall, the tables of the hub
+*   - table, the table
+*/
+void start_table(Hall* hall, Table* table) {
+    if (table->state != TABLE_STARTING || !table_connected(hall, table)) {
+        return;
+    }
+    for (int i = 0; i < hall->numberOfPlayers; i++) {
+        set_player_status(i, REMAINING, &table->game, table->players);
+    }
+    start_state_history(&table->history, &table->game, table->players);
+    start_turn(hall, table);
+}
+
+/**
+* Returns the process playing a seat at a table: one of the seat's pool when
+* it is pooled, otherwise the table's own.
+*   - hall, the tables of the hub
+*   - playerNumber, the seat's player
+*   - tableNumber, the number of the table
+*/
+Process* seat_process(Hall* hall, int playerNumber, int tableNumber) {
+    int slot = hall->pooled[playerNumber] ?
+            tableNumber % hall->processesPerSeat : tableNumber;
+    return &hall->processes[playerNumber * hall->openTables + slot];
+}
+
+/**
+* Starts the next game at a closed table, starting its players unless they
+* are pooled. A pooled player that has gone is started again. The game is
+* abandoned if a player cannot be started.
+*   - hall, the tables of the hub
+*   - table, the table to open
+*/
+void open_table(Hall* hall, Table* table) {
+    table->gameNumber = hall->firstGame + hall->nextGame++;
+    table->rollFile.index = table->gameNumber % hall->rollFileSize;
+    table->turns = 0;
+    table->game.currentPlayerNumber = 0;
+    table->game.playerInStLucia = EMPTY_STLUCIA;
+    table->state = TABLE_STARTING;
+    for (int i = 0; i < hall->numberOfPlayers; i++) {
+        Player* player = table->players[i];
+        player->health = STARTING_HEALTH;
+        player->points = 0;
+        player->tokens = 0;
+        player->status = UNCONNECTED;
+        table->processes[i] = seat_process(hall, i, table->number);
+    }
+    table->game.stateHash = hash_game_state(&table->game, table->players);
+    for (int i = 0; i < hall->numberOfPlayers; i++) {
+        Process* process = table->processes[i];
+        if (hall->pooled[i] && process->outbox >= 0) {
+            continue;
+        }
+        if (hall->pooled[i]) {
+            process->restarts++;
+        }
+        if (!start_process(hall, process)) {
+            abandon_table(hall, table, process);
+            return;
+        }
+    }
+    start_table(hall, table);
+}
+
+/**
+* Sets the active player as the player in St Lucia. Adds 1 point for taking
+* St Lucia. Alerts the players.
+*   - hall, the tables of the hub
+*   - table, the table playing
+*/
+void claim_table(Hall* hall, Table* table) {
+    char claimAlert[MAX_MESSAGE_LENGTH];
+    int activePlayer = table->game.currentPlayerNumber;
+    set_player_in_stlucia(activePlayer, &table->game);
+    add_points(activePlayer, 1, &table->game, table->players);
+    sprintf(claimAlert, "claim %c\n", get_player_label(activePlayer));
+    alert_table(hall, table, claimAlert, NO_PLAYER);
+}
+
+/**
+* Scores the active player's dice, eliminates players and ends the game or
+* starts the next player's turn.
+*   - hall, the tables of the hub
+*   - table, the table playing
+*/
+void end_turn(Hall* hall, Table* table) {
+    Game* game = &table->game;
+    Player** players = table->players;
+    int activePlayer = game->currentPlayerNumber;
+    int tokens = players[activePlayer]->tokens + table->dice.numberOfPs;
+    add_points(activePlayer, tokens / TOKENS_POINTS_THRESHOLD, game, players);
+    set_tokens(activePlayer, tokens % TOKENS_POINTS_THRESHOLD, game, players);
+    if (table->dice.numberOfOnes > DICE_POINTS_THRESHOLD) {
+        add_points(activePlayer, table->dice.numberOfOnes -
+                ONES_DICE_POINT_PENALTY, game, players);
+    }
+    if (table->dice.numberOfTwos > DICE_POINTS_THRESHOLD) {
+        add_points(activePlayer, table->dice.numberOfTwos -
+                TWOS_DICE_POINT_PENALTY, game, players);
+    }
+    if (table->dice.numberOfThrees > DICE_POINTS_THRESHOLD) {
+        add_points(activePlayer, table->dice.numberOfThrees -
+                THREES_DICE_POINT_PENALTY, game, players);
+    }
+    char alert[MAX_MESSAGE_LENGTH];
+    if (players[activePlayer]->points > table->startingPoints) {
+        sprintf(alert, "points %c %d\n", get_player_label(activePlayer),
+                players[activePlayer]->points - table->startingPoints);
+        alert_table(hall, table, alert, NO_PLAYER);
+    }
+    int remaining = 0;
+    for (int i = 0; i < hall->numberOfPlayers; i++) {
+        if (players[i]->status != ELIMINATED && players[i]->health < 1) {
+            sprintf(alert, "eliminated %c\n", get_player_label(i));
+            alert_table(hall, table, alert, NO_PLAYER);
+            set_player_status(i, ELIMINATED, game, players);
+        }
+        if (i != activePlayer && players[i]->status != ELIMINATED) {
+            remaining++;
+        }
+    }
+    if (remaining == 0 ||
+            players[activePlayer]->points >= hall->scoreLimit) {
+        sprintf(alert, "winner %c\n", get_player_label(activePlayer));
+        alert_table(hall, table, alert, NO_PLAYER);
+        close_table(hall, table, GAME_WON);
+        return;
+    }
+    do {
+        game->currentPlayerNumber = (game->currentPlayerNumber + 1) %
+                hall->numberOfPlayers;
+    } while (players[game->currentPlayerNumber]->status == ELIMINATED);
+    start_turn(hall, table);
+}
+
+/**
+* Alerts the players of the active player's final dice, heals the active
+* player and attacks. Asks the player in St Lucia whether to stay if it was
+* attacked, otherwise ends the turn.
+*   - hall, the tables of the hub
+*   - table, the table playing
+*   - policyRerolls, whether the hub played the active player's rerolls
+*/
+void finish_roll(Hall* hall, Table* table, bool policyRerolls) {
+    Game* game = &table->game;
+    Player** players = table->players;
+    int activePlayer = game->currentPlayerNumber;
+    char alert[MAX_MESSAGE_LENGTH];
+    create_dice_set_string(&table->dice);
+    sprintf(alert, "rolled %c %s\n", get_player_label(activePlayer),
+            table->dice.rollString);
+    alert_table(hall, table, alert, policyRerolls ? NO_PLAYER : activePlayer);
+
+    heal(activePlayer, game, players, false, table->dice.numberOfHs);
+    int damage = table->dice.numberOfAs;
+    if (damage == 0) {
+        end_turn(hall, table);
+        return;
+    }
+    if (game->playerInStLucia == EMPTY_STLUCIA) {
+        claim_table(hall, table);
+    } else if (game->playerInStLucia == activePlayer) {
+        for (int i = 0; i < hall->numberOfPlayers; i++) {
+            if (i != activePlayer && players[i]->status != ELIMINATED) {
+                damage_player(i, damage, game, players, false);
+            }
+        }
+        sprintf(alert, "attacks %c %d out\n", get_player_label(activePlayer),
+                damage);
+        alert_table(hall, table, alert, NO_PLAYER);
+    } else {
+        int holder = game->playerInStLucia;
+        damage_player(holder, damage, game, players, false);
+        sprintf(alert, "attacks %c %d in\n", get_player_label(activePlayer),
+                damage);
+        alert_table(hall, table, alert, NO_PLAYER);
+        Policy* policy = &table->processes[holder]->policy;
+        if (!policy->retreats) {
+            send_seat(hall, table, holder, "stay?\n");
+            table->state = TABLE_STAYING;
+            return;
+        }
+        if (players[holder]->health < policy->retreatHealthThreshold ||
+                players[holder]->health <= 0) {
+            claim_table(hall, table);
+        }
+    }
+    end_turn(hall, table);
+}
+
+/**
+* Rerolls the table's dice as the active player's policy decides.
+*   - hall, the tables of the hub
+*   - table, the table playing
+*/
+void play_policy_rerolls(Hall* hall, Table* table) {
+    Game* game = &table->game;
+    int activePlayer = game->currentPlayerNumber;
+    int holderHealth = STARTING_HEALTH + 1;
+    if (game->playerInStLucia != EMPTY_STLUCIA &&
+            game->playerInStLucia != activePlayer) {
+        holderHealth = table->players[game->playerInStLucia]->health;
+    }
+    for (int i = 0; i < POLICY_ALLOWED_REROLLS; i++) {
+        int counts[NUMBER_OF_FACES];
+        int reroll[NUMBER_OF_FACES];
+        count_table_dice(table, counts);
+        int diceToReroll = policy_reroll(
+                &table->processes[activePlayer]->policy,
+                table->players[activePlayer]->health,
+                game->playerInStLucia == activePlayer, holderHealth, counts,
+                reroll);
+        if (diceToReroll == 0) {
+            return;
+        }
+        for (int face = 0; face < NUMBER_OF_FACES; face++) {
+            for (int j = 0; j < reroll[face]; j++) {
+                remove_die_from_dice_set(&table->dice,
+                        get_face_character(face));
+            }
+        }
+        add_dice_to_dice_set(&table->rollFile, diceToReroll, &table->dice);
+    }
+}
+
+/**
+* Starts the active player's turn: rolls its dice, and either plays its
+* policy or sends it the roll. Draws the game once it reaches a state it has
+* already been in at the start of a turn, as the hub does.
+*   - hall, the tables of the hub
+*   - table, the table playing
+*/
+void start_turn(Hall* hall, Table* table) {
+    Game* game = &table->game;
+    int activePlayer = game->currentPlayerNumber;
+    if (is_repeated_state(&table->history, game, table->players,
+            activePlayer)) {
+        close_table(hall, table, GAME_DRAWN);
+        return;
+    }
+    table->turns++;
+    table->startingPoints = table->players[activePlayer]->points;
+    if (activePlayer == game->playerInStLucia) {
+        add_points(activePlayer, STARTING_IN_STLUCIA_POINTS, game,
+                table->players);
+    }
+    reset_dice_set(&table->dice);
+    add_dice_to_dice_set(&table->rollFile, DICE_SET_SIZE, &table->dice);
+    if (table->processes[activePlayer]->policy.rerolls) {
+        play_policy_rerolls(hall, table);
+        finish_roll(hall, table, true);
+        return;
+    }
+    char message[MAX_MESSAGE_LENGTH];
+    create_dice_set_string(&table->dice);
+    sprintf(message, "turn %s\n", table->dice.rollString);
+    send_seat(hall, table, activePlayer, message);
+    table->state = TABLE_ROLLING;
+}
+
+/**
+* Handles a "reroll" reply from the active player, sending it the new dice.
+* Returns false if it asks to reroll dice it does not have.
+*   - hall, the tables of the hub
+*   - table, the table playing
+*   - dice, the dice to reroll
+*/
+bool reroll_table_dice(Hall* hall, Table* table, char* dice) {
+    int counts[NUMBER_OF_FACES];
+    int reroll[NUMBER_OF_FACES] = {0};
+    int numberOfDice = (int)strlen(dice);
+    if (numberOfDice > DICE_SET_SIZE || invalid_roll(dice)) {
+        return false;
+    }
+    count_table_dice(table, counts);
+    for (int i = 0; i < numberOfDice; i++) {
+        int face = get_face_index(dice[i]);
+        if (++reroll[face] > counts[face]) {
+            return false;
+        }
+    }
+    for (int i = 0; i < numberOfDice; i++) {
+        remove_die_from_dice_set(&table->dice, dice[i]);
+    }
+    add_dice_to_dice_set(&table->rollFile, numberOfDice, &table->dice);
+    char message[MAX_MESSAGE_LENGTH];
+    create_dice_set_string(&table->dice);
+    sprintf(message, "rerolled %s\n", table->dice.rollString);
+    send_seat(hall, table, table->game.currentPlayerNumber, message);
+    return true;
+}
+
+/**
+* Handles a complete reply from the player the table is waiting for. Returns
+* false if the reply breaks the protocol, in which case the caller abandons
+* the game.
+*   - hall, the tables of the hub
+*   - table, the table of the seat
+*   - playerNumber, the seat's player
+*   - reply, the reply, without its newline
+*/
+bool handle_reply(Hall* hall, Table* table, int playerNumber, char* reply) {
+    char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH];
+    int numberCommands = interpret_message(reply, commands);
+    if (table->state == TABLE_ROLLING) {
+        if (strcmp(commands[0], "keepall") == 0 && numberCommands == 1) {
+            finish_roll(hall, table, false);
+            return true;
+        } else if (strcmp(commands[0], "reroll") == 0 &&
+                numberCommands == 2) {
+            return reroll_table_dice(hall, table,
+                    commands[REROLLED_DICE_ROLL_INDEX]);
+        }
+        return false;
+    }
+    bool stays = strcmp(commands[0], "stay") == 0 && numberCommands == 1;
+    bool goes = strcmp(commands[0], "go") == 0 && numberCommands == 1;
+    if (!stays && !goes) {
+        return false;
+    }
+    if (goes || table->players[playerNumber]->health <= 0) {
+        claim_table(hall, table);
+    }
+    end_turn(hall, table);
+    return true;
+}
+
+/**
+* Returns the seat the table is waiting to hear from, or NO_PLAYER.
+*   - table, the table
+*/
+int awaited_player(Table* table) {
+    if (table->state == TABLE_ROLLING) {
+        return table->game.currentPlayerNumber;
+    } else if (table->state == TABLE_STAYING) {
+        return table->game.playerInStLucia;
+    }
+    return NO_PLAYER;
+}
+
+/**
+* Stops sharing a seat's processes between tables, for a faculty that does
+* not play tables. Its pool is stopped and each table waiting for the seat
+* starts its own process instead, as if STLUCIA_POOL_PROCESSES were 0.
+*   - hall, the tables of the hub
+*   - playerNumber, the seat's player
+*/
+void unpool_seat(Hall* hall, int playerNumber) {
+    for (int slot = 0; slot < hall->processesPerSeat; slot++) {
+        stop_process(&hall->processes[playerNumber * hall->openTables + slot],
+                true);
+    }
+    hall->pooled[playerNumber] = false;
+    fprintf(stderr, "Player %c (%s) does not play tables, starting it for "
+            "each game\n", get_player_label(playerNumber),
+            hall->faculties[playerNumber]);
+    for (int t = 0; t < hall->openTables; t++) {
+        Table* table = &hall->tables[t];
+        if (table->state == TABLE_CLOSED) {
+            continue;
+        }
+        Process* process = seat_process(hall, playerNumber, t);
+        table->processes[playerNumber] = process;
+        if (!start_process(hall, process)) {
+            abandon_table(hall, table, process);
+        }
+    }
+}
+
+/**
+* Stops a process that has gone or broken the protocol, abandoning every
+* game it was still playing. Players that are not pooled exit once they are
+* eliminated, which is expected. A pooled process that goes before any of
+* its seat's pool has shaken hands is taken to be a faculty that does not
+* play tables, and its seat stops being pooled.
+*   - hall, the tables of the hub
+*   - process, the process
+*/
+void lose_process(Hall* hall, Process* process) {
+    int playerNumber = process->playerNumber;
+    if (hall->pooled[playerNumber] && !hall->shookHands[playerNumber]) {
+        unpool_seat(hall, playerNumber);
+        return;
+    }
+    stop_process(process, true);
+    for (int t = 0; t < hall->openTables; t++) {
+        Table* table = &hall->tables[t];
+        if (table->state != TABLE_CLOSED &&
+                table->processes[playerNumber] == process &&
+                table->players[playerNumber]->status != ELIMINATED) {
+            abandon_table(hall, table, process);
+        }
+    }
+}
+
+/**
+* Handles a process's handshake, '!' or '#' and its policy, then starts the
+* games waiting for it.
+*   - hall, the tables of the hub
+*   - process, the process
+*/
+void connect_process(Hall* hall, Process* process) {
+    process->connected = true;
+    for (int t = 0; t < hall->openTables; t++) {
+        Table* table = &hall->tables[t];
+        if (table->state == TABLE_STARTING &&
+                table->processes[process->playerNumber] == process) {
+            start_table(hall, table);
+        }
+    }
+}
+
+/**
+* Handles a complete line from a process: a policy, or a reply for the game
+* of the table it is tagged with when pooled. Returns false if the line
+* breaks the protocol in a way no single game can be blamed for.
+*   - hall, the tables of the hub
+*   - process, the process
+*   - line, the line, without its newline
+*/
+bool handle_line(Hall* hall, Process* process, char* line) {
+    char commands[MAX_COMMANDS][MAX_MESSAGE_LENGTH];
+    int numberCommands = interpret_message(line, commands);
+    if (process->awaitingPolicy || strcmp(commands[0], "policy") == 0) {
+        if (!parse_policy(commands, numberCommands, &process->policy)) {
+            return false;
+        }
+        if (process->awaitingPolicy) {
+            process->awaitingPolicy = false;
+            connect_process(hall, process);
+        }
+        return true;
+    }
+    if (!process->connected) {
+        return false;
+    }
+    int tableNumber = (int)(process - hall->processes) % hall->openTables;
+    if (hall->pooled[process->playerNumber]) {
+        char* tagEnd;
+        tableNumber = (int)strtol(line + 1, &tagEnd, 
+                BASE_FOR_INTEGER_CONVERSION);
+        if (line[0] != TABLE_TAG || tagEnd == line + 1 || *tagEnd != ' ' ||
+                tableNumber < 0 || tableNumber >= hall->openTables) {
+            return false;
+        }
+        line = tagEnd + 1;
+    }
+    Table* table = &hall->tables[tableNumber];
+    if (table->processes[process->playerNumber] != process) {
+        return false;
+    }
+    if (awaited_player(table) != process->playerNumber ||
+            !handle_reply(hall, table, process->playerNumber, line)) {
+        if (table->state != TABLE_CLOSED) {
+            abandon_table(hall, table, process);
+        }
+    }
+    return true;
+}
+
+/**
+* Reads what a process has sent and handles each complete line. Loses the
+* process if it has gone or breaks the protocol.
+*   - hall, the tables of the hub
+*   - process, the process
+*/
+void read_process(Hall* hall, Process* process) {
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(process->outbox, process->reply + process->length,
+                MAX_MESSAGE_LENGTH - 1 - process->length);
+    } while (bytesRead < 0 && errno == EINTR);
+    if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+    }
+    if (bytesRead <= 0) {
+        lose_process(hall, process);
+        return;
+    }
+    process->length += (int)bytesRead;
+    process->reply[process->length] = '\0';
+    while (process->outbox >= 0 && process->length > 0) {
+        if (!process->connected && !process->awaitingPolicy) {
+            if (process->reply[0] == POLICY_HANDSHAKE) {
+                process->awaitingPolicy = true;
+            } else if (process->reply[0] == '!') {
+                connect_process(hall, process);
+            } else {
+                lose_process(hall, process);
+                return;
+            }
+            hall->shookHands[process->playerNumber] = true;
+            memmove(process->reply, process->reply + 1, process->length--);
+            continue;
+        }
+        char* newline = strchr(process->reply, '\n');
+        if (newline == NULL) {
+            if (process->length == MAX_MESSAGE_LENGTH - 1) {
+                lose_process(hall, process);
+            }
+            return;
+        }
+        *newline = '\0';
+        char line[MAX_MESSAGE_LENGTH];
+        strcpy(line, process->reply);
+        process->length -= (int)(newline - process->reply) + 1;
+        memmove(process->reply, newline + 1, process->length + 1);
+        if (!handle_line(hall, process, line)) {
+            lose_process(hall, process);
+            return;
+        }
+    }
+}
+
+/**
+* Sets up a table before its first game, with its players, its own place in
+* the roll file every table shares, and its dice.
+*   - hall, the tables of the hub
+*   - table, the table
+*   - number, the number of the table
+*/
+void set_table(Hall* hall, Table* table, int number) {
+    table->number = number;
+    table->state = TABLE_CLOSED;
+    table->players = hall->tablePlayers + number * hall->numberOfPlayers;
+    table->processes = hall->tableProcesses + number * hall->numberOfPlayers;
+    for (int i = 0; i < hall->numberOfPlayers; i++) {
+        table->players[i] = &hall->players[number * hall->numberOfPlayers + i];
+    }
+    table->game.numberOfPlayers = hall->numberOfPlayers;
+    table->game.scoreLimit = hall->scoreLimit;
+    table->game.playerInStLucia = EMPTY_STLUCIA;
+    table->game.rollFile = &table->rollFile;
+    table->rollFile.size = hall->rollFileSize;
+    table->rollFile.packedRolls = hall->packedRolls;
+    table->rollFile.windowStart = -1;
+    table->rollFile.latestDice = &table->dice;
+    table->dice.rollString = table->rollString;
+}
+
+/**
+* Plays every game, keeping each table busy until all games have started,
+* and waits on every player process at once.
+*   - hall, the tables of the hub
+*/
+void run_tables(Hall* hall) {
+    int numberOfProcesses = hall->numberOfPlayers * hall->openTables;
+    while (hall->finished < hall->games) {
+        for (int t = 0; t < hall->openTables; t++) {
+            Table* table = &hall->tables[t];
+            while (table->state == TABLE_CLOSED &&
+                    hall->nextGame < hall->games) {
+                open_table(hall, table);
+            }
+        }
+        if (hall->finished == hall->games) {
+            return;
+        }
+        for (int p = 0; p < numberOfProcesses; p++) {
+            hall->polls[p].fd = hall->processes[p].outbox;
+            hall->polls[p].events = POLLIN;
+            hall->polls[p].revents = 0;
+        }
+        if (poll(hall->polls, numberOfProcesses, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        for (int p = 0; p < numberOfProcesses; p++) {
+            if (hall->polls[p].revents != 0 &&
+                    hall->processes[p].outbox >= 0) {
+                read_process(hall, &hall->processes[p]);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    struct sigaction sigpipe;
+    memset(&sigpipe, 0, sizeof(sigpipe));
+    sigpipe.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sigpipe, 0);
+
+    //players are reaped automatically as they exit
+    struct sigaction sigchld;
+    memset(&sigchld, 0, sizeof(sigchld));
+    sigchld.sa_handler = SIG_IGN;
+    sigchld.sa_flags = SA_NOCLDWAIT;
+    sigaction(SIGCHLD, &sigchld, 0);
+
+    //pinned before any memory or player is created, which follow
+    pin_to_core_set();
+
+    if (argc < TABLES_MIN_ARGS || argc > TABLES_MAX_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    Hall hall;
+    memset(&hall, 0, sizeof(hall));
+    hall.scoreLimit = atoi(argv[TABLES_SCORE_LIMIT_ARGUMENT_INDEX]);
+    if (hall.scoreLimit <= 0) {
+        exit_program(INVALID_SCORE);
+    }
+    hall.games = atoi(argv[TABLES_GAMES_ARGUMENT_INDEX]);
+    if (hall.games <= 0) {
+        exit_program(INVALID_GAMES);
+    }
+    hall.firstGame = integer_setting(FIRST_GAME_VARIABLE, 0, 0, INT_MAX);
+    hall.numberOfPlayers = argc - TABLES_ARGUMENTS_NOT_PLAYERS;
+    hall.faculties = argv + TABLES_ARGUMENTS_NOT_PLAYERS;
+    hall.rollFileSize = read_packed_roll_file(
+            argv[TABLES_ROLL_FILE_ARGUMENT_INDEX], &hall.packedRolls);
+    if (hall.rollFileSize < 0) {
+        exit_program(OPEN_ERROR);
+    } else if (hall.rollFileSize == 0) {
+        exit_program(INVALID_FILE);
+    }
+
+    hall.openTables = integer_setting(OPEN_TABLES_VARIABLE,
+            DEFAULT_OPEN_TABLES, 1, MAX_OPEN_TABLES);
+    if (hall.openTables > hall.games) {
+        hall.openTables = hall.games;
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    hall.processesPerSeat = integer_setting(POOL_PROCESSES_VARIABLE,
+            DEFAULT_POOL_PROCESSES_PER_CORE * (int)(cores > 0 ? cores : 1), 0,
+            INT_MAX);
+    for (int i = 0; i < hall.numberOfPlayers; i++) {
+        hall.pooled[i] = hall.processesPerSeat > 0;
+    }
+    if (hall.processesPerSeat <= 0 ||
+            hall.processesPerSeat > hall.openTables) {
+        hall.processesPerSeat = hall.openTables;
+    }
+    int numberOfProcesses = hall.numberOfPlayers * hall.openTables;
+    hall.tables = calloc(hall.openTables, sizeof(Table));
+    hall.players = calloc(numberOfProcesses, sizeof(Player));
+    hall.tablePlayers = calloc(numberOfProcesses, sizeof(Player*));
+    hall.tableProcesses = calloc(numberOfProcesses, sizeof(Process*));
+    hall.processes = calloc(numberOfProcesses, sizeof(Process));
+    hall.polls = calloc(numberOfProcesses, sizeof(struct pollfd));
+    if (hall.tables == NULL || hall.players == NULL ||
+            hall.tablePlayers == NULL || hall.tableProcesses == NULL ||
+            hall.processes == NULL || hall.polls == NULL) {
+        exit_program(MEMORY_FAILURE);
+    }
+    for (int t = 0; t < hall.openTables; t++) {
+        set_table(&hall, &hall.tables[t], t);
+    }
+    for (int p = 0; p < numberOfProcesses; p++) {
+        Process* process = &hall.processes[p];
+        process->playerNumber = p / hall.openTables;
+        process->inbox = process->outbox = -1;
+        if (hall.pooled[process->playerNumber] &&
+                p % hall.openTables < hall.processesPerSeat) {
+            start_process(&hall, process);
+        }
+    }
+
+    double start = current_time();
+    run_tables(&hall);
+    double elapsed = current_time() - start;
+    for (int p = 0; p < numberOfProcesses; p++) {
+        send_process(&hall.processes[p], "shutdown\n");
+        stop_process(&hall.processes[p], false);
+    }
+
+    for (int i = 0; i < hall.numberOfPlayers; i++) {
+        printf("Player %c (%s) won %d\n", get_player_label(i),
+                hall.faculties[i], hall.wins[i]);
+    }
+    printf("Drawn %d\n", hall.draws);
+    printf("Abandoned %d\n", hall.abandoned);
+    for (int p = 0; p < numberOfProcesses; p++) {
+        Process* process = &hall.processes[p];
+        if (process->abandoned > 0 || process->restarts > 0) {
+            printf("Player %c process %d abandoned %d, restarted %d\n",
+                    get_player_label(process->playerNumber),
+                    p % hall.openTables, process->abandoned,
+                    process->restarts);
+        }
+    }
+    printf("Played %d games, %lld turns in %.3fs (%.0f games/s)\n",
+            hall.games, hall.turns, elapsed,
+            elapsed > 0 ? hall.games / elapsed : 0.0);
+    for (int t = 0; t < hall.openTables; t++) {
+        free_state_history(&hall.tables[t].history);
+    }
+    free(hall.tables);
+    free(hall.players);
+    free(hall.tablePlayers);
+    free(hall.tableProcesses);
+    free(hall.processes);
+    free(hall.polls);
+    free(hall.packedRolls);
+    exit_program(SUCCESS);
+    return 0;
+}
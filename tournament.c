@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "tournament.h"
+
+/* The number of connections a listening socket holds before accepting */
+#define LISTEN_BACKLOG 64
+
+/**
+* Starts buffering lines from the specified file descriptor.
+*   - connection, the connection
+*   - fd, the socket or pipe to read and write
+*/
+void open_connection(Connection* connection, int fd) {
+    connection->fd = fd;
+    connection->length = 0;
+    connection->buffer[0] = '\0';
+}
+
+/**
+* Closes the connection's file descriptor, discarding anything buffered.
+*   - connection, the connection
+*/
+void close_connection(Connection* connection) {
+    if (connection->fd >= 0) {
+        close(connection->fd);
+    }
+    connection->fd = -1;
+    connection->length = 0;
+}
+
+/**
+* Reads whatever is available into the connection's buffer. Returns false
+* if the other end has closed or failed, or has sent a line too long to
+* buffer.
+*   - connection, the connection
+*/
+bool fill_connection(Connection* connection) {
+    if (connection->length == TOURNAMENT_LINE_LENGTH - 1) {
+        return false;
+    }
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(connection->fd,
+                connection->buffer + connection->length,
+                TOURNAMENT_LINE_LENGTH - 1 - connection->length);
+    } while (bytesRead < 0 && errno == EINTR);
+    if (bytesRead <= 0) {
+        return false;
+    }
+    connection->length += (int)bytesRead;
+    connection->buffer[connection->length] = '\0';
+    return true;
+}
+
+/**
+* Removes the first complete line from the connection's buffer. Returns
+* false if no complete line has been read.
+*   - connection, the connection
+*   - line, where to store the line without its newline, at least
+*       TOURNAMENT_LINE_LENGTH bytes
+*/
+bool next_line(Connection* connection, char* line) {
+    char* newline = memchr(connection->buffer, '\n', connection->length);
+    if (newline == NULL) {
+        return false;
+    }
+    int lineLength = (int)(newline - connection->buffer);
+    memcpy(line, connection->buffer, lineLength);
+    line[lineLength] = '\0';
+    connection->length -= lineLength + 1;
+    memmove(connection->buffer, newline + 1, connection->length + 1);
+    return true;
+}
+
+/**
+* Writes a formatted line to the connection, adding the newline. Returns
+* false if the other end has gone or the line is too long.
+*   - connection, the connection
+*   - format, the printf format of the line
+*/
+bool send_line(Connection* connection, const char* format, ...) {
+    if (connection->fd < 0) {
+        return false;
+    }
+    char line[TOURNAMENT_LINE_LENGTH];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(line, TOURNAMENT_LINE_LENGTH - 1, format,
+            arguments);
+    va_end(arguments);
+    if (length < 0 || length >= TOURNAMENT_LINE_LENGTH - 1) {
+        return false;
+    }
+    line[length++] = '\n';
+    int written = 0;
+    while (written < length) {
+        ssize_t bytesWritten = send(connection->fd, line + written,
+                length - written, MSG_NOSIGNAL);
+        if (bytesWritten < 0 && errno == ENOTSOCK) {
+            bytesWritten = write(connection->fd, line + written,
+                    length - written);
+        }
+        if (bytesWritten < 0 && errno == EINTR) {
+            continue;
+        } else if (bytesWritten <= 0) {
+            return false;
+        }
+        written += (int)bytesWritten;
+    }
+    return true;
+}
+
+/**
+* Returns a socket listening on the specified TCP port of every local
+* address, or -1 if it cannot be opened.
+*   - port, the port number or service name, "0" for any free port
+*/
+int listen_on(const char* port) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    struct addrinfo* addresses;
+    if (getaddrinfo(NULL, port, &hints, &addresses) != 0) {
+        return -1;
+    }
+    int listener = -1;
+    for (struct addrinfo* address = addresses; address != NULL;
+            address = address->ai_next) {
+        listener = socket(address->ai_family,
+                address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (listener < 0) {
+            continue;
+        }
+        int enable = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable,
+                sizeof(enable));
+        if (bind(listener, address->ai_addr, address->ai_addrlen) == 0 &&
+                listen(listener, LISTEN_BACKLOG) == 0) {
+            break;
+        }
+        close(listener);
+        listener = -1;
+    }
+    freeaddrinfo(addresses);
+    return listener;
+}
+
+/**
+* Returns a socket connected to the specified TCP port of a host, or -1 if
+* no address of the host accepts the connection.
+*   - host, the host name or address
+*   - port, the port number or service name
+*/
+int connect_to(const char* host, const char* port) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses;
+    if (getaddrinfo(host, port, &hints, &addresses) != 0) {
+        return -1;
+    }
+    int connection = -1;
+    for (struct addrinfo* address = addresses; address != NULL;
+            address = address->ai_next) {
+        connection = socket(address->ai_family,
+                address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (connection < 0) {
+            continue;
+        }
+        if (connect(connection, address->ai_addr, address->ai_addrlen) == 0) {
+            break;
+        }
+        close(connection);
+        connection = -1;
+    }
+    freeaddrinfo(addresses);
+    return connection;
+}
@@ -0,0 +1,40 @@
+#include <stdbool.h>
+
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+/* The longest line sent between the coordinator and its workers */
+#define TOURNAMENT_LINE_LENGTH 4096
+
+/* The lines of the tournament protocol */
+#define JOB_MESSAGE "job"
+#define BATCH_MESSAGE "batch"
+#define STEAL_MESSAGE "steal"
+#define STOLEN_MESSAGE "stolen"
+#define KEPT_MESSAGE "kept"
+#define GAME_MESSAGE "Game"
+#define DONE_MESSAGE "done"
+#define FAILED_MESSAGE "failed"
+#define SHUTDOWN_MESSAGE "shutdown"
+
+/**
+* A struct for one end of a line based stream, a socket or a pipe.
+*   - fd, the file descriptor, or -1 once closed
+*   - length, the number of bytes of incomplete lines buffered
+*   - buffer, the buffered bytes
+*/
+typedef struct {
+    int fd;
+    int length;
+    char buffer[TOURNAMENT_LINE_LENGTH];
+} Connection;
+
+/* Function prototypes */
+void open_connection(Connection* connection, int fd);
+void close_connection(Connection* connection);
+bool fill_connection(Connection* connection);
+bool next_line(Connection* connection, char* line);
+bool send_line(Connection* connection, const char* format, ...);
+int listen_on(const char* port);
+int connect_to(const char* host, const char* port);
+#endif
@@ -0,0 +1,375 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "shared.h"
+#include "uring.h"
+
+/* The submission queue holds a write to every player and one read */
+#define RING_ENTRIES (2 * MAX_PLAYERS)
+
+/* Completions carry the player and whether they were a write or a read */
+#define RING_OPERATIONS 2
+#define RING_WRITE 0
+#define RING_READ 1
+
+/* The opcodes the kernel is probed for, more than any kernel has */
+#define RING_PROBE_OPERATIONS 256
+
+/**
+* A struct for the ring shared with the kernel, mapped from its io_uring.
+*   - fd, the io_uring, or -1 if it is not open
+*   - sqHead, sqTail, sqMask, sqArray, the submission queue's fields
+*   - sqes, the submission queue entries
+*   - cqHead, cqTail, cqMask, the completion queue's fields
+*   - cqes, the completion queue entries
+*/
+typedef struct {
+    int fd;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    struct io_uring_cqe* cqes;
+} Ring;
+
+/**
+* A struct for a player's side of the ring. Messages to the player are
+* gathered into one write, and its replies are read ahead into a buffer.
+*   - writeFd, the player's input
+*   - readFd, the player's output
+*   - pending, the messages not yet written
+*   - pendingLength, the number of bytes in pending
+*   - written, the number of those bytes already written
+*   - input, the bytes read from the player and not yet returned
+*   - inputStart, the first byte of input not yet returned
+*   - inputLength, the number of bytes of input after inputStart
+*   - closed, whether the player's output has ended or failed
+*/
+typedef struct {
+    int writeFd;
+    int readFd;
+    char pending[URING_PENDING_BYTES];
+    int pendingLength;
+    int written;
+    char input[URING_INPUT_BYTES];
+    int inputStart;
+    int inputLength;
+    bool closed;
+} RingPlayer;
+
+/* The hub's ring, and the state of each player on it */
+Ring ring = {.fd = -1};
+RingPlayer ringPlayers[MAX_PLAYERS];
+
+/**
+* Returns true if the kernel supports the reads and writes the hub submits.
+* io_uring arrived in Linux 5.1 but IORING_OP_READ and IORING_OP_WRITE only
+* in 5.6, as did the probe, so a kernel in between fails the probe.
+*   - fd, the io_uring
+*/
+bool ring_supports_operations(int fd) {
+    struct io_uring_probe* probe = calloc(1, sizeof(struct io_uring_probe) +
+            RING_PROBE_OPERATIONS * sizeof(struct io_uring_probe_op));
+    bool supported = probe != NULL && syscall(__NR_io_uring_register, fd,
+            IORING_REGISTER_PROBE, probe, RING_PROBE_OPERATIONS) == 0 &&
+            probe->last_op >= IORING_OP_READ &&
+            probe->last_op >= IORING_OP_WRITE &&
+            (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+            (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return supported;
+}
+
+/**
+* Opens the io_uring the hub exchanges messages with its players through.
+* Returns false if the kernel does not provide io_uring or its reads and
+* writes, in which case the hub keeps using stdio.
+*/
+bool open_player_ring(void) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    if (fd < 0) {
+        return false;
+    } else if (!ring_supports_operations(fd)) {
+        close(fd);
+        return false;
+    }
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes +
+            params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap && cqSize > sqSize) {
+        sqSize = cqSize;
+    }
+    char* sq = mmap(NULL, sqSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    char* cq = sq;
+    if (sq != MAP_FAILED && !singleMap) {
+        cq = mmap(NULL, cqSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    }
+    void* sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe),
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+            IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    ring.sqHead = (unsigned*)(sq + params.sq_off.head);
+    ring.sqTail = (unsigned*)(sq + params.sq_off.tail);
+    ring.sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring.sqArray = (unsigned*)(sq + params.sq_off.array);
+    ring.sqes = sqes;
+    ring.cqHead = (unsigned*)(cq + params.cq_off.head);
+    ring.cqTail = (unsigned*)(cq + params.cq_off.tail);
+    ring.cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring.fd = fd;
+    return true;
+}
+
+/**
+* Exchanges a player's messages through the ring from now on.
+*   - playerNumber, the player
+*   - writeFd, the player's input
+*   - readFd, the player's output
+*/
+void attach_ring_player(int playerNumber, int writeFd, int readFd) {
+    RingPlayer* player = &ringPlayers[playerNumber];
+    player->writeFd = writeFd;
+    player->readFd = readFd;
+    player->pendingLength = 0;
+    player->written = 0;
+    player->inputStart = 0;
+    player->inputLength = 0;
+    player->closed = false;
+}
+
+/**
+* Adds an operation to the submission queue, to be submitted by the next
+* io_uring_enter().
+*   - opcode, IORING_OP_WRITE or IORING_OP_READ
+*   - fd, the file descriptor
+*   - buffer, the bytes to write or where to read to
+*   - length, the number of bytes
+*   - userData, the player number and RING_WRITE or RING_READ
+*/
+void prepare_operation(int opcode, int fd, void* buffer, unsigned length,
+        unsigned long long userData) {
+    unsigned tail = *ring.sqTail;
+    unsigned index = tail & *ring.sqMask;
+    struct io_uring_sqe* sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (unsigned char)opcode;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long)(size_t)buffer;
+    sqe->len = length;
+    sqe->off = (unsigned long long)-1;
+    sqe->user_data = userData;
+    ring.sqArray[index] = index;
+    __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+* Queues the write of a player's pending messages, if any. Returns the number
+* of operations queued.
+*   - playerNumber, the player
+*/
+int prepare_write(int playerNumber) {
+    RingPlayer* player = &ringPlayers[playerNumber];
+    if (player->written == player->pendingLength) {
+        return 0;
+    }
+    prepare_operation(IORING_OP_WRITE, player->writeFd,
+            player->pending + player->written,
+            player->pendingLength - player->written,
+            playerNumber * RING_OPERATIONS + RING_WRITE);
+    return 1;
+}
+
+/**
+* Handles a completed write. A short write is queued again from where it
+* stopped, and a failed one is dropped as a failed fprintf() would be.
+* Returns the number of operations queued.
+*   - playerNumber, the player
+*   - result, the result of the write
+*/
+int complete_write(int playerNumber, int result) {
+    RingPlayer* player = &ringPlayers[playerNumber];
+    if (result > 0) {
+        player->written += result;
+    } else if (result != -EINTR && result != -EAGAIN) {
+        player->written = player->pendingLength;
+    }
+    if (player->written < player->pendingLength) {
+        return prepare_write(playerNumber);
+    }
+    player->pendingLength = 0;
+    player->written = 0;
+    return 0;
+}
+
+/**
+* Queues a read of a player's replies after those already buffered.
+*   - playerNumber, the player
+*/
+void prepare_read(int playerNumber) {
+    RingPlayer* player = &ringPlayers[playerNumber];
+    memmove(player->input, player->input + player->inputStart,
+            player->inputLength);
+    player->inputStart = 0;
+    prepare_operation(IORING_OP_READ, player->readFd,
+            player->input + player->inputLength,
+            URING_INPUT_BYTES - player->inputLength,
+            playerNumber * RING_OPERATIONS + RING_READ);
+}
+
+/**
+* Handles a completed read. Returns the number of operations queued again.
+*   - playerNumber, the player
+*   - result, the result of the read
+*/
+int complete_read(int playerNumber, int result) {
+    RingPlayer* player = &ringPlayers[playerNumber];
+    if (result > 0) {
+        player->inputLength += result;
+    } else if (result == -EINTR || result == -EAGAIN) {
+        prepare_read(playerNumber);
+        return 1;
+    } else {
+        player->closed = true;
+    }
+    return 0;
+}
+
+/**
+* Writes every player's pending messages and, if a reader is given, reads
+* that player's next replies, submitting them all with one io_uring_enter()
+* and waiting for every one to complete.
+*   - reader, the player to read from, or -1 to only write
+*/
+void exchange_messages(int reader) {
+    if (ring.fd < 0) {
+        return;
+    }
+    int outstanding = 0;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        outstanding += prepare_write(i);
+    }
+    if (reader >= 0) {
+        prepare_read(reader);
+        outstanding++;
+    }
+    while (outstanding > 0) {
+        unsigned toSubmit = *ring.sqTail -
+                __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+        if (syscall(__NR_io_uring_enter, ring.fd, toSubmit, outstanding,
+                IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR) {
+            //the ring has failed, so the exchange fails like a closed pipe
+            for (int i = 0; i < MAX_PLAYERS; i++) {
+                ringPlayers[i].pendingLength = 0;
+                ringPlayers[i].written = 0;
+            }
+            if (reader >= 0) {
+                ringPlayers[reader].closed = true;
+            }
+            return;
+        }
+        unsigned head = *ring.cqHead;
+        while (head != __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cqMask];
+            int playerNumber = (int)(cqe->user_data / RING_OPERATIONS);
+            outstanding--;
+            if (cqe->user_data % RING_OPERATIONS == RING_WRITE) {
+                outstanding += complete_write(playerNumber, cqe->res);
+            } else {
+                outstanding += complete_read(playerNumber, cqe->res);
+            }
+            head++;
+        }
+        __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+* Queues a message to a player, to be written with the hub's next exchange.
+*   - playerNumber, the player
+*   - message, the message
+*   - length, the number of bytes of the message
+*/
+void queue_ring_message(int playerNumber, const char* message,
+        size_t length) {
+    RingPlayer* player = &ringPlayers[playerNumber];
+    if (player->pendingLength + length > URING_PENDING_BYTES) {
+        exchange_messages(-1);
+    }
+    memcpy(player->pending + player->pendingLength, message, length);
+    player->pendingLength += length;
+}
+
+/**
+* Writes every player's pending messages.
+*/
+void flush_ring(void) {
+    exchange_messages(-1);
+}
+
+/**
+* Moves the next line of a player's buffered replies into line as fgets()
+* would: up to and including a newline, at most size - 1 bytes, or what is
+* left once the player's output has ended. Returns false if there is no
+* such line yet.
+*   - player, the player
+*   - line, where to store the line
+*   - size, the size of line
+*/
+bool take_buffered_line(RingPlayer* player, char* line, int size) {
+    char* start = player->input + player->inputStart;
+    int length = player->inputLength < size - 1 ? player->inputLength :
+            size - 1;
+    char* newline = memchr(start, '\n', length);
+    if (newline != NULL) {
+        length = (int)(newline - start) + 1;
+    } else if (length < size - 1 && !player->closed) {
+        return false;
+    }
+    if (length == 0) {
+        return false;
+    }
+    memcpy(line, start, length);
+    line[length] = '\0';
+    player->inputStart += length;
+    player->inputLength -= length;
+    return true;
+}
+
+/**
+* Reads a player's next reply into line as fgets() would, sending every
+* player's pending messages with the read. Returns false if the player's
+* output has ended with nothing left to read.
+*   - playerNumber, the player
+*   - line, where to store the reply
+*   - size, the size of line
+*/
+bool read_ring_line(int playerNumber, char* line, int size) {
+    RingPlayer* player = &ringPlayers[playerNumber];
+    while (!take_buffered_line(player, line, size)) {
+        if (player->closed) {
+            return false;
+        }
+        exchange_messages(playerNumber);
+    }
+    return true;
+}
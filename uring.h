@@ -0,0 +1,22 @@
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef URING_H
+#define URING_H
+
+/* The hub exchanges messages with its players through io_uring when this
+variable is set and every player has a pipe or socket */
+#define URING_VARIABLE "STLUCIA_URING"
+
+/* The bytes queued for a player before they must be written, at most the
+size of an atomic pipe write, and the bytes of replies buffered per player */
+#define URING_PENDING_BYTES 4096
+#define URING_INPUT_BYTES 4096
+
+/* Function prototypes */
+bool open_player_ring(void);
+void attach_ring_player(int playerNumber, int writeFd, int readFd);
+void queue_ring_message(int playerNumber, const char* message, size_t length);
+void flush_ring(void);
+bool read_ring_line(int playerNumber, char* line, int size);
+#endif
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "shared.h"
+#include "spectate.h"
+
+/* Argument information for the spectator */
+#define WATCH_ARGS 2
+#define WATCH_RING_ARGUMENT_INDEX 1
+
+/* How long to sleep when every published event has been read */
+#define WATCH_IDLE_NANOSECONDS 1000000
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, never returned, as the spectator runs until interrupted
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - NO_RING, the ring does not exist or is not a spectator ring
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    NO_RING = 2
+} ExitCodes;
+
+/**
+* Exits the program with the specified exit status. Prints the corresponding
+* error message to stderr.
+*   - exitStatus, the exit status
+*/
+void exit_program(ExitCodes exitStatus) {
+    const char* errorString;
+    switch (exitStatus) {
+        case SUCCESS:
+            exit(SUCCESS);
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-watch ring";
+            break;
+        case NO_RING:
+            errorString = "Unable to open ring";
+            break;
+    }
+    fprintf(stderr, "%s\n", errorString);
+    exit(exitStatus);
+}
+
+/**
+* Prints every event published to the ring from now on. When the hub laps
+* the spectator, the events lost are counted and it carries on half a ring
+* behind the hub.
+*   - ring, the ring
+*/
+void watch_ring(const SpectatorRing* ring) {
+    struct timespec idle = {0, WATCH_IDLE_NANOSECONDS};
+    unsigned long long position = __atomic_load_n(&ring->head,
+            __ATOMIC_SEQ_CST);
+    char event[MAX_MESSAGE_LENGTH];
+    while (true) {
+        EventStatus status = read_event(ring, position, event);
+        if (status == EVENT_READ) {
+            fputs(event, stdout);
+            position++;
+        } else if (status == EVENT_PENDING) {
+            fflush(stdout);
+            nanosleep(&idle, NULL);
+        } else {
+            unsigned long long head = __atomic_load_n(&ring->head,
+                    __ATOMIC_SEQ_CST);
+            unsigned long long resume = head > SPECTATOR_SLOTS / 2 ?
+                    head - SPECTATOR_SLOTS / 2 : 0;
+            printf("lapped %llu\n", resume - position);
+            position = resume;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != WATCH_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    const SpectatorRing* ring = watch_spectator_ring(
+            argv[WATCH_RING_ARGUMENT_INDEX]);
+    if (ring == NULL) {
+        exit_program(NO_RING);
+    }
+    watch_ring(ring);
+    return 0;
+}
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include "shared.h"
+#include "tournament.h"
+
+/* Argument information for the tournament worker */
+#define WORKER_MIN_ARGS 3
+#define WORKER_MAX_ARGS 4
+#define WORKER_HOST_ARGUMENT_INDEX 1
+#define WORKER_PORT_ARGUMENT_INDEX 2
+#define WORKER_TABLES_ARGUMENT_INDEX 3
+#define DEFAULT_TABLES_PROGRAM "stlucia-tables"
+
+/* The most batches queued at a worker */
+#define MAX_QUEUED_BATCHES 64
+
+/* The arguments of stlucia-tables: the program, rollfile, winscore, games,
+the players and the terminating NULL */
+#define TABLES_ARGUMENTS_NOT_PLAYERS 4
+#define MAX_TABLES_ARGUMENTS (TABLES_ARGUMENTS_NOT_PLAYERS + MAX_PLAYERS + 1)
+#define MAX_NUMBER_STRING_SIZE 12
+
+/* Constants used in generating pipes */
+#define PIPE_SIZE 2
+#define PIPE_INPUT 1
+#define PIPE_OUTPUT 0
+
+/**
+* An enum for the different exit codes
+*   - SUCCESS, the coordinator shut the worker down
+*   - INVALID_ARGUMENTS, wrong number of arguments
+*   - CONNECT_ERROR, unable to connect to the coordinator
+*   - COORDINATOR_LOST, the coordinator went away before shutting down
+*   - INVALID_MESSAGE, the coordinator sent an invalid message
+*/
+typedef enum {
+    SUCCESS = 0,
+    INVALID_ARGUMENTS = 1,
+    CONNECT_ERROR = 2,
+    COORDINATOR_LOST = 3,
+    INVALID_MESSAGE = 4
+} ExitCodes;
+
+/**
+* A struct for a batch of consecutive games.
+*   - number, the coordinator's number for the batch
+*   - first, the number of the first game
+*   - count, the number of games
+*/
+typedef struct {
+    int number;
+    int first;
+    int count;
+} WorkerBatch;
+
+/**
+* A struct for the state of the worker.
+*   - coordinator, the connection to the coordinator
+*   - arguments, the arguments stlucia-tables is run with
+*   - job, the job line the arguments point into
+*   - games, the games argument of the running batch
+*   - queued, the batches waiting to be played, in order
+*   - numberQueued, the number of those batches
+*   - running, the batch being played, valid while pid is positive
+*   - pid, the pid of stlucia-tables, or -1 if no batch is being played
+*   - results, the standard output of stlucia-tables
+*   - turns, the number of turns stlucia-tables reported
+*/
+typedef struct {
+    Connection coordinator;
+    char* arguments[MAX_TABLES_ARGUMENTS];
+    char job[TOURNAMENT_LINE_LENGTH];
+    char games[MAX_NUMBER_STRING_SIZE];
+    WorkerBatch queued[MAX_QUEUED_BATCHES];
+    int numberQueued;
+    WorkerBatch running;
+    pid_t pid;
+    Connection results;
+    long long turns;
+} WorkerState;
+
+/**
+* Exits the program with the specified exit status. Prints the corresponding
+* error message to stderr.
+*   - exitStatus, the exit status
+*/
+void exit_program(ExitCodes exitStatus) {
+    const char* errorString;
+    switch (exitStatus) {
+        case SUCCESS:
+            exit(SUCCESS);
+        case INVALID_ARGUMENTS:
+            errorString = "Usage: stlucia-worker host port [tablesprogram]";
+            break;
+        case CONNECT_ERROR:
+            errorString = "Unable to connect to coordinator";
+            break;
+        case COORDINATOR_LOST:
+            errorString = "Coordinator lost";
+            break;
+        case INVALID_MESSAGE:
+            errorString = "Invalid message from coordinator";
+            break;
+    }
+    fprintf(stderr, "%s\n", errorString);
+    exit(exitStatus);
+}
+
+/**
+* Stops the running batch, if any, and exits.
+*   - state, the worker
+*   - exitStatus, the exit status
+*/
+void stop_worker(WorkerState* state, ExitCodes exitStatus) {
+    if (state->pid > 0) {
+        kill(state->pid, SIGKILL);
+        waitpid(state->pid, NULL, 0);
+    }
+    exit_program(exitStatus);
+}
+
+/**
+* Splits the job line into the arguments of stlucia-tables. Returns false
+* if the line is not a valid job.
+*   - state, the worker
+*   - line, the job line
+*/
+bool read_job(WorkerState* state, char* line) {
+    strcpy(state->job, line);
+    char* token = strtok(state->job, " ");
+    if (token == NULL || strcmp(token, JOB_MESSAGE) != 0) {
+        return false;
+    }
+    char* scoreLimit = strtok(NULL, " ");
+    char* rollFile = strtok(NULL, " ");
+    if (scoreLimit == NULL || rollFile == NULL) {
+        return false;
+    }
+    state->arguments[1] = rollFile;
+    state->arguments[2] = scoreLimit;
+    state->arguments[3] = state->games;
+    int argument = TABLES_ARGUMENTS_NOT_PLAYERS;
+    while ((token = strtok(NULL, " ")) != NULL) {
+        if (argument == MAX_TABLES_ARGUMENTS - 1) {
+            return false;
+        }
+        state->arguments[argument++] = token;
+    }
+    state->arguments[argument] = NULL;
+    return argument > TABLES_ARGUMENTS_NOT_PLAYERS + 1;
+}
+
+/**
+* Starts stlucia-tables on the next queued batch, reading the results from
+* its standard output. The batch fails if it cannot be started.
+*   - state, the worker
+*/
+void start_batch(WorkerState* state) {
+    state->running = state->queued[0];
+    memmove(state->queued, state->queued + 1,
+            --state->numberQueued * sizeof(WorkerBatch));
+    state->turns = 0;
+    sprintf(state->games, "%d", state->running.count);
+    int resultsPipe[PIPE_SIZE];
+    if (pipe(resultsPipe) != 0) {
+        send_line(&state->coordinator, "%s %d", FAILED_MESSAGE,
+                state->running.number);
+        return;
+    }
+    state->pid = fork();
+    if (state->pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        close(resultsPipe[PIPE_OUTPUT]);
+        dup2(resultsPipe[PIPE_INPUT], STDOUT_FILENO);
+        char firstGame[MAX_NUMBER_STRING_SIZE];
+        sprintf(firstGame, "%d", state->running.first);
+        setenv(FIRST_GAME_VARIABLE, firstGame, 1);
+        execvp(state->arguments[0], state->arguments);
+        _exit(1);
+    }
+    close(resultsPipe[PIPE_INPUT]);
+    if (state->pid < 0) {
+        close(resultsPipe[PIPE_OUTPUT]);
+        send_line(&state->coordinator, "%s %d", FAILED_MESSAGE,
+                state->running.number);
+        return;
+    }
+    open_connection(&state->results, resultsPipe[PIPE_OUTPUT]);
+}
+
+/**
+* Finishes the running batch once stlucia-tables has closed its output,
+* reporting it done, or failed if stlucia-tables did not exit normally.
+*   - state, the worker
+*/
+void finish_batch(WorkerState* state) {
+    close_connection(&state->results);
+    int status;
+    while (waitpid(state->pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    state->pid = -1;
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        send_line(&state->coordinator, "%s %d %lld", DONE_MESSAGE,
+                state->running.number, state->turns);
+    } else {
+        send_line(&state->coordinator, "%s %d", FAILED_MESSAGE,
+                state->running.number);
+    }
+}
+
+/**
+* Forwards the results stlucia-tables has printed to the coordinator, and
+* finishes the batch when it has printed everything.
+*   - state, the worker
+*/
+void read_results(WorkerState* state) {
+    bool open = fill_connection(&state->results);
+    char line[TOURNAMENT_LINE_LENGTH];
+    while (next_line(&state->results, line)) {
+        long long turns;
+        int games;
+        if (strncmp(line, GAME_MESSAGE " ", strlen(GAME_MESSAGE) + 1) == 0) {
+            send_line(&state->coordinator, "%s", line);
+        } else if (sscanf(line, "Played %d games, %lld turns", &games,
+                &turns) == 2) {
+            state->turns = turns;
+        }
+    }
+    if (!open) {
+        finish_batch(state);
+    }
+}
+
+/**
+* Gives a queued batch back to the coordinator for another worker, unless
+* it has already been started.
+*   - state, the worker
+*   - batchNumber, the batch to give up
+*/
+void give_up_batch(WorkerState* state, int batchNumber) {
+    for (int i = 0; i < state->numberQueued; i++) {
+        if (state->queued[i].number == batchNumber) {
+            memmove(state->queued + i, state->queued + i + 1,
+                    (state->numberQueued - i - 1) * sizeof(WorkerBatch));
+            state->numberQueued--;
+            send_line(&state->coordinator, "%s %d", STOLEN_MESSAGE,
+                    batchNumber);
+            return;
+        }
+    }
+    send_line(&state->coordinator, "%s %d", KEPT_MESSAGE, batchNumber);
+}
+
+/**
+* Handles a line from the coordinator.
+*   - state, the worker
+*   - line, the line
+*/
+void handle_coordinator_line(WorkerState* state, char* line) {
+    WorkerBatch batch;
+    int batchNumber;
+    if (strcmp(line, SHUTDOWN_MESSAGE) == 0) {
+        stop_worker(state, SUCCESS);
+    } else if (sscanf(line, BATCH_MESSAGE " %d %d %d", &batch.number,
+            &batch.first, &batch.count) == 3) {
+        if (state->numberQueued == MAX_QUEUED_BATCHES || batch.first < 0 ||
+                batch.count <= 0) {
+            stop_worker(state, INVALID_MESSAGE);
+        }
+        state->queued[state->numberQueued++] = batch;
+    } else if (sscanf(line, STEAL_MESSAGE " %d", &batchNumber) == 1) {
+        give_up_batch(state, batchNumber);
+    } else {
+        stop_worker(state, INVALID_MESSAGE);
+    }
+}
+
+/**
+* Plays the batches the coordinator deals, one at a time, until it shuts
+* the worker down, starting with any that arrived with the job.
+*   - state, the worker
+*/
+void run_worker(WorkerState* state) {
+    struct pollfd polls[PIPE_SIZE];
+    char line[TOURNAMENT_LINE_LENGTH];
+    while (next_line(&state->coordinator, line)) {
+        handle_coordinator_line(state, line);
+    }
+    while (true) {
+        if (state->pid < 0 && state->numberQueued > 0) {
+            start_batch(state);
+            continue;
+        }
+        polls[0].fd = state->coordinator.fd;
+        polls[0].events = POLLIN;
+        polls[0].revents = 0;
+        polls[1].fd = state->pid > 0 ? state->results.fd : -1;
+        polls[1].events = POLLIN;
+        polls[1].revents = 0;
+        if (poll(polls, PIPE_SIZE, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            stop_worker(state, COORDINATOR_LOST);
+        }
+        if (polls[1].revents != 0) {
+            read_results(state);
+        }
+        if (polls[0].revents != 0) {
+            if (!fill_connection(&state->coordinator)) {
+                stop_worker(state, COORDINATOR_LOST);
+            }
+            while (next_line(&state->coordinator, line)) {
+                handle_coordinator_line(state, line);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    struct sigaction sigpipe;
+    memset(&sigpipe, 0, sizeof(sigpipe));
+    sigpipe.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sigpipe, 0);
+
+    if (argc < WORKER_MIN_ARGS || argc > WORKER_MAX_ARGS) {
+        exit_program(INVALID_ARGUMENTS);
+    }
+    static WorkerState state;
+    state.pid = -1;
+    state.results.fd = -1;
+    state.arguments[0] = argc == WORKER_MAX_ARGS ?
+            argv[WORKER_TABLES_ARGUMENT_INDEX] : DEFAULT_TABLES_PROGRAM;
+    int fd = connect_to(argv[WORKER_HOST_ARGUMENT_INDEX],
+            argv[WORKER_PORT_ARGUMENT_INDEX]);
+    if (fd < 0) {
+        exit_program(CONNECT_ERROR);
+    }
+    open_connection(&state.coordinator, fd);
+
+    char line[TOURNAMENT_LINE_LENGTH];
+    while (!next_line(&state.coordinator, line)) {
+        if (!fill_connection(&state.coordinator)) {
+            exit_program(COORDINATOR_LOST);
+        }
+    }
+    if (!read_job(&state, line)) {
+        exit_program(INVALID_MESSAGE);
+    }
+    run_worker(&state);
+    return 0;
+}